@@ -0,0 +1,60 @@
+import org.apache.tools.ant.taskdefs.condition.Os
+
+// JMH benchmarks for the native bridges. Not published.
+//
+// Linux: run through run-linux.sh, which starts a private Xvfb display and a
+// private session bus hosting the fake settings portal; the window benchmarks
+// launch the stub window manager themselves. Results are written as JMH JSON,
+// to build/results/jmh/results.json or -PjmhResults=<file>, for diffing releases.
+plugins {
+    java
+    alias(libs.plugins.jmh)
+}
+
+dependencies {
+    jmhImplementation(project(":core-runtime"))
+    jmhImplementation(project(":darkmode-detector"))
+    jmhImplementation(project(":decorated-window-jni"))
+    jmhImplementation(project(":linux-hidpi"))
+}
+
+java {
+    sourceCompatibility = JavaVersion.VERSION_11
+    targetCompatibility = JavaVersion.VERSION_11
+}
+
+val buildStandIns by tasks.registering(Exec::class) {
+    description = "Compiles the stub EWMH window manager and fake settings portal used by the Linux benchmarks"
+    group = "build"
+    val nativeDir = file("src/main/native/linux")
+    onlyIf { Os.isFamily(Os.FAMILY_UNIX) && !Os.isFamily(Os.FAMILY_MAC) }
+    inputs.dir(nativeDir)
+    outputs.file(layout.buildDirectory.file("native/nucleus_stub_wm"))
+    outputs.file(layout.buildDirectory.file("native/nucleus_fake_portal"))
+    workingDir(nativeDir)
+    commandLine("bash", "build.sh")
+}
+
+jmh {
+    jmhVersion.set(libs.versions.jmh)
+    resultFormat.set("JSON")
+    resultsFile.set(
+        providers
+            .gradleProperty("jmhResults")
+            .map { layout.projectDirectory.file(it) }
+            .orElse(layout.buildDirectory.file("results/jmh/results.json")),
+    )
+    // Select benchmarks by regex: ./gradlew :benchmarks:jmh -PjmhIncludes=WindowInteraction
+    providers.gradleProperty("jmhIncludes").orNull?.let { includes.add(it) }
+    jvmArgsAppend.add(
+        "-Dnucleus.bench.stubWm=" +
+            layout.buildDirectory
+                .file("native/nucleus_stub_wm")
+                .get()
+                .asFile.absolutePath,
+    )
+}
+
+tasks.named("jmh") {
+    dependsOn(buildStandIns)
+}
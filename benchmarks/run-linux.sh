@@ -0,0 +1,71 @@
+#!/bin/bash
+# Runs the benchmarks on a private Xvfb display and a private session bus that
+# only hosts the fake settings portal, so results don't depend on the desktop
+# session (its window manager, portal or settings) of the machine running them.
+#
+# Prerequisites: Xvfb, dbus-daemon, gcc, libX11-dev, libdbus-1-dev, a JDK.
+# Usage: benchmarks/run-linux.sh [extra Gradle arguments]
+#   e.g. benchmarks/run-linux.sh -PjmhIncludes=WindowInteraction
+#        benchmarks/run-linux.sh -PjmhResults=build/results/jmh/1.4.0.json
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$SCRIPT_DIR/.."
+
+# First free display number from :99 up
+DISPLAY_NUMBER=99
+while [ -e "/tmp/.X${DISPLAY_NUMBER}-lock" ] || [ -e "/tmp/.X11-unix/X${DISPLAY_NUMBER}" ]; do
+    DISPLAY_NUMBER=$((DISPLAY_NUMBER + 1))
+done
+
+# Stand-ins (stub window manager, fake portal)
+bash "$SCRIPT_DIR/src/main/native/linux/build.sh"
+
+RUN_DIR="$(mktemp -d)"
+XVFB_PID=""
+BUS_PID=""
+PORTAL_PID=""
+cleanup() {
+    for pid in "$PORTAL_PID" "$BUS_PID" "$XVFB_PID"; do
+        [ -n "$pid" ] && kill "$pid" 2>/dev/null || true
+    done
+    rm -rf "$RUN_DIR"
+}
+trap cleanup EXIT
+
+Xvfb ":$DISPLAY_NUMBER" -screen 0 1920x1080x24 -nolisten tcp &
+XVFB_PID=$!
+
+# Wait for the server socket
+for _ in $(seq 1 50); do
+    [ -e "/tmp/.X11-unix/X${DISPLAY_NUMBER}" ] && break
+    sleep 0.1
+done
+if [ ! -e "/tmp/.X11-unix/X${DISPLAY_NUMBER}" ]; then
+    echo "ERROR: Xvfb did not start on :$DISPLAY_NUMBER" >&2
+    exit 1
+fi
+
+export DISPLAY=":$DISPLAY_NUMBER"
+
+# Private session bus with the fake org.freedesktop.portal.Settings on it
+dbus-daemon --session --address="unix:path=$RUN_DIR/bus" --fork \
+    --print-address=3 --print-pid=4 3>"$RUN_DIR/bus.address" 4>"$RUN_DIR/bus.pid"
+BUS_PID="$(cat "$RUN_DIR/bus.pid")"
+DBUS_SESSION_BUS_ADDRESS="$(head -n 1 "$RUN_DIR/bus.address")"
+export DBUS_SESSION_BUS_ADDRESS
+
+mkfifo "$RUN_DIR/portal.out"
+"$SCRIPT_DIR/build/native/nucleus_fake_portal" > "$RUN_DIR/portal.out" &
+PORTAL_PID=$!
+if ! read -r -t 5 READY < "$RUN_DIR/portal.out" || [ "$READY" != "READY" ]; then
+    echo "ERROR: the fake portal did not start" >&2
+    exit 1
+fi
+
+echo "Running benchmarks on DISPLAY=$DISPLAY, DBUS_SESSION_BUS_ADDRESS=$DBUS_SESSION_BUS_ADDRESS"
+
+cd "$ROOT_DIR"
+./gradlew :benchmarks:jmh "$@"
+echo "Results (JMH JSON): benchmarks/build/results/jmh/"
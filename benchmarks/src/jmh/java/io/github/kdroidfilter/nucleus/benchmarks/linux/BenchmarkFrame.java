@@ -0,0 +1,66 @@
+package io.github.kdroidfilter.nucleus.benchmarks.linux;
+
+import java.awt.EventQueue;
+import java.awt.GraphicsEnvironment;
+import java.awt.Point;
+import java.awt.Toolkit;
+import javax.swing.JFrame;
+
+/**
+ * An undecorated frame shown under {@link StubWindowManager}, for the window
+ * benchmarks. Does not touch {@code JniLinuxWindowBridge}, so cold-start
+ * benchmarks can load the bridge in their first measured call.
+ */
+final class BenchmarkFrame implements AutoCloseable {
+
+    private static final long SHOW_TIMEOUT_MILLIS = 5000;
+
+    final StubWindowManager wm;
+    final JFrame frame;
+    /** A point inside the frame, in root coordinates. */
+    final int pressX;
+    final int pressY;
+
+    private BenchmarkFrame(StubWindowManager wm, JFrame frame, int pressX, int pressY) {
+        this.wm = wm;
+        this.frame = frame;
+        this.pressX = pressX;
+        this.pressY = pressY;
+    }
+
+    static BenchmarkFrame show() throws Exception {
+        if (GraphicsEnvironment.isHeadless()) {
+            throw new IllegalStateException("No display: run benchmarks/run-linux.sh");
+        }
+
+        // The WM must own the display before the frame is mapped
+        StubWindowManager wm = StubWindowManager.start();
+
+        JFrame[] created = new JFrame[1];
+        EventQueue.invokeAndWait(() -> {
+            JFrame frame = new JFrame("nucleus-benchmark");
+            frame.setUndecorated(true);
+            frame.setBounds(100, 100, 640, 400);
+            frame.setVisible(true);
+            created[0] = frame;
+        });
+        JFrame frame = created[0];
+        long deadline = System.currentTimeMillis() + SHOW_TIMEOUT_MILLIS;
+        while (!frame.isShowing()) {
+            if (System.currentTimeMillis() > deadline) {
+                throw new IllegalStateException("Benchmark frame was never shown");
+            }
+            Thread.sleep(10);
+        }
+        Toolkit.getDefaultToolkit().sync();
+
+        Point origin = frame.getLocationOnScreen();
+        return new BenchmarkFrame(wm, frame, origin.x + frame.getWidth() / 2, origin.y + 10);
+    }
+
+    @Override
+    public void close() throws Exception {
+        EventQueue.invokeAndWait(frame::dispose);
+        wm.close();
+    }
+}
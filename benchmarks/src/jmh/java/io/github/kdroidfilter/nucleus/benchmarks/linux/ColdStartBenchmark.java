@@ -0,0 +1,77 @@
+package io.github.kdroidfilter.nucleus.benchmarks.linux;
+
+import io.github.kdroidfilter.nucleus.darkmodedetector.linux.NativeLinuxBridge;
+import io.github.kdroidfilter.nucleus.hidpi.HiDpiLinuxBridge;
+import io.github.kdroidfilter.nucleus.window.utils.linux.JniLinuxWindowBridge;
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+/**
+ * The first call of each entry point in a fresh JVM: bridge class
+ * initialisation, library load and the library's own start-up work (D-Bus
+ * connection, X connections and atoms, background probes), as an application
+ * pays it once at startup. Each fork measures one call; JMH reports the spread
+ * across forks.
+ *
+ * <p>Libraries come from the per-user native library cache after the first
+ * fork, as they do from an application's second launch on.
+ */
+@State(Scope.Benchmark)
+@BenchmarkMode(Mode.SingleShotTime)
+@OutputTimeUnit(TimeUnit.MICROSECONDS)
+@Warmup(iterations = 0)
+@Measurement(iterations = 1)
+@Fork(10)
+public class ColdStartBenchmark {
+
+    /** Frame and WM for the window entry points, set up without loading the bridge. */
+    @State(Scope.Benchmark)
+    public static class Desktop {
+        BenchmarkFrame frame;
+
+        @Setup(Level.Trial)
+        public void show() throws Exception {
+            frame = BenchmarkFrame.show();
+        }
+
+        @TearDown(Level.Trial)
+        public void close() throws Exception {
+            frame.close();
+        }
+    }
+
+    @Benchmark
+    public boolean isDark() {
+        return NativeLinuxBridge.nativeIsDark();
+    }
+
+    @Benchmark
+    public double getScaleFactor() {
+        return HiDpiLinuxBridge.nativeGetScaleFactor();
+    }
+
+    @Benchmark
+    public boolean isWmMoveResizeSupported(Desktop desktop) {
+        return JniLinuxWindowBridge.nativeIsWmMoveResizeSupported(desktop.frame.frame);
+    }
+
+    @Benchmark
+    public boolean startWindowMove(Desktop desktop) {
+        return JniLinuxWindowBridge.nativeStartWindowMove(
+            desktop.frame.frame,
+            desktop.frame.pressX,
+            desktop.frame.pressY,
+            WindowInteractionBenchmark.BUTTON_LEFT);
+    }
+}
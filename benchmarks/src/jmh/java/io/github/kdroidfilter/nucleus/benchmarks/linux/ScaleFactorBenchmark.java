@@ -0,0 +1,43 @@
+package io.github.kdroidfilter.nucleus.benchmarks.linux;
+
+import io.github.kdroidfilter.nucleus.hidpi.HiDpiLinuxBridge;
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.Warmup;
+
+/**
+ * Throughput and latency of {@code HiDpiLinuxBridge.nativeGetScaleFactor} once
+ * the background probes have finished (run-linux.sh's Xvfb display), i.e. every
+ * call after the first. The first call is in {@link ColdStartBenchmark}.
+ */
+@State(Scope.Benchmark)
+@Warmup(iterations = 3, time = 2)
+@Measurement(iterations = 5, time = 2)
+@Fork(1)
+public class ScaleFactorBenchmark {
+
+    @Setup(Level.Trial)
+    public void setUp() {
+        if (!HiDpiLinuxBridge.INSTANCE.isLoaded()) {
+            throw new IllegalStateException("libnucleus_linux_hidpi_jni is not available");
+        }
+        // Waits for the probes started when the library was loaded
+        HiDpiLinuxBridge.nativeGetScaleFactor();
+    }
+
+    @Benchmark
+    @BenchmarkMode({Mode.Throughput, Mode.SampleTime})
+    @OutputTimeUnit(TimeUnit.NANOSECONDS)
+    public double getScaleFactor() {
+        return HiDpiLinuxBridge.nativeGetScaleFactor();
+    }
+}
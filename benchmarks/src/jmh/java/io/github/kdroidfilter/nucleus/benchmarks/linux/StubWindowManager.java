@@ -0,0 +1,119 @@
+package io.github.kdroidfilter.nucleus.benchmarks.linux;
+
+import java.io.BufferedReader;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.nio.charset.StandardCharsets;
+import java.nio.file.Files;
+import java.nio.file.Paths;
+import java.util.concurrent.ArrayBlockingQueue;
+import java.util.concurrent.BlockingQueue;
+import java.util.concurrent.CountDownLatch;
+import java.util.concurrent.TimeUnit;
+
+/**
+ * Runs {@code nucleus_stub_wm} (see src/main/native/linux) on the current DISPLAY
+ * and collects the ClientMessages it reports.
+ */
+final class StubWindowManager implements AutoCloseable {
+
+    /** One ClientMessage received by the stub WM. */
+    static final class ClientMessage {
+        final String type;
+        final long window;
+        final long[] data;
+        /** CLOCK_MONOTONIC at arrival: comparable with System.nanoTime(). */
+        final long arrivedNanos;
+
+        ClientMessage(String type, long window, long[] data, long arrivedNanos) {
+            this.type = type;
+            this.window = window;
+            this.data = data;
+            this.arrivedNanos = arrivedNanos;
+        }
+    }
+
+    private static final int QUEUE_CAPACITY = 4096;
+    private static final long READY_TIMEOUT_SECONDS = 5;
+
+    private final Process process;
+    private final BlockingQueue<ClientMessage> messages = new ArrayBlockingQueue<>(QUEUE_CAPACITY);
+    private final CountDownLatch ready = new CountDownLatch(1);
+
+    private StubWindowManager(Process process) {
+        this.process = process;
+        Thread reader = new Thread(this::readOutput, "nucleus-stub-wm-reader");
+        reader.setDaemon(true);
+        reader.start();
+    }
+
+    static StubWindowManager start() throws IOException, InterruptedException {
+        String path = System.getProperty("nucleus.bench.stubWm");
+        if (path == null || !Files.isExecutable(Paths.get(path))) {
+            throw new IllegalStateException(
+                "Stub window manager not found at " + path + " (built by :benchmarks:buildStandIns)");
+        }
+        Process process = new ProcessBuilder(path)
+            .redirectError(ProcessBuilder.Redirect.INHERIT)
+            .start();
+        StubWindowManager wm = new StubWindowManager(process);
+        if (!wm.ready.await(READY_TIMEOUT_SECONDS, TimeUnit.SECONDS)) {
+            wm.close();
+            throw new IllegalStateException("Stub window manager did not start (is another WM running?)");
+        }
+        return wm;
+    }
+
+    private void readOutput() {
+        try (BufferedReader reader = new BufferedReader(
+            new InputStreamReader(process.getInputStream(), StandardCharsets.US_ASCII))) {
+            String line;
+            while ((line = reader.readLine()) != null) {
+                if (line.equals("READY")) {
+                    ready.countDown();
+                } else if (line.startsWith("CM ")) {
+                    // Dropped when full: only benchmarks that don't wait for messages fill it
+                    messages.offer(parse(line));
+                }
+            }
+        } catch (IOException ignored) {
+            // Process destroyed
+        }
+    }
+
+    // CM <type> <window> <l0> <l1> <l2> <l3> <l4> <nanos>
+    private static ClientMessage parse(String line) {
+        String[] fields = line.split(" ");
+        long[] data = new long[5];
+        for (int i = 0; i < data.length; i++) {
+            data[i] = Long.parseLong(fields[3 + i]);
+        }
+        return new ClientMessage(
+            fields[1],
+            Long.decode(fields[2]),
+            data,
+            Long.parseLong(fields[8]));
+    }
+
+    /** Waits for the next ClientMessage of the given type, skipping others; null on timeout. */
+    ClientMessage await(String type, long timeoutMillis) throws InterruptedException {
+        long deadline = System.nanoTime() + TimeUnit.MILLISECONDS.toNanos(timeoutMillis);
+        while (true) {
+            long remaining = deadline - System.nanoTime();
+            if (remaining <= 0) return null;
+            ClientMessage message = messages.poll(remaining, TimeUnit.NANOSECONDS);
+            if (message == null) return null;
+            if (message.type.equals(type)) return message;
+        }
+    }
+
+    void clear() {
+        messages.clear();
+    }
+
+    @Override
+    public void close() throws InterruptedException {
+        process.destroy();
+        process.waitFor(READY_TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+}
@@ -0,0 +1,66 @@
+package io.github.kdroidfilter.nucleus.benchmarks.linux;
+
+import io.github.kdroidfilter.nucleus.darkmodedetector.linux.NativeLinuxBridge;
+import java.util.concurrent.TimeUnit;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Param;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+/**
+ * Throughput and latency of {@code NativeLinuxBridge.nativeIsDark}, answered by
+ * {@code nucleus_fake_portal} on the private session bus of run-linux.sh.
+ *
+ * <ul>
+ *   <li>{@code observing = false}: one blocking portal Read per call.</li>
+ *   <li>{@code observing = true}: the value the monitor thread keeps current.</li>
+ * </ul>
+ */
+@State(Scope.Benchmark)
+@Warmup(iterations = 3, time = 2)
+@Measurement(iterations = 5, time = 2)
+@Fork(1)
+public class ThemeBenchmark {
+
+    @Param({"false", "true"})
+    public boolean observing;
+
+    @Setup(Level.Trial)
+    public void setUp() {
+        if (System.getenv("DBUS_SESSION_BUS_ADDRESS") == null) {
+            throw new IllegalStateException("No session bus: run benchmarks/run-linux.sh");
+        }
+        if (!NativeLinuxBridge.INSTANCE.isLoaded()) {
+            throw new IllegalStateException("libnucleus_linux_theme is not available");
+        }
+        if (observing) {
+            NativeLinuxBridge.nativeStartObserving();
+            if (NativeLinuxBridge.nativeGetSettings() == null) {
+                throw new IllegalStateException("The settings portal is not observed");
+            }
+        }
+    }
+
+    @TearDown(Level.Trial)
+    public void tearDown() {
+        if (observing) {
+            NativeLinuxBridge.nativeStopObserving();
+        }
+    }
+
+    @Benchmark
+    @BenchmarkMode({Mode.Throughput, Mode.SampleTime})
+    @OutputTimeUnit(TimeUnit.MICROSECONDS)
+    public boolean isDark() {
+        return NativeLinuxBridge.nativeIsDark();
+    }
+}
@@ -0,0 +1,194 @@
+package io.github.kdroidfilter.nucleus.benchmarks.linux;
+
+import io.github.kdroidfilter.nucleus.window.utils.linux.JniLinuxWindowBridge;
+import java.util.Arrays;
+import java.util.concurrent.TimeUnit;
+import javax.swing.JFrame;
+import org.openjdk.jmh.annotations.AuxCounters;
+import org.openjdk.jmh.annotations.Benchmark;
+import org.openjdk.jmh.annotations.BenchmarkMode;
+import org.openjdk.jmh.annotations.Fork;
+import org.openjdk.jmh.annotations.Level;
+import org.openjdk.jmh.annotations.Measurement;
+import org.openjdk.jmh.annotations.Mode;
+import org.openjdk.jmh.annotations.OutputTimeUnit;
+import org.openjdk.jmh.annotations.Scope;
+import org.openjdk.jmh.annotations.Setup;
+import org.openjdk.jmh.annotations.State;
+import org.openjdk.jmh.annotations.TearDown;
+import org.openjdk.jmh.annotations.Warmup;
+
+/**
+ * Latency of the Linux window commands in {@code JniLinuxWindowBridge}, measured
+ * against {@code nucleus_stub_wm} on a private Xvfb display (run-linux.sh).
+ *
+ * <ul>
+ *   <li>{@code *ToClientMessage}: press to ClientMessage arrival at the WM. JMH
+ *       reports p50/p99 of the round trip (including the stub's stdout pipe);
+ *       the WM-stamped one-way latency is printed after each iteration.</li>
+ *   <li>{@code startWindowMove}, {@code setMaximized}: cost of the call alone, with
+ *       the AWT lock hold count/average/max as secondary results.</li>
+ *   <li>{@code isWmMoveResizeSupported}: the capability snapshot read.</li>
+ * </ul>
+ *
+ * <p>First-call costs (library load included) are in {@link ColdStartBenchmark}.
+ */
+@State(Scope.Benchmark)
+@Warmup(iterations = 3, time = 2)
+@Measurement(iterations = 5, time = 2)
+@Fork(1)
+public class WindowInteractionBenchmark {
+
+    private static final long MESSAGE_TIMEOUT_MILLIS = 1000;
+    static final int BUTTON_LEFT = 1;
+
+    private BenchmarkFrame desktop;
+    private StubWindowManager wm;
+    private JFrame frame;
+    private int pressX;
+    private int pressY;
+    private boolean maximize;
+    private final LatencyRecorder arrival = new LatencyRecorder();
+
+    /** AWT lock usage by the bridge during an iteration (read from its native counters). */
+    @State(Scope.Thread)
+    @AuxCounters(AuxCounters.Type.EVENTS)
+    public static class AwtLockCounters {
+        @Setup(Level.Iteration)
+        public void reset() {
+            JniLinuxWindowBridge.nativeResetAwtLockStats();
+        }
+
+        public long awtLockHolds() {
+            return JniLinuxWindowBridge.nativeGetAwtLockStats()[0];
+        }
+
+        public double awtLockHoldAvgNanos() {
+            long[] stats = JniLinuxWindowBridge.nativeGetAwtLockStats();
+            return stats[0] == 0 ? 0.0 : (double) stats[1] / stats[0];
+        }
+
+        public long awtLockHoldMaxNanos() {
+            return JniLinuxWindowBridge.nativeGetAwtLockStats()[2];
+        }
+    }
+
+    @Setup(Level.Trial)
+    public void setUp() throws Exception {
+        desktop = BenchmarkFrame.show();
+        if (!JniLinuxWindowBridge.INSTANCE.isLoaded()) {
+            desktop.close();
+            throw new IllegalStateException("libnucleus_linux_jni is not available");
+        }
+        wm = desktop.wm;
+        frame = desktop.frame;
+        pressX = desktop.pressX;
+        pressY = desktop.pressY;
+    }
+
+    @Setup(Level.Iteration)
+    public void clearMessages() {
+        wm.clear();
+        arrival.reset();
+    }
+
+    @TearDown(Level.Iteration)
+    public void reportArrival() {
+        if (arrival.count() > 0) {
+            System.out.printf(
+                "%nWM-stamped press -> ClientMessage: p50 %.1f us, p99 %.1f us (n = %d)%n",
+                arrival.percentile(0.50) / 1000.0,
+                arrival.percentile(0.99) / 1000.0,
+                arrival.count());
+        }
+    }
+
+    @TearDown(Level.Trial)
+    public void tearDown() throws Exception {
+        desktop.close();
+    }
+
+    private StubWindowManager.ClientMessage awaitMessage(String type, long pressNanos) throws InterruptedException {
+        StubWindowManager.ClientMessage message = wm.await(type, MESSAGE_TIMEOUT_MILLIS);
+        if (message == null) {
+            throw new IllegalStateException(type + " never reached the window manager");
+        }
+        arrival.record(message.arrivedNanos - pressNanos);
+        return message;
+    }
+
+    @Benchmark
+    @BenchmarkMode(Mode.SampleTime)
+    @OutputTimeUnit(TimeUnit.MICROSECONDS)
+    public StubWindowManager.ClientMessage startWindowMoveToClientMessage() throws InterruptedException {
+        long press = System.nanoTime();
+        JniLinuxWindowBridge.nativeStartWindowMove(frame, pressX, pressY, BUTTON_LEFT);
+        return awaitMessage("_NET_WM_MOVERESIZE", press);
+    }
+
+    @Benchmark
+    @BenchmarkMode(Mode.SampleTime)
+    @OutputTimeUnit(TimeUnit.MICROSECONDS)
+    public StubWindowManager.ClientMessage setMaximizedToClientMessage() throws InterruptedException {
+        maximize = !maximize;
+        long press = System.nanoTime();
+        JniLinuxWindowBridge.nativeSetWindowState(
+            frame,
+            maximize ? JniLinuxWindowBridge.STATE_ACTION_ADD : JniLinuxWindowBridge.STATE_ACTION_REMOVE,
+            JniLinuxWindowBridge.STATE_MAXIMIZED_VERT,
+            JniLinuxWindowBridge.STATE_MAXIMIZED_HORZ);
+        return awaitMessage("_NET_WM_STATE", press);
+    }
+
+    @Benchmark
+    @BenchmarkMode({Mode.Throughput, Mode.AverageTime})
+    @OutputTimeUnit(TimeUnit.MICROSECONDS)
+    public boolean startWindowMove(AwtLockCounters counters) {
+        return JniLinuxWindowBridge.nativeStartWindowMove(frame, pressX, pressY, BUTTON_LEFT);
+    }
+
+    @Benchmark
+    @BenchmarkMode(Mode.AverageTime)
+    @OutputTimeUnit(TimeUnit.MICROSECONDS)
+    public boolean setMaximized(AwtLockCounters counters) {
+        maximize = !maximize;
+        return JniLinuxWindowBridge.nativeSetWindowState(
+            frame,
+            maximize ? JniLinuxWindowBridge.STATE_ACTION_ADD : JniLinuxWindowBridge.STATE_ACTION_REMOVE,
+            JniLinuxWindowBridge.STATE_MAXIMIZED_VERT,
+            JniLinuxWindowBridge.STATE_MAXIMIZED_HORZ);
+    }
+
+    @Benchmark
+    @BenchmarkMode({Mode.Throughput, Mode.AverageTime})
+    @OutputTimeUnit(TimeUnit.NANOSECONDS)
+    public boolean isWmMoveResizeSupported() {
+        return JniLinuxWindowBridge.nativeIsWmMoveResizeSupported(frame);
+    }
+
+    /** Growable sample buffer for the WM-stamped latencies of one iteration. */
+    static final class LatencyRecorder {
+        private long[] samples = new long[1024];
+        private int count;
+
+        void record(long nanos) {
+            if (count == samples.length) samples = Arrays.copyOf(samples, count * 2);
+            samples[count++] = nanos;
+        }
+
+        int count() {
+            return count;
+        }
+
+        void reset() {
+            count = 0;
+        }
+
+        double percentile(double p) {
+            long[] sorted = Arrays.copyOf(samples, count);
+            Arrays.sort(sorted);
+            int index = (int) Math.min(count - 1, Math.max(0, Math.ceil(p * count) - 1));
+            return sorted[index];
+        }
+    }
+}
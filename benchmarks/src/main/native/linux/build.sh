@@ -0,0 +1,21 @@
+#!/bin/bash
+# Compiles the stand-ins the Linux benchmarks run against: the stub EWMH window
+# manager and the fake org.freedesktop.portal.Settings service.
+# The binaries are build artifacts (not shipped): they go to benchmarks/build/native.
+#
+# Prerequisites: gcc, libX11-dev (or libx11-dev), libdbus-1-dev.
+# Usage: ./build.sh
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+OUT_DIR="$SCRIPT_DIR/../../../../build/native"
+
+mkdir -p "$OUT_DIR"
+gcc -O2 -Wall -Wextra -Wno-unused-parameter \
+    -o "$OUT_DIR/nucleus_stub_wm" "$SCRIPT_DIR/nucleus_stub_wm.c" -lX11
+gcc -O2 -Wall -Wextra -Wno-unused-parameter \
+    -o "$OUT_DIR/nucleus_fake_portal" "$SCRIPT_DIR/nucleus_fake_portal.c" \
+    $(pkg-config --cflags --libs dbus-1)
+echo "Built benchmark stand-ins:"
+ls -lh "$OUT_DIR/nucleus_stub_wm" "$OUT_DIR/nucleus_fake_portal"
@@ -0,0 +1,208 @@
+/**
+ * Minimal org.freedesktop.portal.Settings service for the Linux benchmarks.
+ *
+ * Owns org.freedesktop.portal.Desktop on the session bus (run-linux.sh starts
+ * a private dbus-daemon for it) and answers Read, ReadOne and ReadAll for the
+ * org.freedesktop.appearance namespace: color-scheme, accent-color, contrast
+ * and reduced-motion. Each reply is built from the current values, with no
+ * caching or artificial delay, so benchmarks measure the bridge and the bus.
+ * "READY" is printed on stdout once the bus name is owned.
+ *
+ * Usage: nucleus_fake_portal [initial color-scheme]
+ * Linked libraries: -ldbus-1
+ */
+
+#include <dbus/dbus.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *PORTAL_BUS    = "org.freedesktop.portal.Desktop";
+static const char *PORTAL_IFACE  = "org.freedesktop.portal.Settings";
+static const char *APPEARANCE_NS = "org.freedesktop.appearance";
+
+/* ------------------------------------------------------------------ */
+/*  Settings                                                           */
+/* ------------------------------------------------------------------ */
+static dbus_uint32_t g_colorScheme   = 0;
+static dbus_uint32_t g_contrast      = 0;
+static dbus_uint32_t g_reducedMotion = 0;
+static double        g_accent[3]     = { 0.21, 0.52, 0.89 };
+
+static const char *SETTING_KEYS[] = {
+    "color-scheme",
+    "accent-color",
+    "contrast",
+    "reduced-motion",
+};
+#define SETTING_COUNT (int)(sizeof(SETTING_KEYS) / sizeof(SETTING_KEYS[0]))
+
+static dbus_uint32_t *uintSetting(const char *key) {
+    if (strcmp(key, "color-scheme") == 0) return &g_colorScheme;
+    if (strcmp(key, "contrast") == 0) return &g_contrast;
+    if (strcmp(key, "reduced-motion") == 0) return &g_reducedMotion;
+    return NULL;
+}
+
+/* Appends the setting as a variant; 0 for an unknown key */
+static int appendSetting(DBusMessageIter *iter, const char *key) {
+    DBusMessageIter variant;
+    if (strcmp(key, "accent-color") == 0) {
+        DBusMessageIter rgb;
+        dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, "(ddd)", &variant);
+        dbus_message_iter_open_container(&variant, DBUS_TYPE_STRUCT, NULL, &rgb);
+        for (int i = 0; i < 3; i++) {
+            dbus_message_iter_append_basic(&rgb, DBUS_TYPE_DOUBLE, &g_accent[i]);
+        }
+        dbus_message_iter_close_container(&variant, &rgb);
+        dbus_message_iter_close_container(iter, &variant);
+        return 1;
+    }
+
+    dbus_uint32_t *value = uintSetting(key);
+    if (!value) return 0;
+    dbus_message_iter_open_container(iter, DBUS_TYPE_VARIANT, "u", &variant);
+    dbus_message_iter_append_basic(&variant, DBUS_TYPE_UINT32, value);
+    dbus_message_iter_close_container(iter, &variant);
+    return 1;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Method calls                                                       */
+/* ------------------------------------------------------------------ */
+static DBusMessage *notFound(DBusMessage *call) {
+    return dbus_message_new_error(call, "org.freedesktop.portal.Error.NotFound",
+                                  "Requested setting not found");
+}
+
+/* Read (deprecated: the value is wrapped in a second variant) and ReadOne */
+static DBusMessage *handleRead(DBusMessage *call, int nested) {
+    const char *ns = NULL;
+    const char *key = NULL;
+    if (!dbus_message_get_args(call, NULL, DBUS_TYPE_STRING, &ns, DBUS_TYPE_STRING, &key,
+                               DBUS_TYPE_INVALID) ||
+        strcmp(ns, APPEARANCE_NS) != 0) {
+        return notFound(call);
+    }
+
+    DBusMessage *reply = dbus_message_new_method_return(call);
+    DBusMessageIter iter;
+    dbus_message_iter_init_append(reply, &iter);
+
+    int found;
+    if (nested) {
+        DBusMessageIter outer;
+        dbus_message_iter_open_container(&iter, DBUS_TYPE_VARIANT, "v", &outer);
+        found = appendSetting(&outer, key);
+        dbus_message_iter_close_container(&iter, &outer);
+    } else {
+        found = appendSetting(&iter, key);
+    }
+    if (!found) {
+        dbus_message_unref(reply);
+        return notFound(call);
+    }
+    return reply;
+}
+
+/* ReadAll(as namespaces): whether the filter includes the appearance namespace */
+static int namespaceRequested(DBusMessage *call) {
+    DBusMessageIter iter;
+    DBusMessageIter patterns;
+    if (!dbus_message_iter_init(call, &iter) ||
+        dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_ARRAY) {
+        return 1;
+    }
+    dbus_message_iter_recurse(&iter, &patterns);
+    if (dbus_message_iter_get_arg_type(&patterns) == DBUS_TYPE_INVALID) return 1;  /* [] = all */
+
+    while (dbus_message_iter_get_arg_type(&patterns) == DBUS_TYPE_STRING) {
+        const char *pattern = NULL;
+        dbus_message_iter_get_basic(&patterns, &pattern);
+        /* Exact names, or a prefix ending in '*' (org.freedesktop.*) */
+        size_t length = strlen(pattern);
+        if (strcmp(pattern, APPEARANCE_NS) == 0 ||
+            (length > 0 && pattern[length - 1] == '*' &&
+             strncmp(pattern, APPEARANCE_NS, length - 1) == 0)) {
+            return 1;
+        }
+        dbus_message_iter_next(&patterns);
+    }
+    return 0;
+}
+
+static DBusMessage *handleReadAll(DBusMessage *call) {
+    DBusMessage *reply = dbus_message_new_method_return(call);
+    DBusMessageIter iter;
+    DBusMessageIter namespaces;
+    dbus_message_iter_init_append(reply, &iter);
+    dbus_message_iter_open_container(&iter, DBUS_TYPE_ARRAY, "{sa{sv}}", &namespaces);
+
+    if (namespaceRequested(call)) {
+        DBusMessageIter entry;
+        DBusMessageIter settings;
+        dbus_message_iter_open_container(&namespaces, DBUS_TYPE_DICT_ENTRY, NULL, &entry);
+        dbus_message_iter_append_basic(&entry, DBUS_TYPE_STRING, &APPEARANCE_NS);
+        dbus_message_iter_open_container(&entry, DBUS_TYPE_ARRAY, "{sv}", &settings);
+        for (int i = 0; i < SETTING_COUNT; i++) {
+            DBusMessageIter setting;
+            dbus_message_iter_open_container(&settings, DBUS_TYPE_DICT_ENTRY, NULL, &setting);
+            dbus_message_iter_append_basic(&setting, DBUS_TYPE_STRING, &SETTING_KEYS[i]);
+            appendSetting(&setting, SETTING_KEYS[i]);
+            dbus_message_iter_close_container(&settings, &setting);
+        }
+        dbus_message_iter_close_container(&entry, &settings);
+        dbus_message_iter_close_container(&namespaces, &entry);
+    }
+
+    dbus_message_iter_close_container(&iter, &namespaces);
+    return reply;
+}
+
+static void handleMessage(DBusConnection *conn, DBusMessage *message) {
+    if (dbus_message_get_type(message) != DBUS_MESSAGE_TYPE_METHOD_CALL) return;
+
+    DBusMessage *reply;
+    if (dbus_message_is_method_call(message, PORTAL_IFACE, "Read")) {
+        reply = handleRead(message, 1);
+    } else if (dbus_message_is_method_call(message, PORTAL_IFACE, "ReadOne")) {
+        reply = handleRead(message, 0);
+    } else if (dbus_message_is_method_call(message, PORTAL_IFACE, "ReadAll")) {
+        reply = handleReadAll(message);
+    } else {
+        reply = dbus_message_new_error(message, DBUS_ERROR_UNKNOWN_METHOD, "Unknown method");
+    }
+    dbus_connection_send(conn, reply, NULL);
+    dbus_message_unref(reply);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) g_colorScheme = (dbus_uint32_t)strtoul(argv[1], NULL, 10);
+
+    DBusError err;
+    dbus_error_init(&err);
+    DBusConnection *conn = dbus_bus_get(DBUS_BUS_SESSION, &err);
+    if (!conn) {
+        fprintf(stderr, "nucleus_fake_portal: %s\n", err.message);
+        return 1;
+    }
+    int owner = dbus_bus_request_name(conn, PORTAL_BUS, DBUS_NAME_FLAG_DO_NOT_QUEUE, &err);
+    if (owner != DBUS_REQUEST_NAME_REPLY_PRIMARY_OWNER) {
+        fprintf(stderr, "nucleus_fake_portal: cannot own %s (is a portal running on this bus?)\n",
+                PORTAL_BUS);
+        return 1;
+    }
+    dbus_connection_set_exit_on_disconnect(conn, TRUE);
+
+    printf("READY\n");
+    fflush(stdout);
+
+    while (dbus_connection_read_write(conn, -1)) {
+        DBusMessage *message;
+        while ((message = dbus_connection_pop_message(conn)) != NULL) {
+            handleMessage(conn, message);
+            dbus_message_unref(message);
+        }
+    }
+    return 0;   /* bus gone */
+}
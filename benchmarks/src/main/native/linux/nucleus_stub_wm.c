@@ -0,0 +1,175 @@
+/**
+ * Minimal EWMH window manager for the Linux window-interaction benchmarks.
+ *
+ * Takes SubstructureRedirect on the root window, maps and configures
+ * clients exactly as they ask, and advertises the _NET_SUPPORTED atoms the
+ * JNI bridge probes for. It never moves, resizes or grabs anything itself:
+ * every ClientMessage it receives is reported on stdout, one line each,
+ *
+ *   CM <message type> <window> <l0> <l1> <l2> <l3> <l4> <monotonic nanos>
+ *
+ * stamped with CLOCK_MONOTONIC on arrival (the clock behind
+ * System.nanoTime() on Linux), so the harness can measure latency without
+ * counting the pipe. "READY" is printed once the WM owns the display.
+ *
+ * Linked libraries: -lX11
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+
+static const char *SUPPORTED_NAMES[] = {
+    "_NET_WM_MOVERESIZE",
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_ABOVE",
+    "_NET_FRAME_EXTENTS",
+    "_NET_WM_SYNC_REQUEST",
+    "_NET_WM_OPAQUE_REGION",
+    "_NET_WM_BYPASS_COMPOSITOR",
+    "_GTK_FRAME_EXTENTS",
+};
+#define SUPPORTED_COUNT (int)(sizeof(SUPPORTED_NAMES) / sizeof(SUPPORTED_NAMES[0]))
+
+/* ------------------------------------------------------------------ */
+/*  Atom name cache: keeps XGetAtomName round trips off the hot path   */
+/* ------------------------------------------------------------------ */
+#define NAME_CACHE_SIZE 32
+
+static Atom  g_nameAtoms[NAME_CACHE_SIZE];
+static char *g_names[NAME_CACHE_SIZE];
+
+static const char *atomName(Display *display, Atom atom) {
+    for (int i = 0; i < NAME_CACHE_SIZE; i++) {
+        if (g_nameAtoms[i] == atom) return g_names[i];
+    }
+    char *name = XGetAtomName(display, atom);
+    if (!name) return "?";
+    for (int i = 0; i < NAME_CACHE_SIZE; i++) {
+        if (g_nameAtoms[i] == None) {
+            g_nameAtoms[i] = atom;
+            g_names[i] = name;
+            return name;
+        }
+    }
+    return name;   /* cache full: leaked, the WM only lives for one run */
+}
+
+static long long monotonicNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Claiming the display                                               */
+/* ------------------------------------------------------------------ */
+static int g_otherWm = 0;
+
+static int detectOtherWm(Display *display, XErrorEvent *event) {
+    if (event->error_code == BadAccess) g_otherWm = 1;
+    return 0;
+}
+
+static int ignoreErrors(Display *display, XErrorEvent *event) {
+    /* Clients may vanish between a request and our reply to it */
+    return 0;
+}
+
+static void advertise(Display *display, Window root) {
+    Atom supported[SUPPORTED_COUNT];
+    XInternAtoms(display, (char **)SUPPORTED_NAMES, SUPPORTED_COUNT, False, supported);
+
+    Window check = XCreateSimpleWindow(display, root, -1, -1, 1, 1, 0, 0, 0);
+    Atom checkAtom = XInternAtom(display, "_NET_SUPPORTING_WM_CHECK", False);
+    Atom nameAtom = XInternAtom(display, "_NET_WM_NAME", False);
+    Atom utf8 = XInternAtom(display, "UTF8_STRING", False);
+    const char *name = "nucleus-stub-wm";
+
+    XChangeProperty(display, check, checkAtom, XA_WINDOW, 32, PropModeReplace,
+                    (unsigned char *)&check, 1);
+    XChangeProperty(display, check, nameAtom, utf8, 8, PropModeReplace,
+                    (const unsigned char *)name, (int)strlen(name));
+    XChangeProperty(display, root, checkAtom, XA_WINDOW, 32, PropModeReplace,
+                    (unsigned char *)&check, 1);
+    XChangeProperty(display, root, XInternAtom(display, "_NET_SUPPORTED", False),
+                    XA_ATOM, 32, PropModeReplace,
+                    (unsigned char *)supported, SUPPORTED_COUNT);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Event loop                                                         */
+/* ------------------------------------------------------------------ */
+static void handleConfigureRequest(Display *display, XConfigureRequestEvent *request) {
+    XWindowChanges changes;
+    changes.x = request->x;
+    changes.y = request->y;
+    changes.width = request->width;
+    changes.height = request->height;
+    changes.border_width = request->border_width;
+    changes.sibling = request->above;
+    changes.stack_mode = request->detail;
+    XConfigureWindow(display, request->window, (unsigned int)request->value_mask, &changes);
+}
+
+static void reportClientMessage(Display *display, XClientMessageEvent *message) {
+    long long arrived = monotonicNanos();
+    printf("CM %s 0x%lx %ld %ld %ld %ld %ld %lld\n",
+           atomName(display, message->message_type),
+           message->window,
+           message->data.l[0], message->data.l[1], message->data.l[2],
+           message->data.l[3], message->data.l[4],
+           arrived);
+    fflush(stdout);
+}
+
+int main(void) {
+    Display *display = XOpenDisplay(NULL);
+    if (!display) {
+        fprintf(stderr, "nucleus_stub_wm: cannot open display\n");
+        return 1;
+    }
+    Window root = DefaultRootWindow(display);
+
+    XSetErrorHandler(detectOtherWm);
+    XSelectInput(display, root,
+                 SubstructureRedirectMask | SubstructureNotifyMask | PropertyChangeMask);
+    XSync(display, False);
+    if (g_otherWm) {
+        fprintf(stderr, "nucleus_stub_wm: another window manager is running\n");
+        return 1;
+    }
+    XSetErrorHandler(ignoreErrors);
+
+    advertise(display, root);
+    XSync(display, False);
+    printf("READY\n");
+    fflush(stdout);
+
+    for (;;) {
+        XEvent event;
+        XNextEvent(display, &event);
+        switch (event.type) {
+        case MapRequest:
+            XMapWindow(display, event.xmaprequest.window);
+            XFlush(display);
+            break;
+        case ConfigureRequest:
+            handleConfigureRequest(display, &event.xconfigurerequest);
+            XFlush(display);
+            break;
+        case ClientMessage:
+            reportClientMessage(display, &event.xclient);
+            break;
+        default:
+            break;
+        }
+    }
+}
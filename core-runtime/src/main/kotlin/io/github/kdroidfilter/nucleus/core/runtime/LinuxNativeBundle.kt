@@ -0,0 +1,51 @@
+package io.github.kdroidfilter.nucleus.core.runtime
+
+/**
+ * The combined Linux library, `libnucleus_linux`, shipped by the optional
+ * `nucleus.linux-native` artifact: the theme, window and HiDPI bridges linked
+ * into one shared object that shares one X connection between them, so an
+ * app using all three loads and relocates one library instead of three.
+ *
+ * The library is loaded once, by the first bridge that asks for its own
+ * library. Each bridge's module is then initialised (its former `JNI_OnLoad`)
+ * when that bridge loads, exactly as with the separate libraries.
+ *
+ * Like any JNI library it is bound to one class loader, here core-runtime's:
+ * the bridges' native methods and the `FindClass` calls of the module
+ * initialisers only resolve there. It therefore only serves bridges loaded by
+ * that same class loader; a bridge from another loader (plugin hosts) loads
+ * its own library instead.
+ *
+ * Disable with `-Dnucleus.native.combined=false`.
+ */
+internal object LinuxNativeBundle {
+    private const val LIBRARY_NAME = "nucleus_linux"
+
+    // Must match MODULES in linux-native's nucleus_linux.c
+    private val MODULES = setOf("nucleus_linux_theme", "nucleus_linux_jni", "nucleus_linux_hidpi_jni")
+
+    private val available: Boolean by lazy {
+        Platform.Current == Platform.Linux &&
+            System.getProperty("nucleus.native.combined") != "false" &&
+            try {
+                NativeLibraryLoader.loadLibrary(LinuxNativeBundle::class.java, LIBRARY_NAME) { System.load(it) }
+                true
+            } catch (_: UnsatisfiedLinkError) {
+                // Artifact absent (the usual case): each bridge loads its own library
+                false
+            }
+    }
+
+    // True once [libraryName]'s module is initialised inside the combined library
+    fun provides(
+        owner: Class<*>,
+        libraryName: String,
+    ): Boolean =
+        libraryName in MODULES &&
+            owner.classLoader === LinuxNativeBundle::class.java.classLoader &&
+            available &&
+            nativeInitModule(libraryName)
+
+    @JvmStatic
+    private external fun nativeInitModule(libraryName: String): Boolean
+}
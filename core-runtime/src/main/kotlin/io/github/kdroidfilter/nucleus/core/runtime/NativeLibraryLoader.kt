@@ -0,0 +1,279 @@
+package io.github.kdroidfilter.nucleus.core.runtime
+
+import java.io.File
+import java.io.IOException
+import java.io.InputStream
+import java.nio.file.AtomicMoveNotSupportedException
+import java.nio.file.Files
+import java.nio.file.Path
+import java.nio.file.Paths
+import java.nio.file.StandardCopyOption
+import java.security.MessageDigest
+import java.util.Properties
+
+/**
+ * Loads the JNI libraries bundled in Nucleus JARs.
+ *
+ * The library is found on `java.library.path` first: packaged apps put the
+ * libraries there. Otherwise it is extracted from
+ * `/nucleus/native/<os>-<arch>/` into a per-user cache directory named after
+ * its SHA-256 (`$XDG_CACHE_HOME/nucleus/native/<sha256>/` on Linux) and loaded
+ * in place. Later launches, of this app or of any other app or version that
+ * ships the same build, load the cached copy without writing anything.
+ *
+ * The expected hash and size come from the `<file>.manifest` resource the
+ * native build writes next to each library. A cached copy is only trusted on
+ * its size: it can only appear through an atomic rename, after its content
+ * was checked against the manifest, so a hit costs one `stat`. Without a
+ * manifest the resource is read and hashed on every load to find its entry.
+ *
+ * Concurrent extractions, from threads or processes, each write a private
+ * temporary file and rename it into place; all of them produce the same bytes.
+ *
+ * The JVM binds a library to the class loader of the class that calls
+ * `System.load`, and native methods and `FindClass` in `JNI_OnLoad` only
+ * resolve against that loader. The caller therefore does the load itself,
+ * through the `load` callback. A library file can only be bound to one
+ * class loader: when a second loader of the process (plugin hosts) loads the
+ * shared cached copy, a private temporary copy is loaded instead.
+ *
+ * On Linux, the theme, window and HiDPI bridges are served by the combined
+ * `libnucleus_linux` instead of their own libraries when the optional
+ * `nucleus.linux-native` artifact is on the classpath and they share
+ * core-runtime's class loader (see [LinuxNativeBundle]).
+ */
+public object NativeLibraryLoader {
+    private const val RESOURCE_ROOT = "/nucleus/native"
+    private const val MANIFEST_SUFFIX = ".manifest"
+    private const val CACHE_DIR = "nucleus/native"
+
+    // UnsatisfiedLinkError message of System.load for a file bound to another class loader
+    private const val LOADED_ELSEWHERE = "already loaded in another classloader"
+
+    /**
+     * Loads [libraryName] (as passed to `System.loadLibrary`), looking up the
+     * bundled copy through [owner]'s class loader.
+     *
+     * [load] is called with the absolute path of the file to load and must be
+     * `{ System.load(it) }` written in [owner]'s module, so that the library is
+     * bound to [owner]'s class loader rather than to this one.
+     *
+     * @throws UnsatisfiedLinkError if the library is neither on the library
+     *   path nor bundled for this platform, or cannot be extracted or loaded.
+     */
+    @JvmStatic
+    public fun load(
+        owner: Class<*>,
+        libraryName: String,
+        load: (String) -> Unit,
+    ) {
+        if (LinuxNativeBundle.provides(owner, libraryName)) return
+        loadLibrary(owner, libraryName, load)
+    }
+
+    // Library path first, else the bundled copy; never redirected to the combined library
+    internal fun loadLibrary(
+        owner: Class<*>,
+        libraryName: String,
+        load: (String) -> Unit,
+    ) {
+        val fileName = System.mapLibraryName(libraryName)
+        val installed = findOnLibraryPath(fileName)
+        if (installed != null) {
+            try {
+                load(installed.toString())
+                return
+            } catch (_: UnsatisfiedLinkError) {
+                // Fall through to the bundled copy
+            }
+        }
+
+        loadBundled(owner, "$RESOURCE_ROOT/${platformDirectory()}/$fileName", cacheRoot(), load)
+    }
+
+    /**
+     * Extracts [resourcePath] into [cacheRoot] (a temporary directory when
+     * null) and loads it, or a private copy when the cached one is bound to
+     * another class loader.
+     */
+    internal fun loadBundled(
+        owner: Class<*>,
+        resourcePath: String,
+        cacheRoot: Path?,
+        load: (String) -> Unit,
+    ) {
+        val fileName = resourcePath.substringAfterLast('/')
+        val library =
+            extracting(resourcePath) {
+                if (cacheRoot != null) {
+                    cachedCopy(owner, resourcePath, cacheRoot)
+                } else {
+                    writeTemporary(fileName, readResource(owner, resourcePath))
+                }
+            }
+        try {
+            load(library.toAbsolutePath().toString())
+        } catch (e: UnsatisfiedLinkError) {
+            if (cacheRoot == null || e.message?.contains(LOADED_ELSEWHERE) != true) throw e
+            val copy = extracting(resourcePath) { writeTemporary(fileName, readResource(owner, resourcePath)) }
+            load(copy.toAbsolutePath().toString())
+        }
+    }
+
+    private inline fun extracting(
+        resourcePath: String,
+        extract: () -> Path,
+    ): Path =
+        try {
+            extract()
+        } catch (e: IOException) {
+            throw UnsatisfiedLinkError("Cannot extract $resourcePath: ${e.message}").apply { initCause(e) }
+        }
+
+    // The file System.loadLibrary would pick on java.library.path, if any
+    private fun findOnLibraryPath(fileName: String): Path? =
+        System
+            .getProperty("java.library.path")
+            .orEmpty()
+            .split(File.pathSeparator)
+            .filter { it.isNotEmpty() }
+            .map { Paths.get(it).resolve(fileName).toAbsolutePath() }
+            .firstOrNull { Files.isRegularFile(it) }
+
+    /**
+     * The cached copy of [resourcePath] under [cacheRoot], extracted first if
+     * missing. Falls back to a temporary copy when the cache is not writable.
+     */
+    internal fun cachedCopy(
+        owner: Class<*>,
+        resourcePath: String,
+        cacheRoot: Path,
+    ): Path {
+        val fileName = resourcePath.substringAfterLast('/')
+        val manifest = readManifest(owner, resourcePath + MANIFEST_SUFFIX)
+
+        if (manifest != null) {
+            val cached = cacheRoot.resolve(manifest.sha256).resolve(fileName)
+            if (sizeOf(cached) == manifest.size) return cached
+        }
+
+        val bytes = readResource(owner, resourcePath)
+        val sha256 = sha256(bytes)
+        if (manifest != null && (manifest.sha256 != sha256 || manifest.size != bytes.size.toLong())) {
+            throw IOException("$resourcePath does not match its manifest")
+        }
+        val cached = cacheRoot.resolve(sha256).resolve(fileName)
+        if (sizeOf(cached) == bytes.size.toLong()) return cached
+
+        return try {
+            install(cached, bytes)
+        } catch (_: IOException) {
+            // Read-only or full cache: work like an uncached extraction
+            writeTemporary(fileName, bytes)
+        }
+    }
+
+    // Write to a private file, then rename: readers never see a partial library
+    private fun install(
+        target: Path,
+        bytes: ByteArray,
+    ): Path {
+        val dir = Files.createDirectories(target.parent)
+        val tmp = Files.createTempFile(dir, target.fileName.toString(), ".tmp")
+        try {
+            Files.write(tmp, bytes)
+            try {
+                Files.move(tmp, target, StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.ATOMIC_MOVE)
+            } catch (_: AtomicMoveNotSupportedException) {
+                Files.move(tmp, target, StandardCopyOption.REPLACE_EXISTING)
+            }
+        } catch (e: IOException) {
+            // Another process won the race (Windows refuses to replace a loaded DLL)
+            if (sizeOf(target) != bytes.size.toLong()) throw e
+        } finally {
+            Files.deleteIfExists(tmp)
+        }
+        return target
+    }
+
+    private fun writeTemporary(
+        fileName: String,
+        bytes: ByteArray,
+    ): Path {
+        val dir = Files.createTempDirectory("nucleus-native")
+        val lib = dir.resolve(fileName)
+        Files.write(lib, bytes)
+        lib.toFile().deleteOnExit()
+        dir.toFile().deleteOnExit()
+        return lib
+    }
+
+    private class Manifest(
+        val sha256: String,
+        val size: Long,
+    )
+
+    // sha256=<hex>, size=<bytes>; null if absent or malformed
+    private fun readManifest(
+        owner: Class<*>,
+        path: String,
+    ): Manifest? {
+        val properties = Properties()
+        try {
+            owner.getResourceAsStream(path)?.use { properties.load(it) } ?: return null
+        } catch (_: IOException) {
+            return null
+        }
+        val sha256 = properties.getProperty("sha256")?.trim()?.lowercase() ?: return null
+        val size = properties.getProperty("size")?.trim()?.toLongOrNull() ?: return null
+        return Manifest(sha256, size)
+    }
+
+    private fun readResource(
+        owner: Class<*>,
+        path: String,
+    ): ByteArray {
+        val stream: InputStream =
+            owner.getResourceAsStream(path)
+                ?: throw IOException("Native library not found in JAR at $path")
+        return stream.use { it.readBytes() }
+    }
+
+    private fun sizeOf(path: Path): Long =
+        try {
+            Files.size(path)
+        } catch (_: IOException) {
+            -1L
+        }
+
+    private fun sha256(bytes: ByteArray): String =
+        MessageDigest.getInstance("SHA-256").digest(bytes).joinToString("") { "%02x".format(it) }
+
+    private fun platformDirectory(): String {
+        val arch =
+            System.getProperty("os.arch").let {
+                if (it == "aarch64" || it == "arm64") "aarch64" else "x64"
+            }
+        val os =
+            when (Platform.Current) {
+                Platform.MacOS -> "darwin"
+                Platform.Windows -> "win32"
+                else -> "linux"
+            }
+        return "$os-$arch"
+    }
+
+    // Per-user cache root for extracted libraries; null when none is known
+    private fun cacheRoot(): Path? {
+        val home = System.getProperty("user.home")?.takeIf { it.isNotEmpty() }
+        val base =
+            when (Platform.Current) {
+                Platform.MacOS -> home?.let { Paths.get(it, "Library", "Caches") }
+                Platform.Windows -> System.getenv("LOCALAPPDATA")?.takeIf { it.isNotEmpty() }?.let { Paths.get(it) }
+                else ->
+                    System.getenv("XDG_CACHE_HOME")?.takeIf { it.isNotEmpty() }?.let { Paths.get(it) }
+                        ?: home?.let { Paths.get(it, ".cache") }
+            }
+        return base?.resolve(CACHE_DIR)
+    }
+}
@@ -0,0 +1,72 @@
+package io.github.kdroidfilter.nucleus.core.runtime
+
+import jdk.jfr.Category
+import jdk.jfr.Description
+import jdk.jfr.Event
+import jdk.jfr.FlightRecorder
+import jdk.jfr.Label
+import jdk.jfr.Name
+import jdk.jfr.Period
+import jdk.jfr.StackTrace
+import jdk.jfr.Timespan
+
+/**
+ * The JFR side of [NucleusNativeStats], kept apart so that `jdk.jfr` is only
+ * loaded when JFR events are requested.
+ *
+ * The event is periodic: JFR runs the hook, which reads the native counters,
+ * only while a recording enables it, at the period the recording sets.
+ */
+internal object NativeStatsJfr {
+    private val emit =
+        Runnable {
+            for (stats in NucleusNativeStats.snapshot()) {
+                val event = NativeCallEvent()
+                event.library = stats.library
+                event.probe = stats.probe
+                event.calls = stats.calls
+                event.errors = stats.errors
+                event.totalDuration = stats.totalNanos
+                event.maxDuration = stats.maxNanos
+                event.commit()
+            }
+        }
+
+    fun register() {
+        FlightRecorder.addPeriodicEvent(NativeCallEvent::class.java, emit)
+    }
+}
+
+@Name("io.github.kdroidfilter.nucleus.NativeCall")
+@Label("Nucleus Native Call")
+@Category("Nucleus")
+@Description("Call statistics of a Nucleus native entry point, cumulated since its library loaded")
+@Period("1 s")
+@StackTrace(false)
+internal class NativeCallEvent : Event() {
+    @field:Label("Library")
+    @JvmField
+    var library: String? = null
+
+    @field:Label("Probe")
+    @JvmField
+    var probe: String? = null
+
+    @field:Label("Calls")
+    @JvmField
+    var calls: Long = 0
+
+    @field:Label("Errors")
+    @JvmField
+    var errors: Long = 0
+
+    @field:Label("Total Duration")
+    @field:Timespan(Timespan.NANOSECONDS)
+    @JvmField
+    var totalDuration: Long = 0
+
+    @field:Label("Max Duration")
+    @field:Timespan(Timespan.NANOSECONDS)
+    @JvmField
+    var maxDuration: Long = 0
+}
@@ -0,0 +1,165 @@
+package io.github.kdroidfilter.nucleus.core.runtime
+
+import java.util.concurrent.CopyOnWriteArrayList
+import java.util.logging.Level
+import java.util.logging.Logger
+
+/**
+ * Call statistics of the Nucleus native libraries, for diagnosing slow starts
+ * or laggy window interactions from the native side.
+ *
+ * Every JNI entry point and every unit of background-thread work (a monitor
+ * wakeup, a startup probe) of the Linux theme, window and HiDPI bridges counts
+ * its calls, errors, and cumulative and maximum latency. The counters are
+ * per thread and lock-free; they are summed when read.
+ *
+ * Recording starts with the first [snapshot] (or [enable]); until then an
+ * entry point costs one relaxed load. Start the app with
+ * `-Dnucleus.native.stats=true` to record from the moment each library loads.
+ * Library initialisation (`JNI_OnLoad`) and the HiDPI startup probes run once
+ * and are always recorded.
+ *
+ * With `-Dnucleus.native.stats.jfr=true`, or after [enableJfrEvents], the
+ * counters are also emitted as the periodic `io.github.kdroidfilter.nucleus.NativeCall`
+ * JFR event, once per probe and period, in recordings that enable it.
+ */
+public object NucleusNativeStats {
+    // Longs per probe in a source's counters (NUCLEUS_STATS_FIELDS in nucleus_native_stats.h)
+    private const val FIELDS = 4
+
+    private val logger = Logger.getLogger(NucleusNativeStats::class.java.simpleName)
+
+    private class Source(
+        val library: String,
+        val probes: List<String>,
+        val read: () -> LongArray,
+        val setEnabled: (Boolean) -> Unit,
+    )
+
+    private val sources = CopyOnWriteArrayList<Source>()
+
+    @Volatile
+    private var enabled = System.getProperty("nucleus.native.stats") == "true"
+
+    @Volatile
+    private var jfrRegistered = false
+
+    init {
+        if (System.getProperty("nucleus.native.stats.jfr") == "true") enableJfrEvents()
+    }
+
+    /** Whether the native libraries are recording calls. */
+    @JvmStatic
+    public val isEnabled: Boolean get() = enabled
+
+    /**
+     * The statistics of every probe of every loaded native library, cumulated
+     * since the library loaded. Starts recording if it was not already on, so
+     * the first snapshot of a session may be mostly empty.
+     */
+    @JvmStatic
+    public fun snapshot(): List<NativeCallStats> {
+        enable()
+        return sources.flatMap { source -> read(source) }
+    }
+
+    /** Starts recording in every loaded native library, and in those loaded later. */
+    @JvmStatic
+    public fun enable() {
+        if (enabled) return
+        enabled = true
+        sources.forEach { source -> setEnabled(source, true) }
+    }
+
+    /**
+     * Registers the `io.github.kdroidfilter.nucleus.NativeCall` periodic JFR
+     * event. Returns false when the runtime has no `jdk.jfr` module.
+     */
+    @JvmStatic
+    @Synchronized
+    public fun enableJfrEvents(): Boolean {
+        if (jfrRegistered) return true
+        try {
+            NativeStatsJfr.register()
+            jfrRegistered = true
+        } catch (e: LinkageError) {
+            logger.log(Level.WARNING, "JFR is unavailable, native call events are disabled", e)
+        }
+        return jfrRegistered
+    }
+
+    /**
+     * Called by the Nucleus native bridges once their library is loaded.
+     *
+     * [probes] names the library's probes in the order of the counters [read]
+     * returns: calls, errors, total nanos and max nanos for each.
+     * [setEnabled] switches recording in the library.
+     */
+    @JvmStatic
+    public fun register(
+        library: String,
+        probes: List<String>,
+        read: () -> LongArray,
+        setEnabled: (Boolean) -> Unit,
+    ) {
+        val source = Source(library, probes, read, setEnabled)
+        sources += source
+        if (enabled) setEnabled(source, true)
+    }
+
+    private fun read(source: Source): List<NativeCallStats> {
+        val counters =
+            try {
+                source.read()
+            } catch (e: UnsatisfiedLinkError) {
+                // A library predating the statistics, e.g. an older copy on java.library.path
+                logger.log(Level.FINE, "No native call statistics in ${source.library}", e)
+                return emptyList()
+            }
+        val count = minOf(source.probes.size, counters.size / FIELDS)
+        return List(count) { probe ->
+            val offset = probe * FIELDS
+            NativeCallStats(
+                library = source.library,
+                probe = source.probes[probe],
+                calls = counters[offset],
+                errors = counters[offset + 1],
+                totalNanos = counters[offset + 2],
+                maxNanos = counters[offset + 3],
+            )
+        }
+    }
+
+    private fun setEnabled(
+        source: Source,
+        enabled: Boolean,
+    ) {
+        try {
+            source.setEnabled(enabled)
+        } catch (e: UnsatisfiedLinkError) {
+            logger.log(Level.FINE, "No native call statistics in ${source.library}", e)
+        }
+    }
+}
+
+/**
+ * The statistics of one native probe: a JNI entry point, or a unit of work of
+ * one of the library's background threads.
+ *
+ * @property library the native library, as passed to [NativeLibraryLoader.load].
+ * @property probe the entry point's name (`nativeIsDark`) or the background work's.
+ * @property errors calls that failed, e.g. a window command the bridge could not send.
+ * @property totalNanos wall-clock time spent in the calls, cumulated.
+ * @property maxNanos the longest call.
+ */
+public data class NativeCallStats(
+    val library: String,
+    val probe: String,
+    val calls: Long,
+    val errors: Long,
+    val totalNanos: Long,
+    val maxNanos: Long,
+) {
+    /** Mean latency of a call, 0 when there was none. */
+    val averageNanos: Long get() = if (calls == 0L) 0L else totalNanos / calls
+}
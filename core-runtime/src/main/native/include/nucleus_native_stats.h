@@ -0,0 +1,251 @@
+/**
+ * Call statistics for the Linux JNI bridges, read from Java through
+ * core-runtime's NucleusNativeStats.
+ *
+ * A bridge numbers its probes (JNI entry points and units of background-thread
+ * work) with an enum, defines NUCLEUS_STATS_PROBES to their count before
+ * including this header, and opens a scope where each probe starts:
+ *
+ *     NUCLEUS_STATS_SCOPE(PROBE_IS_DARK);
+ *     ...
+ *     if (failed) NUCLEUS_STATS_FAIL();
+ *
+ * The scope is recorded when it exits, through every return path; entry points
+ * returning false on failure use NUCLEUS_STATS_CHECKED_SCOPE. Each probe
+ * keeps { calls, errors, total nanos, max nanos } (NUCLEUS_STATS_FIELDS).
+ *
+ * Recording takes no lock and shares no cache line between threads: every
+ * thread writes its own block of counters, allocated on its first recorded
+ * call and pushed onto a lock-free list, with plain relaxed loads and stores
+ * (it is their only writer). Readers sum the blocks. When a thread exits, a
+ * pthread key destructor folds its counters into a shared retired total and
+ * recycles its block for the next new thread, so calls made by exited threads
+ * stay in the totals and short-lived threads do not grow the list. Folding
+ * and reading hold nucleus_stats_lock, so no call is counted twice or lost.
+ *
+ * Until nucleus_stats_set_enabled(1) — the first NucleusNativeStats read, or
+ * -Dnucleus.native.stats=true — a scope costs one relaxed load and a branch:
+ * no clock read and no counter write. Startup scopes (JNI_OnLoad, once per
+ * process) are recorded regardless.
+ *
+ * Every source including this header gets its own counters: in the combined
+ * libnucleus_linux each module keeps its own.
+ */
+
+#ifndef NUCLEUS_NATIVE_STATS_H
+#define NUCLEUS_NATIVE_STATS_H
+
+#include <jni.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef NUCLEUS_STATS_PROBES
+#error "Define NUCLEUS_STATS_PROBES to the bridge's probe count before including nucleus_native_stats.h"
+#endif
+
+/* Per-probe counters, in the order nucleus_stats_to_java reports them */
+#define NUCLEUS_STATS_CALLS       0
+#define NUCLEUS_STATS_ERRORS      1
+#define NUCLEUS_STATS_TOTAL_NANOS 2
+#define NUCLEUS_STATS_MAX_NANOS   3
+#define NUCLEUS_STATS_FIELDS      4
+
+#define NUCLEUS_STATS_CACHE_LINE  64
+
+typedef struct NucleusStatsBlock {
+    _Atomic int64_t counters[NUCLEUS_STATS_PROBES][NUCLEUS_STATS_FIELDS];
+    struct NucleusStatsBlock *next;       /* every block, never unlinked */
+    struct NucleusStatsBlock *next_free;  /* recycled blocks, under nucleus_stats_lock */
+} NucleusStatsBlock;
+
+static atomic_int nucleus_stats_enabled;
+static _Atomic(NucleusStatsBlock *) nucleus_stats_blocks;
+static __thread NucleusStatsBlock *nucleus_stats_block;
+
+/* Exited threads: their summed counters, and their blocks awaiting reuse */
+static pthread_mutex_t nucleus_stats_lock = PTHREAD_MUTEX_INITIALIZER;
+static jlong nucleus_stats_retired[NUCLEUS_STATS_PROBES * NUCLEUS_STATS_FIELDS];
+static NucleusStatsBlock *nucleus_stats_free;
+
+static pthread_once_t nucleus_stats_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t nucleus_stats_key;
+static int nucleus_stats_key_created;
+
+static inline int64_t nucleus_stats_nanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Adds block's counters into values (NUCLEUS_STATS_FIELDS per probe).
+ * Caller holds nucleus_stats_lock or owns the block. */
+static inline void nucleus_stats_merge(jlong *values, NucleusStatsBlock *block) {
+    for (int probe = 0; probe < NUCLEUS_STATS_PROBES; probe++) {
+        jlong *out = &values[probe * NUCLEUS_STATS_FIELDS];
+        for (int field = 0; field < NUCLEUS_STATS_FIELDS; field++) {
+            jlong value = atomic_load_explicit(&block->counters[probe][field], memory_order_relaxed);
+            if (field != NUCLEUS_STATS_MAX_NANOS) {
+                out[field] += value;
+            } else if (value > out[field]) {
+                out[field] = value;
+            }
+        }
+    }
+}
+
+/* Key destructor, on the exiting thread: retire its counters, recycle its block */
+static void nucleus_stats_thread_exit(void *value) {
+    NucleusStatsBlock *block = (NucleusStatsBlock *)value;
+    pthread_mutex_lock(&nucleus_stats_lock);
+    nucleus_stats_merge(nucleus_stats_retired, block);
+    memset(block->counters, 0, sizeof(block->counters));
+    block->next_free = nucleus_stats_free;
+    nucleus_stats_free = block;
+    pthread_mutex_unlock(&nucleus_stats_lock);
+    /* A later destructor recording again gets a block and key value anew */
+    nucleus_stats_block = NULL;
+}
+
+static void nucleus_stats_create_key(void) {
+    nucleus_stats_key_created = pthread_key_create(&nucleus_stats_key, nucleus_stats_thread_exit) == 0;
+}
+
+/* The destructor lives in this library: once it is unloaded, exiting threads
+ * must not call it (their blocks simply stay on the list) */
+__attribute__((destructor)) static void nucleus_stats_unload(void) {
+    if (nucleus_stats_key_created) pthread_key_delete(nucleus_stats_key);
+}
+
+/* The calling thread's block: a recycled one, else created and published */
+static inline NucleusStatsBlock *nucleus_stats_thread_block(void) {
+    NucleusStatsBlock *block = nucleus_stats_block;
+    if (block != NULL) return block;
+
+    pthread_once(&nucleus_stats_key_once, nucleus_stats_create_key);
+    pthread_mutex_lock(&nucleus_stats_lock);
+    block = nucleus_stats_free;
+    if (block != NULL) nucleus_stats_free = block->next_free;
+    pthread_mutex_unlock(&nucleus_stats_lock);
+
+    if (block == NULL) {
+        void *memory = NULL;
+        if (posix_memalign(&memory, NUCLEUS_STATS_CACHE_LINE, sizeof(NucleusStatsBlock)) != 0) {
+            return NULL;
+        }
+        block = memset(memory, 0, sizeof(NucleusStatsBlock));
+        block->next = atomic_load_explicit(&nucleus_stats_blocks, memory_order_relaxed);
+        while (!atomic_compare_exchange_weak_explicit(&nucleus_stats_blocks, &block->next, block,
+                                                      memory_order_release, memory_order_relaxed)) {
+        }
+    }
+    /* Without the key the block is simply never recycled */
+    if (nucleus_stats_key_created) pthread_setspecific(nucleus_stats_key, block);
+    nucleus_stats_block = block;
+    return block;
+}
+
+/* Only the owning thread writes a counter: no read-modify-write needed */
+static inline void nucleus_stats_add(_Atomic int64_t *counter, int64_t delta) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + delta,
+                          memory_order_relaxed);
+}
+
+static inline void nucleus_stats_record(int probe, int64_t nanos, int failed) {
+    NucleusStatsBlock *block = nucleus_stats_thread_block();
+    if (block == NULL) return;  /* out of memory: drop the sample */
+
+    _Atomic int64_t *counters = block->counters[probe];
+    nucleus_stats_add(&counters[NUCLEUS_STATS_CALLS], 1);
+    if (failed) nucleus_stats_add(&counters[NUCLEUS_STATS_ERRORS], 1);
+    nucleus_stats_add(&counters[NUCLEUS_STATS_TOTAL_NANOS], nanos);
+    if (nanos > atomic_load_explicit(&counters[NUCLEUS_STATS_MAX_NANOS], memory_order_relaxed)) {
+        atomic_store_explicit(&counters[NUCLEUS_STATS_MAX_NANOS], nanos, memory_order_relaxed);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Scopes                                                             */
+/*  start is 0 when stats were disabled as the scope opened: nothing   */
+/*  is recorded for it, even if they are enabled before it exits.      */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    int     probe;
+    int     failed;
+    int64_t start;
+} NucleusStatsScope;
+
+static inline NucleusStatsScope nucleus_stats_begin(int probe) {
+    NucleusStatsScope scope = { probe, 0, 0 };
+    if (atomic_load_explicit(&nucleus_stats_enabled, memory_order_relaxed)) {
+        scope.start = nucleus_stats_nanos();
+    }
+    return scope;
+}
+
+static inline NucleusStatsScope nucleus_stats_begin_startup(int probe) {
+    NucleusStatsScope scope = { probe, 0, nucleus_stats_nanos() };
+    return scope;
+}
+
+static inline void nucleus_stats_end(NucleusStatsScope *scope) {
+    if (scope->start == 0) return;
+    nucleus_stats_record(scope->probe, nucleus_stats_nanos() - scope->start, scope->failed);
+    scope->start = 0;
+}
+
+/* Scope covering the rest of the enclosing block */
+#define NUCLEUS_STATS_SCOPE(probe) \
+    NucleusStatsScope nucleus_stats_scope __attribute__((cleanup(nucleus_stats_end))) = \
+        nucleus_stats_begin(probe)
+
+#define NUCLEUS_STATS_STARTUP_SCOPE(probe) \
+    NucleusStatsScope nucleus_stats_scope __attribute__((cleanup(nucleus_stats_end))) = \
+        nucleus_stats_begin_startup(probe)
+
+/* Scope for an entry point that reports failure by returning false: its
+ * call counts as an error unless NUCLEUS_STATS_OK() runs before it returns */
+#define NUCLEUS_STATS_CHECKED_SCOPE(probe) \
+    NUCLEUS_STATS_SCOPE(probe);            \
+    nucleus_stats_scope.failed = 1
+
+/* Counts the enclosing scope's call as an error, or as a success */
+#define NUCLEUS_STATS_FAIL() (nucleus_stats_scope.failed = 1)
+#define NUCLEUS_STATS_OK()   (nucleus_stats_scope.failed = 0)
+
+/* Returns result, counting the call as an error when it is false */
+#define NUCLEUS_STATS_RESULT(result) ({                 \
+    __typeof__(result) nucleus_stats_result = (result); \
+    nucleus_stats_scope.failed = !nucleus_stats_result; \
+    nucleus_stats_result;                               \
+})
+
+/* ------------------------------------------------------------------ */
+/*  Readers                                                            */
+/* ------------------------------------------------------------------ */
+static inline void nucleus_stats_set_enabled(int enabled) {
+    atomic_store_explicit(&nucleus_stats_enabled, enabled ? 1 : 0, memory_order_relaxed);
+}
+
+/* All threads' counters, exited ones included, NUCLEUS_STATS_FIELDS longs per probe */
+static inline jlongArray nucleus_stats_to_java(JNIEnv *env) {
+    jlong values[NUCLEUS_STATS_PROBES * NUCLEUS_STATS_FIELDS];
+
+    pthread_mutex_lock(&nucleus_stats_lock);
+    memcpy(values, nucleus_stats_retired, sizeof(values));
+    NucleusStatsBlock *block = atomic_load_explicit(&nucleus_stats_blocks, memory_order_acquire);
+    for (; block != NULL; block = block->next) {
+        nucleus_stats_merge(values, block);
+    }
+    pthread_mutex_unlock(&nucleus_stats_lock);
+
+    jsize length = NUCLEUS_STATS_PROBES * NUCLEUS_STATS_FIELDS;
+    jlongArray result = (*env)->NewLongArray(env, length);
+    if (result != NULL) (*env)->SetLongArrayRegion(env, result, 0, length, values);
+    return result;
+}
+
+#endif
@@ -0,0 +1,87 @@
+package io.github.kdroidfilter.nucleus.core.runtime
+
+import org.junit.Assert.assertArrayEquals
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import java.io.IOException
+import java.nio.file.Files
+import java.nio.file.Paths
+import java.nio.file.attribute.FileTime
+
+class NativeLibraryLoaderTest {
+    @get:Rule
+    val temp = TemporaryFolder()
+
+    private val owner = NativeLibraryLoaderTest::class.java
+
+    private fun resourceBytes(path: String): ByteArray = owner.getResourceAsStream(path)!!.use { it.readBytes() }
+
+    @Test
+    fun `extracts into a directory named after the manifest hash`() {
+        val cacheRoot = temp.root.toPath()
+        val lib = NativeLibraryLoader.cachedCopy(owner, "/nucleus/native/test/libsample.bin", cacheRoot)
+
+        assertEquals(
+            cacheRoot.resolve("d8973d494e5ff04f476f931235aeeca57e50e540a1c7b9c2abd80408256aeaa6/libsample.bin"),
+            lib,
+        )
+        assertArrayEquals(resourceBytes("/nucleus/native/test/libsample.bin"), Files.readAllBytes(lib))
+        // Only the library itself: the temporary file was renamed into place
+        assertEquals(listOf("libsample.bin"), lib.parent.toFile().list()!!.toList())
+    }
+
+    @Test
+    fun `reuses the cached copy without rewriting it`() {
+        val cacheRoot = temp.root.toPath()
+        val first = NativeLibraryLoader.cachedCopy(owner, "/nucleus/native/test/libsample.bin", cacheRoot)
+        val stamp = FileTime.fromMillis(0)
+        Files.setLastModifiedTime(first, stamp)
+
+        val second = NativeLibraryLoader.cachedCopy(owner, "/nucleus/native/test/libsample.bin", cacheRoot)
+
+        assertEquals(first, second)
+        assertEquals(stamp, Files.getLastModifiedTime(second))
+    }
+
+    @Test(expected = IOException::class)
+    fun `rejects a library that does not match its manifest`() {
+        NativeLibraryLoader.cachedCopy(owner, "/nucleus/native/test/libtampered.bin", temp.root.toPath())
+    }
+
+    @Test
+    fun `hashes libraries without a manifest`() {
+        val cacheRoot = temp.root.toPath()
+        val lib = NativeLibraryLoader.cachedCopy(owner, "/nucleus/native/test/libunlisted.bin", cacheRoot)
+
+        assertTrue(lib.startsWith(cacheRoot))
+        assertEquals(64, lib.parent.fileName.toString().length)
+        assertArrayEquals(resourceBytes("/nucleus/native/test/libunlisted.bin"), Files.readAllBytes(lib))
+    }
+
+    @Test
+    fun `loads a private copy when the cached one is bound to another class loader`() {
+        val cacheRoot = temp.root.toPath()
+        val loaded = mutableListOf<String>()
+        NativeLibraryLoader.loadBundled(owner, "/nucleus/native/test/libsample.bin", cacheRoot) { path ->
+            loaded += path
+            if (path.startsWith(cacheRoot.toString())) {
+                throw UnsatisfiedLinkError("Native Library $path already loaded in another classloader")
+            }
+        }
+
+        assertEquals(2, loaded.size)
+        assertFalse(loaded[1].startsWith(cacheRoot.toString()))
+        assertArrayEquals(resourceBytes("/nucleus/native/test/libsample.bin"), Files.readAllBytes(Paths.get(loaded[1])))
+    }
+
+    @Test(expected = UnsatisfiedLinkError::class)
+    fun `reports other load failures`() {
+        NativeLibraryLoader.loadBundled(owner, "/nucleus/native/test/libsample.bin", temp.root.toPath()) { path ->
+            throw UnsatisfiedLinkError("$path: invalid ELF header")
+        }
+    }
+}
@@ -0,0 +1,56 @@
+package io.github.kdroidfilter.nucleus.core.runtime
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class NucleusNativeStatsTest {
+    private fun statsOf(library: String) = NucleusNativeStats.snapshot().filter { it.library == library }
+
+    @Test
+    fun `maps each probe's counters in order`() {
+        val counters = longArrayOf(3, 1, 300, 200, 0, 0, 0, 0)
+        NucleusNativeStats.register("libmapped", listOf("nativeFirst", "worker wakeup"), { counters }, { })
+
+        assertEquals(
+            listOf(
+                NativeCallStats("libmapped", "nativeFirst", calls = 3, errors = 1, totalNanos = 300, maxNanos = 200),
+                NativeCallStats("libmapped", "worker wakeup", calls = 0, errors = 0, totalNanos = 0, maxNanos = 0),
+            ),
+            statsOf("libmapped"),
+        )
+        assertEquals(100L, statsOf("libmapped")[0].averageNanos)
+        assertEquals(0L, statsOf("libmapped")[1].averageNanos)
+    }
+
+    @Test
+    fun `reading enables recording in every library`() {
+        val switches = mutableListOf<Boolean>()
+        NucleusNativeStats.register("libswitched", listOf("nativeCall"), { LongArray(4) }, { switches += it })
+
+        statsOf("libswitched")
+        NucleusNativeStats.register("liblate", listOf("nativeCall"), { LongArray(4) }, { switches += it })
+
+        assertTrue(NucleusNativeStats.isEnabled)
+        assertEquals(listOf(true, true), switches)
+    }
+
+    @Test
+    fun `skips libraries without statistics`() {
+        NucleusNativeStats.register(
+            "libstale",
+            listOf("nativeCall"),
+            { throw UnsatisfiedLinkError("nativeGetStats") },
+            { throw UnsatisfiedLinkError("nativeSetStatsEnabled") },
+        )
+
+        assertEquals(emptyList<NativeCallStats>(), statsOf("libstale"))
+    }
+
+    @Test
+    fun `ignores counters beyond the named probes`() {
+        NucleusNativeStats.register("libnewer", listOf("nativeCall"), { longArrayOf(1, 0, 5, 5, 9, 9, 9, 9) }, { })
+
+        assertEquals(listOf("nativeCall"), statsOf("libnewer").map { it.probe })
+    }
+}
@@ -69,6 +69,7 @@ val buildNativeLinux by tasks.registering(Exec::class) {
 
     val nativeDir = layout.projectDirectory.dir("src/main/native/linux")
     inputs.dir(nativeDir)
+    inputs.dir(rootProject.layout.projectDirectory.dir("core-runtime/src/main/native/include"))
     outputs.dir(nativeResourceDir)
     workingDir(nativeDir)
     commandLine("bash", "build.sh")
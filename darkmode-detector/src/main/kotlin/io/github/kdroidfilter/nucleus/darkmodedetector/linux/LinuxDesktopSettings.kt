@@ -0,0 +1,56 @@
+package io.github.kdroidfilter.nucleus.darkmodedetector.linux
+
+import androidx.compose.runtime.Composable
+import androidx.compose.ui.graphics.Color
+
+/**
+ * Appearance preferences published by the XDG Desktop Portal
+ * (`org.freedesktop.appearance` namespace).
+ *
+ * @property colorScheme 0 = no preference, 1 = prefer dark, 2 = prefer light; null if not provided.
+ * @property accentColor The user's accent color, or null if not provided.
+ * @property highContrast Whether high contrast is requested; null if not provided.
+ * @property reducedMotion Whether reduced motion is requested; null if not provided.
+ */
+data class LinuxDesktopSettings(
+    val colorScheme: Int?,
+    val accentColor: Color?,
+    val highContrast: Boolean?,
+    val reducedMotion: Boolean?,
+) {
+    val isDark: Boolean get() = colorScheme == 1
+}
+
+/**
+ * The current portal appearance settings, or null when the portal is not
+ * observed (native library missing or no session bus).
+ */
+fun getLinuxDesktopSettings(): LinuxDesktopSettings? = LinuxPortalThemeDetector.desktopSettings.value
+
+/**
+ * Returns the portal appearance settings, updated once per batch of
+ * SettingChanged signals. Null when the portal is not observed.
+ *
+ * Backed by the same process-wide state as [getLinuxDesktopSettings].
+ */
+@Composable
+fun rememberLinuxDesktopSettings(): LinuxDesktopSettings? = LinuxPortalThemeDetector.desktopSettings.value
+
+internal fun DoubleArray.toLinuxDesktopSettings(): LinuxDesktopSettings {
+    fun value(slot: Int): Double? = this[slot].takeIf { it >= 0.0 }
+
+    val red = value(NativeLinuxBridge.SETTING_ACCENT_RED)
+    val green = value(NativeLinuxBridge.SETTING_ACCENT_GREEN)
+    val blue = value(NativeLinuxBridge.SETTING_ACCENT_BLUE)
+    return LinuxDesktopSettings(
+        colorScheme = value(NativeLinuxBridge.SETTING_COLOR_SCHEME)?.toInt(),
+        accentColor =
+            if (red != null && green != null && blue != null) {
+                Color(red.toFloat(), green.toFloat(), blue.toFloat())
+            } else {
+                null
+            },
+        highContrast = value(NativeLinuxBridge.SETTING_CONTRAST)?.let { it == 1.0 },
+        reducedMotion = value(NativeLinuxBridge.SETTING_REDUCED_MOTION)?.let { it == 1.0 },
+    )
+}
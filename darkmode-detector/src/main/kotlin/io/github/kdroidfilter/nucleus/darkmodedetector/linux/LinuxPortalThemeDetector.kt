@@ -1,9 +1,8 @@
 package io.github.kdroidfilter.nucleus.darkmodedetector.linux
 
 import androidx.compose.runtime.Composable
-import androidx.compose.runtime.DisposableEffect
+import androidx.compose.runtime.State
 import androidx.compose.runtime.mutableStateOf
-import androidx.compose.runtime.remember
 import io.github.kdroidfilter.nucleus.darkmodedetector.debugln
 import java.util.function.Consumer
 
@@ -17,14 +16,34 @@ private const val TAG = "LinuxPortalThemeDetector"
  *
  * The detector also monitors for SettingChanged signals in real-time via a background
  * D-Bus dispatch thread.
+ *
+ * [darkMode] and [desktopSettings] are process-wide: seeded once when the detector
+ * starts and updated by a single listener on the native monitor, so every call site
+ * reads the same state instead of querying the bridge and registering its own listener.
  */
 internal object LinuxPortalThemeDetector {
+    private val darkModeState = mutableStateOf(false)
+    private val desktopSettingsState = mutableStateOf<LinuxDesktopSettings?>(null)
+
+    val darkMode: State<Boolean> get() = darkModeState
+    val desktopSettings: State<LinuxDesktopSettings?> get() = desktopSettingsState
+
     init {
         debugln(TAG) { "Initializing Linux portal theme observer via JNI" }
         NativeLinuxBridge.nativeStartObserving()
+        // Registered before seeding, so a change in between is not lost
+        NativeLinuxBridge.registerListener { isDark ->
+            debugln(TAG) { "Linux portal dark mode updated: $isDark" }
+            darkModeState.value = isDark
+        }
+        NativeLinuxBridge.registerSettingsListener { values ->
+            desktopSettingsState.value = values.toLinuxDesktopSettings()
+        }
+        darkModeState.value = NativeLinuxBridge.nativeIsDark()
+        desktopSettingsState.value = NativeLinuxBridge.nativeGetSettings()?.toLinuxDesktopSettings()
     }
 
-    fun isDark(): Boolean = NativeLinuxBridge.nativeIsDark()
+    fun isDark(): Boolean = darkModeState.value
 
     fun registerListener(listener: Consumer<Boolean>) {
         NativeLinuxBridge.registerListener(listener)
@@ -38,22 +57,9 @@ internal object LinuxPortalThemeDetector {
 /**
  * A helper composable function that returns the current Linux dark mode state
  * via the XDG Desktop Portal, updating automatically when the system theme changes.
+ *
+ * All call sites share one process-wide state: reading it costs no D-Bus call and
+ * registers no listener.
  */
 @Composable
-fun isLinuxInDarkMode(): Boolean {
-    val darkModeState = remember { mutableStateOf(LinuxPortalThemeDetector.isDark()) }
-    DisposableEffect(Unit) {
-        debugln(TAG) { "Registering Linux portal dark mode listener in Compose" }
-        val listener =
-            Consumer<Boolean> { newValue ->
-                debugln(TAG) { "Compose Linux portal dark mode updated: $newValue" }
-                darkModeState.value = newValue
-            }
-        LinuxPortalThemeDetector.registerListener(listener)
-        onDispose {
-            debugln(TAG) { "Removing Linux portal dark mode listener in Compose" }
-            LinuxPortalThemeDetector.removeListener(listener)
-        }
-    }
-    return darkModeState.value
-}
+fun isLinuxInDarkMode(): Boolean = LinuxPortalThemeDetector.darkMode.value
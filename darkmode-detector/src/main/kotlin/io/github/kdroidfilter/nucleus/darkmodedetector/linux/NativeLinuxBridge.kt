@@ -1,7 +1,8 @@
 package io.github.kdroidfilter.nucleus.darkmodedetector.linux
 
+import io.github.kdroidfilter.nucleus.core.runtime.NativeLibraryLoader
+import io.github.kdroidfilter.nucleus.core.runtime.NucleusNativeStats
 import io.github.kdroidfilter.nucleus.darkmodedetector.debugln
-import java.nio.file.Files
 import java.util.concurrent.ConcurrentHashMap
 import java.util.function.Consumer
 import java.util.logging.Level
@@ -12,6 +13,26 @@ private const val TAG = "NativeLinuxBridge"
 internal object NativeLinuxBridge {
     private val logger = Logger.getLogger(NativeLinuxBridge::class.java.simpleName)
     private val listeners: MutableSet<Consumer<Boolean>> = ConcurrentHashMap.newKeySet()
+    private val settingsListeners: MutableSet<Consumer<DoubleArray>> = ConcurrentHashMap.newKeySet()
+
+    // Layout of the settings snapshot (SETTING_* in nucleus_linux_theme.c); -1.0 = not provided
+    const val SETTING_COLOR_SCHEME = 0
+    const val SETTING_CONTRAST = 1
+    const val SETTING_REDUCED_MOTION = 2
+    const val SETTING_ACCENT_RED = 3
+    const val SETTING_ACCENT_GREEN = 4
+    const val SETTING_ACCENT_BLUE = 5
+
+    // Native call statistics probes, in nativeGetStats order (PROBE_* in nucleus_linux_theme.c)
+    private val STATS_PROBES =
+        listOf(
+            "JNI_OnLoad",
+            "nativeIsDark",
+            "nativeStartObserving",
+            "nativeStopObserving",
+            "nativeGetSettings",
+            "monitor wakeup",
+        )
 
     @Volatile
     private var loaded = false
@@ -23,54 +44,66 @@ internal object NativeLinuxBridge {
     private fun loadNativeLibrary() {
         if (loaded) return
 
+        // Library path first (packaged app), else the copy bundled in the JAR,
+        // extracted once into the per-user native library cache
         try {
-            System.loadLibrary("nucleus_linux_theme")
-            loaded = true
-            return
-        } catch (_: UnsatisfiedLinkError) {
-            // Fall through to JAR extraction
-        }
-
-        @Suppress("TooGenericExceptionCaught")
-        try {
-            val arch =
-                System.getProperty("os.arch").let {
-                    if (it == "aarch64" || it == "arm64") "aarch64" else "x64"
-                }
-            val resourcePath = "/nucleus/native/linux-$arch/libnucleus_linux_theme.so"
-            val stream =
-                NativeLinuxBridge::class.java
-                    .getResourceAsStream(resourcePath)
-                    ?: throw UnsatisfiedLinkError("Native library not found in JAR at $resourcePath")
-            val tempDir = Files.createTempDirectory("nucleus-native")
-            val tempLib = tempDir.resolve("libnucleus_linux_theme.so")
-            stream.use { Files.copy(it, tempLib) }
-            tempLib.toFile().deleteOnExit()
-            tempDir.toFile().deleteOnExit()
-            System.load(tempLib.toAbsolutePath().toString())
+            NativeLibraryLoader.load(NativeLinuxBridge::class.java, "nucleus_linux_theme") { System.load(it) }
             loaded = true
-        } catch (e: Exception) {
+            NucleusNativeStats.register("nucleus_linux_theme", STATS_PROBES, ::nativeGetStats, ::nativeSetStatsEnabled)
+        } catch (e: UnsatisfiedLinkError) {
             logger.log(Level.WARNING, "Failed to load nucleus_linux_theme native library", e)
         }
     }
 
     val isLoaded: Boolean get() = loaded
 
+    // While observing, a lock-free read of the value the monitor thread keeps
+    // current (one portal Read at start, then SettingChanged). Otherwise a
+    // blocking portal Read.
     @JvmStatic
     external fun nativeIsDark(): Boolean
 
     @JvmStatic
     external fun nativeStartObserving()
 
+    // Returns immediately: the monitor thread is woken through an eventfd.
     @JvmStatic
     external fun nativeStopObserving()
 
+    // Monitor thread counters since load: { poll() wakeups, wakeups with D-Bus
+    // fd activity, messages dispatched }. The thread never wakes on its own,
+    // so the first two only move with bus traffic or a stop request.
+    @JvmStatic
+    external fun nativeGetMonitorStats(): LongArray
+
+    // Settings snapshot kept by the monitor thread (one ReadAll at start, then
+    // SettingChanged), or null when not observing.
+    @JvmStatic
+    external fun nativeGetSettings(): DoubleArray?
+
+    // Call statistics, read through NucleusNativeStats: { calls, errors, total nanos,
+    // max nanos } per STATS_PROBES entry.
+    @JvmStatic
+    private external fun nativeGetStats(): LongArray
+
+    @JvmStatic
+    private external fun nativeSetStatsEnabled(enabled: Boolean)
+
+    // Called on the monitor thread with the final state of a burst of
+    // SettingChanged signals, only when dark-ness actually changed.
     @JvmStatic
     fun onThemeChanged(isDark: Boolean) {
         debugln(TAG) { "Theme change detected via JNI. Dark mode: $isDark" }
         listeners.forEach { it.accept(isDark) }
     }
 
+    // Called once per burst of SettingChanged signals, with the whole snapshot
+    @JvmStatic
+    fun onSettingsChanged(values: DoubleArray) {
+        debugln(TAG) { "Portal settings changed via JNI: ${values.contentToString()}" }
+        settingsListeners.forEach { it.accept(values) }
+    }
+
     fun registerListener(listener: Consumer<Boolean>) {
         listeners.add(listener)
     }
@@ -78,4 +111,12 @@ internal object NativeLinuxBridge {
     fun removeListener(listener: Consumer<Boolean>) {
         listeners.remove(listener)
     }
+
+    fun registerSettingsListener(listener: Consumer<DoubleArray>) {
+        settingsListeners.add(listener)
+    }
+
+    fun removeSettingsListener(listener: Consumer<DoubleArray>) {
+        settingsListeners.remove(listener)
+    }
 }
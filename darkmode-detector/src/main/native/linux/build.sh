@@ -10,6 +10,8 @@ set -euo pipefail
 SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
 SRC="$SCRIPT_DIR/nucleus_linux_theme.c"
 RESOURCE_DIR="$SCRIPT_DIR/../../resources/nucleus/native"
+# nucleus_native_stats.h, shared by the Linux bridges
+STATS_INCLUDE="$SCRIPT_DIR/../../../../../core-runtime/src/main/native/include"
 
 # Detect host architecture
 MACHINE="$(uname -m)"
@@ -50,12 +52,18 @@ fi
 DBUS_CFLAGS=$(pkg-config --cflags dbus-1)
 DBUS_LIBS=$(pkg-config --libs dbus-1)
 
+# Size and SHA-256 of a built library, read by core-runtime's NativeLibraryLoader
+# to find its extraction cache entry without hashing the library at runtime
+write_manifest() {
+    printf 'size=%s\nsha256=%s\n' "$(wc -c < "$1" | tr -d ' ')" "$(sha256sum "$1" | cut -d' ' -f1)" > "$1.manifest"
+}
+
 mkdir -p "$OUT_DIR"
 
 echo "Compiling for $MACHINE ($ARCH)..."
 gcc -o "$OUT_DIR/libnucleus_linux_theme.so" "$SRC" \
     -shared -fPIC \
-    -I"$JNI_INCLUDE" -I"$JNI_INCLUDE_LINUX" \
+    -I"$JNI_INCLUDE" -I"$JNI_INCLUDE_LINUX" -I"$STATS_INCLUDE" \
     $DBUS_CFLAGS \
     -Os                     \
     -flto                   \
@@ -65,7 +73,9 @@ gcc -o "$OUT_DIR/libnucleus_linux_theme.so" "$SRC" \
     -fdata-sections         \
     -s                      \
     -lpthread               \
+    -ldl                    \
     $DBUS_LIBS
+write_manifest "$OUT_DIR/libnucleus_linux_theme.so"
 
 echo "Built linux-$ARCH .so:"
 ls -lh "$OUT_DIR/libnucleus_linux_theme.so"
@@ -5,25 +5,129 @@
  *   - Read the "color-scheme" preference (org.freedesktop.appearance namespace)
  *   - Monitor for SettingChanged signals in real-time
  *
+ * While observing, the monitor keeps the last known color-scheme in an
+ * atomic (one Read at start, then SettingChanged updates), so nativeIsDark
+ * is a plain load that never waits on D-Bus.
+ *
+ * The monitor thread sleeps in poll() on the connection's D-Bus watch fds
+ * and an eventfd: it only wakes for bus traffic or to stop, and stopping
+ * returns as soon as the thread sees the eventfd.
+ *
+ * Beyond color-scheme, the monitor tracks a table of portal settings
+ * (accent-color, contrast, reduced-motion) as one typed snapshot: fetched
+ * with a single ReadAll, updated from SettingChanged, and delivered to
+ * onSettingsChanged once per burst of signals.
+ *
+ * The monitor thread is attached to the JVM once, as a daemon, for its whole
+ * life; the bridge class and callback method IDs are resolved in JNI_OnLoad.
+ * Callbacks are coalesced: a burst of signals (a theme switch changes
+ * several keys, sometimes color-scheme more than once) is delivered once,
+ * after COALESCE_QUIET_MS without further changes, and only if the final
+ * state differs from what Java last saw.
+ *
+ * The portal is probed once with NameHasOwner (never bus-activated), and the
+ * answer is cached. Without it — minimal WMs, kiosk images — the preference
+ * comes from GSettings (libgio, dlopen'd) or KDE's kdeglobals, and the
+ * monitor watches the files those write with inotify instead.
+ *
  * color-scheme values: 0 = no preference, 1 = prefer-dark, 2 = prefer-light
  *
- * Linked libraries: libdbus-1 (dynamically)
+ * Each JNI entry point and each monitor wakeup is a probe of
+ * nucleus_native_stats.h (core-runtime), read through NucleusNativeStats.
+ *
+ * Linked libraries: libdbus-1 (dynamically), libgio-2.0 (dlopen, optional)
  */
 
 #include <jni.h>
 #include <dbus/dbus.h>
+#include <dlfcn.h>
+#include <poll.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef NUCLEUS_LINUX_COMBINED
+/* Built into libnucleus_linux, which runs these when NativeLinuxBridge loads */
+#include "nucleus_linux_combined.h"
+#define JNI_OnLoad   nucleus_theme_OnLoad
+#define JNI_OnUnload nucleus_theme_OnUnload
+#endif
+
+/* Call statistics probes (must match STATS_PROBES in NativeLinuxBridge.kt) */
+enum {
+    PROBE_ON_LOAD,
+    PROBE_IS_DARK,
+    PROBE_START_OBSERVING,
+    PROBE_STOP_OBSERVING,
+    PROBE_GET_SETTINGS,
+    PROBE_MONITOR_WAKEUP,
+    PROBE_COUNT
+};
+#define NUCLEUS_STATS_PROBES PROBE_COUNT
+#include "nucleus_native_stats.h"
 
 /* Cached JavaVM pointer, set in JNI_OnLoad */
 static JavaVM *g_jvm = NULL;
 
+/* NativeLinuxBridge (global ref) and its callbacks, resolved in JNI_OnLoad.
+ * NULL if the class could not be resolved: monitoring then only keeps the
+ * cached values current. */
+static jclass g_bridge_class = NULL;
+static jmethodID g_on_theme_changed = NULL;     /* (Z)V  */
+static jmethodID g_on_settings_changed = NULL;  /* ([D)V */
+
+/* A burst is delivered once it has been quiet for COALESCE_QUIET_MS, or
+ * COALESCE_MAX_MS after it started if changes keep coming */
+#define COALESCE_QUIET_MS 50
+#define COALESCE_MAX_MS   500
+
 /* D-Bus connection used by the monitoring thread */
 static DBusConnection *g_conn = NULL;
 
-/* Monitoring thread handle */
+/* Monitoring thread handle. g_running stays set until nativeStopObserving
+ * (or the next nativeStartObserving) joins the thread; g_thread_exited is set
+ * when the thread ran out of things to watch and stopped on its own. */
 static pthread_t g_thread;
 static volatile int g_running = 0;
+static atomic_int g_thread_exited;
+
+/* Wakes the monitor thread out of poll() to stop it */
+static int g_wake_fd = -1;
+
+/* D-Bus watches of g_conn, maintained by the watch callbacks */
+#define MAX_WATCHES 8
+static DBusWatch *g_watches[MAX_WATCHES];
+static int g_watch_count = 0;
+
+/* Monitor wakeup counters, see nativeGetMonitorStats() */
+static atomic_long g_stat_wakeups;      /* poll() returns            */
+static atomic_long g_stat_bus_wakeups;  /* ...with D-Bus fd activity */
+static atomic_long g_stat_messages;     /* messages dispatched       */
+
+/* Last known color-scheme while observing: 0/1/2 as reported by the portal,
+ * SCHEME_NONE if the portal had no value, SCHEME_UNKNOWN when not observing */
+#define SCHEME_UNKNOWN (-2)
+#define SCHEME_NONE    (-1)
+static atomic_int g_color_scheme = SCHEME_UNKNOWN;
+
+/* Whether the portal owns its bus name: probed with NameHasOwner and cached,
+ * then kept current by NameOwnerChanged while observing. Without that
+ * signal an absent portal is probed again after PORTAL_ABSENT_TTL_MS, so
+ * one started later (e.g. by a slow session) is still picked up. */
+#define PORTAL_UNKNOWN 0
+#define PORTAL_PRESENT 1
+#define PORTAL_ABSENT  2
+#define PORTAL_ABSENT_TTL_MS 5000
+static atomic_int g_portal_state = PORTAL_UNKNOWN;
+static _Atomic int64_t g_portal_absent_since;  /* monotonic ms of the ABSENT answer */
 
 /* Portal constants */
 static const char *PORTAL_BUS   = "org.freedesktop.portal.Desktop";
@@ -34,10 +138,327 @@ static const char *COLOR_SCHEME  = "color-scheme";
 
 JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
     (void)reserved;
+    NUCLEUS_STATS_STARTUP_SCOPE(PROBE_ON_LOAD);
     g_jvm = vm;
+
+    JNIEnv *env = NULL;
+    if ((*vm)->GetEnv(vm, (void **)&env, JNI_VERSION_1_8) != JNI_OK) {
+        NUCLEUS_STATS_FAIL();
+        return JNI_VERSION_1_8;
+    }
+    /* Loaded from NativeLinuxBridge's initializer: FindClass resolves it
+     * through the right class loader here, unlike on the monitor thread */
+    jclass cls = (*env)->FindClass(env,
+        "io/github/kdroidfilter/nucleus/darkmodedetector/linux/NativeLinuxBridge");
+    if (cls != NULL) {
+        g_on_theme_changed = (*env)->GetStaticMethodID(env, cls, "onThemeChanged", "(Z)V");
+        g_on_settings_changed = (*env)->GetStaticMethodID(env, cls, "onSettingsChanged", "([D)V");
+        if (g_on_theme_changed != NULL && g_on_settings_changed != NULL) {
+            g_bridge_class = (jclass)(*env)->NewGlobalRef(env, cls);
+        }
+        (*env)->DeleteLocalRef(env, cls);
+    }
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+    }
+    if (g_bridge_class == NULL) NUCLEUS_STATS_FAIL();
     return JNI_VERSION_1_8;
 }
 
+JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved) {
+    (void)reserved;
+    JNIEnv *env = NULL;
+    if (g_bridge_class != NULL &&
+        (*vm)->GetEnv(vm, (void **)&env, JNI_VERSION_1_8) == JNI_OK) {
+        (*env)->DeleteGlobalRef(env, g_bridge_class);
+    }
+    g_bridge_class = NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Portal-less backends                                               */
+/*  Without xdg-desktop-portal the preference is read where the        */
+/*  desktop stores it:                                                 */
+/*    GSettings  org.gnome.desktop.interface color-scheme, else a      */
+/*               "dark" gtk-theme name (libgio through dlopen)         */
+/*    KDE        kdeglobals: [Colors:Window] BackgroundNormal          */
+/*               luminance, else the [General] ColorScheme name        */
+/*  While observing, the monitor watches the files these are stored   */
+/*  in with inotify: dconf's database and kdeglobals.                 */
+/* ------------------------------------------------------------------ */
+typedef enum { FALLBACK_NONE, FALLBACK_GSETTINGS, FALLBACK_KDE } FallbackBackend;
+
+/* org.gnome.desktop.interface through libgio, resolved once. libgio is never
+ * dlclosed: GLib's type registrations cannot be unloaded. */
+typedef struct {
+    void *settings;        /* GSettings, NULL if unavailable */
+    int   hasColorScheme;  /* GNOME 42+ */
+    char *(*get_string)(void *, const char *);
+    void  (*free)(void *);
+} GioSettings;
+
+static GioSettings g_gio;
+static pthread_once_t g_gio_once = PTHREAD_ONCE_INIT;
+
+static void load_gio(void) {
+    void *lib = dlopen("libgio-2.0.so.0", RTLD_LAZY | RTLD_LOCAL);
+    if (lib == NULL) return;
+
+    typedef void *(*fn_schema_source_get_default)(void);
+    typedef void *(*fn_schema_source_lookup)(void *, const char *, int);
+    typedef int   (*fn_schema_has_key)(void *, const char *);
+    typedef void *(*fn_settings_new_full)(void *, void *, const char *);
+    typedef void  (*fn_schema_unref)(void *);
+
+    fn_schema_source_get_default gssg =
+        (fn_schema_source_get_default)dlsym(lib, "g_settings_schema_source_get_default");
+    fn_schema_source_lookup gssl =
+        (fn_schema_source_lookup)dlsym(lib, "g_settings_schema_source_lookup");
+    fn_schema_has_key gshk = (fn_schema_has_key)dlsym(lib, "g_settings_schema_has_key");
+    fn_settings_new_full gsnf = (fn_settings_new_full)dlsym(lib, "g_settings_new_full");
+    fn_schema_unref gsu = (fn_schema_unref)dlsym(lib, "g_settings_schema_unref");
+    g_gio.get_string = (char *(*)(void *, const char *))dlsym(lib, "g_settings_get_string");
+    g_gio.free = (void (*)(void *))dlsym(lib, "g_free");
+    if (!gssg || !gssl || !gshk || !gsnf || !gsu || !g_gio.get_string || !g_gio.free) return;
+
+    void *source = gssg();
+    /* Looked up first: g_settings_new() aborts the process on a missing schema */
+    void *schema = source ? gssl(source, "org.gnome.desktop.interface", 1 /* recursive */) : NULL;
+    if (schema == NULL) return;
+    if (gshk(schema, "gtk-theme")) {
+        g_gio.hasColorScheme = gshk(schema, "color-scheme");
+        g_gio.settings = gsnf(schema, NULL, NULL);
+    }
+    gsu(schema);
+}
+
+static int name_is_dark(const char *name) {
+    for (const char *p = name; *p; p++) {
+        if ((p[0] | 0x20) == 'd' && (p[1] | 0x20) == 'a' &&
+            (p[2] | 0x20) == 'r' && (p[3] | 0x20) == 'k') {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* With the dconf backend every read checks whether dconf-service has
+ * replaced the database, so values are current without a GLib main loop. */
+static int gsettings_color_scheme(void) {
+    pthread_once(&g_gio_once, load_gio);
+    if (g_gio.settings == NULL) return SCHEME_NONE;
+
+    int scheme = 0;
+    if (g_gio.hasColorScheme) {
+        char *value = g_gio.get_string(g_gio.settings, "color-scheme");
+        if (value != NULL) {
+            if (strcmp(value, "prefer-dark") == 0) scheme = 1;
+            else if (strcmp(value, "prefer-light") == 0) scheme = 2;
+            g_gio.free(value);
+        }
+    }
+    if (scheme == 0) {
+        /* Pre-42 GNOME and most GTK-based WMs only switch the theme */
+        char *theme = g_gio.get_string(g_gio.settings, "gtk-theme");
+        if (theme != NULL) {
+            if (name_is_dark(theme)) scheme = 1;
+            g_gio.free(theme);
+        }
+    }
+    return scheme;
+}
+
+/* $XDG_CONFIG_HOME (default ~/.config)[/name] into path; 0 if unknown */
+static int config_path(const char *name, char *path, size_t size) {
+    const char *configHome = getenv("XDG_CONFIG_HOME");
+    const char *home = getenv("HOME");
+    const char *sep = name ? "/" : "";
+    if (name == NULL) name = "";
+    if (configHome && configHome[0]) {
+        snprintf(path, size, "%s%s%s", configHome, sep, name);
+    } else if (home && home[0]) {
+        snprintf(path, size, "%s/.config%s%s", home, sep, name);
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+#define CONFIG_FILE_MAX (256 * 1024)
+
+/* Reads a config file into a malloc'd, NUL-terminated buffer; NULL if
+ * missing or unreasonably large */
+static char *read_config_file(const char *name) {
+    char path[1024];
+    if (!config_path(name, path, sizeof(path))) return NULL;
+
+    FILE *f = fopen(path, "r");
+    if (f == NULL) return NULL;
+    char *buf = (char *)malloc(CONFIG_FILE_MAX + 1);
+    size_t len = buf ? fread(buf, 1, CONFIG_FILE_MAX, f) : 0;
+    int tooLarge = buf && len == CONFIG_FILE_MAX && fgetc(f) != EOF;
+    fclose(f);
+    if (buf == NULL || tooLarge) {
+        free(buf);
+        return NULL;
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+/* Value of key= in [section] of a KConfig file, NULL if absent. Points into
+ * buf, which it NUL-terminates at the end of the line. */
+static char *ini_value(char *buf, const char *section, const char *key) {
+    size_t sectionLen = strlen(section), keyLen = strlen(key);
+    int inSection = 0;
+    for (char *line = buf; line && *line; ) {
+        char *next = strchr(line, '\n');
+        if (line[0] == '[') {
+            inSection = strncmp(line + 1, section, sectionLen) == 0 && line[sectionLen + 1] == ']';
+        } else if (inSection && strncmp(line, key, keyLen) == 0 && line[keyLen] == '=') {
+            if (next) *next = '\0';
+            return line + keyLen + 1;
+        }
+        line = next ? next + 1 : NULL;
+    }
+    return NULL;
+}
+
+/* "r,g,b" with 0..255 components into 0..1 doubles */
+static int parse_rgb(const char *value, double rgb[3]) {
+    int r, g, b;
+    if (value == NULL || sscanf(value, "%d,%d,%d", &r, &g, &b) != 3) return 0;
+    if (r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) return 0;
+    rgb[0] = r / 255.0;
+    rgb[1] = g / 255.0;
+    rgb[2] = b / 255.0;
+    return 1;
+}
+
+/* KDE reports dark for a dark window background, like its portal backend.
+ * accent receives [General] AccentColor when set. */
+static int kde_color_scheme(double accent[3]) {
+    char *buf = read_config_file("kdeglobals");
+    if (buf == NULL) return SCHEME_NONE;
+
+    /* ini_value cuts the buffer at the value: look keys up on copies */
+    size_t size = strlen(buf) + 1;
+    char *copy = (char *)malloc(size);
+    int scheme = 2; /* Breeze, the default, is light */
+    double bg[3];
+    if (copy != NULL) {
+        memcpy(copy, buf, size);
+        if (parse_rgb(ini_value(copy, "Colors:Window", "BackgroundNormal"), bg)) {
+            scheme = 0.2126 * bg[0] + 0.7152 * bg[1] + 0.0722 * bg[2] < 0.5 ? 1 : 2;
+        } else {
+            memcpy(copy, buf, size);
+            const char *name = ini_value(copy, "General", "ColorScheme");
+            if (name != NULL && name_is_dark(name)) scheme = 1;
+        }
+        free(copy);
+    }
+    if (!parse_rgb(ini_value(buf, "General", "AccentColor"), accent)) {
+        accent[0] = accent[1] = accent[2] = -1.0;
+    }
+    free(buf);
+    return scheme;
+}
+
+static FallbackBackend g_fallback_backend = FALLBACK_NONE;
+static pthread_once_t g_fallback_once = PTHREAD_ONCE_INIT;
+
+/* KDE sessions use kdeglobals; elsewhere GSettings, then kdeglobals for
+ * users of KDE applications under another WM */
+static void select_fallback(void) {
+    const char *desktop = getenv("XDG_CURRENT_DESKTOP");
+    char *kdeglobals = read_config_file("kdeglobals");
+    int hasKde = kdeglobals != NULL;
+    free(kdeglobals);
+
+    if (hasKde && desktop && strstr(desktop, "KDE")) {
+        g_fallback_backend = FALLBACK_KDE;
+        return;
+    }
+    pthread_once(&g_gio_once, load_gio);
+    if (g_gio.settings != NULL) {
+        g_fallback_backend = FALLBACK_GSETTINGS;
+    } else if (hasKde) {
+        g_fallback_backend = FALLBACK_KDE;
+    }
+}
+
+static FallbackBackend fallback_backend(void) {
+    pthread_once(&g_fallback_once, select_fallback);
+    return g_fallback_backend;
+}
+
+/**
+ * color-scheme from the portal-less backend, SCHEME_NONE if there is none.
+ * accent (may be NULL) receives the accent color, -1 when not provided.
+ */
+static int fallback_color_scheme(double accent[3]) {
+    double unused[3];
+    if (accent == NULL) accent = unused;
+    accent[0] = accent[1] = accent[2] = -1.0;
+    switch (fallback_backend()) {
+    case FALLBACK_GSETTINGS: return gsettings_color_scheme();
+    case FALLBACK_KDE:       return kde_color_scheme(accent);
+    default:                 return SCHEME_NONE;
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Portal probe                                                       */
+/* ------------------------------------------------------------------ */
+
+/* Whether a session bus address is known. Without one, libdbus resorts to
+ * X11 autolaunch, which spawns dbus-launch and can block for seconds. */
+static int session_bus_configured(void) {
+    const char *address = getenv("DBUS_SESSION_BUS_ADDRESS");
+    if (address && address[0]) return 1;
+    const char *runtimeDir = getenv("XDG_RUNTIME_DIR");
+    if (runtimeDir == NULL || runtimeDir[0] == '\0') return 0;
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/bus", runtimeDir);
+    return access(path, F_OK) == 0;
+}
+
+static int64_t monotonic_millis(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Whether the portal currently owns its name. NameHasOwner is answered by
+ * the bus itself, so an absent portal costs one round trip to the daemon
+ * instead of a Read that waits on bus activation; the answer is cached
+ * (an absent one only for PORTAL_ABSENT_TTL_MS when not observing).
+ */
+static int portal_available(DBusConnection *conn) {
+    int state = atomic_load_explicit(&g_portal_state, memory_order_relaxed);
+    if (state == PORTAL_PRESENT) return 1;
+    if (state == PORTAL_ABSENT) {
+        int tracked = g_running && !atomic_load(&g_thread_exited);
+        int64_t since = atomic_load_explicit(&g_portal_absent_since, memory_order_relaxed);
+        if (tracked || monotonic_millis() - since < PORTAL_ABSENT_TTL_MS) return 0;
+    }
+
+    DBusError err;
+    dbus_error_init(&err);
+    dbus_bool_t owned = dbus_bus_name_has_owner(conn, PORTAL_BUS, &err);
+    if (dbus_error_is_set(&err)) {
+        /* Bus trouble is not an answer: probe again next time */
+        dbus_error_free(&err);
+        return 0;
+    }
+    if (!owned)
+        atomic_store_explicit(&g_portal_absent_since, monotonic_millis(), memory_order_relaxed);
+    atomic_store_explicit(&g_portal_state, owned ? PORTAL_PRESENT : PORTAL_ABSENT,
+                          memory_order_relaxed);
+    return owned;
+}
+
 /**
  * Extract the color-scheme uint32 from the Read() reply.
  * The reply signature is v(v(u)) — a variant wrapping a variant wrapping a uint32.
@@ -73,25 +494,13 @@ static int extract_color_scheme(DBusMessage *reply) {
 }
 
 /**
- * Read the current color-scheme value from the portal.
- * Returns 1 if dark, 0 otherwise. Uses a private connection.
+ * Read the current color-scheme value from the portal over the given connection.
+ * Returns 0 (no pref), 1 (dark), 2 (light), or SCHEME_NONE on error.
  */
-static jboolean read_color_scheme(void) {
-    DBusError err;
-    dbus_error_init(&err);
-
-    DBusConnection *conn = dbus_bus_get(DBUS_BUS_SESSION, &err);
-    if (conn == NULL) {
-        dbus_error_free(&err);
-        return JNI_FALSE;
-    }
-
+static int read_color_scheme_on(DBusConnection *conn) {
     DBusMessage *msg = dbus_message_new_method_call(
         PORTAL_BUS, PORTAL_PATH, PORTAL_IFACE, "Read");
-    if (msg == NULL) {
-        dbus_connection_unref(conn);
-        return JNI_FALSE;
-    }
+    if (msg == NULL) return SCHEME_NONE;
 
     const char *ns = APPEARANCE_NS;
     const char *key = COLOR_SCHEME;
@@ -100,68 +509,70 @@ static jboolean read_color_scheme(void) {
         DBUS_TYPE_STRING, &key,
         DBUS_TYPE_INVALID);
 
+    DBusError err;
+    dbus_error_init(&err);
     DBusMessage *reply = dbus_connection_send_with_reply_and_block(
         conn, msg, 1000, &err);
     dbus_message_unref(msg);
 
-    jboolean result = JNI_FALSE;
+    int scheme = SCHEME_NONE;
     if (reply != NULL) {
-        int scheme = extract_color_scheme(reply);
-        if (scheme == 1) result = JNI_TRUE;
+        scheme = extract_color_scheme(reply);
+        if (scheme < 0) scheme = SCHEME_NONE;
         dbus_message_unref(reply);
     }
-
     dbus_error_free(&err);
-    dbus_connection_unref(conn);
-    return result;
+    return scheme;
+}
+
+/**
+ * Read the current color-scheme value from the portal, or from the
+ * portal-less backend when it is not running.
+ * Returns 1 if dark, 0 otherwise. Uses the shared session connection.
+ */
+static jboolean read_color_scheme(void) {
+    if (session_bus_configured()) {
+        DBusError err;
+        dbus_error_init(&err);
+        DBusConnection *conn = dbus_bus_get(DBUS_BUS_SESSION, &err);
+        dbus_error_free(&err);
+        if (conn != NULL) {
+            int available = portal_available(conn);
+            int scheme = available ? read_color_scheme_on(conn) : SCHEME_NONE;
+            dbus_connection_unref(conn);
+            if (available) return scheme == 1 ? JNI_TRUE : JNI_FALSE;
+        }
+    }
+    return fallback_color_scheme(NULL) == 1 ? JNI_TRUE : JNI_FALSE;
 }
 
 /* ------------------------------------------------------------------ */
 /*  nativeIsDark()                                                     */
+/*  Lock-free load of the monitor's cached value while observing.      */
 /* ------------------------------------------------------------------ */
 JNIEXPORT jboolean JNICALL
 Java_io_github_kdroidfilter_nucleus_darkmodedetector_linux_NativeLinuxBridge_nativeIsDark(
     JNIEnv *env, jclass clazz)
 {
     (void)env; (void)clazz;
+    NUCLEUS_STATS_SCOPE(PROBE_IS_DARK);
+    int scheme = atomic_load_explicit(&g_color_scheme, memory_order_relaxed);
+    if (scheme != SCHEME_UNKNOWN) return scheme == 1 ? JNI_TRUE : JNI_FALSE;
+
+    /* Not observing: no cached value to serve, ask the portal or fallback */
     return read_color_scheme();
 }
 
 /**
  * Notify the Kotlin bridge about a theme change.
+ * env is the monitor thread's, attached for the thread's whole life.
  */
-static void notify_java(jboolean isDark) {
-    if (g_jvm == NULL) return;
-
-    JNIEnv *env = NULL;
-    jint attached = (*g_jvm)->GetEnv(g_jvm, (void **)&env, JNI_VERSION_1_8);
-    int didAttach = 0;
-    if (attached == JNI_EDETACHED) {
-        if ((*g_jvm)->AttachCurrentThreadAsDaemon(g_jvm, (void **)&env, NULL) != JNI_OK) {
-            return;
-        }
-        didAttach = 1;
-    } else if (attached != JNI_OK) {
-        return;
-    }
-
-    jclass bridgeClass = (*env)->FindClass(env,
-        "io/github/kdroidfilter/nucleus/darkmodedetector/linux/NativeLinuxBridge");
-    if (bridgeClass != NULL) {
-        jmethodID method = (*env)->GetStaticMethodID(env,
-            bridgeClass, "onThemeChanged", "(Z)V");
-        if (method != NULL) {
-            (*env)->CallStaticVoidMethod(env, bridgeClass, method, isDark);
-        }
-    }
-
+static void notify_java(JNIEnv *env, jboolean isDark) {
+    if (g_bridge_class == NULL) return;
+    (*env)->CallStaticVoidMethod(env, g_bridge_class, g_on_theme_changed, isDark);
     if ((*env)->ExceptionCheck(env)) {
         (*env)->ExceptionClear(env);
     }
-
-    if (didAttach) {
-        (*g_jvm)->DetachCurrentThread(g_jvm);
-    }
 }
 
 /**
@@ -199,64 +610,605 @@ static int extract_signal_color_scheme(DBusMessage *msg) {
     return -1;
 }
 
+/* ------------------------------------------------------------------ */
+/*  Portal settings snapshot                                           */
+/*  SETTING_KEYS maps portal namespace/key pairs to slots of a flat    */
+/*  double array, which is also the layout handed to Java              */
+/*  (NativeLinuxBridge.SETTING_*). -1 marks a value the portal does    */
+/*  not provide.                                                       */
+/* ------------------------------------------------------------------ */
+enum {
+    SETTING_COLOR_SCHEME = 0,  /* 0 no preference, 1 dark, 2 light          */
+    SETTING_CONTRAST,          /* 0 no preference, 1 high                   */
+    SETTING_REDUCED_MOTION,    /* 0 no preference, 1 reduced                */
+    SETTING_ACCENT_RED,        /* sRGB 0..1, followed by green and blue     */
+    SETTING_ACCENT_GREEN,
+    SETTING_ACCENT_BLUE,
+    SETTING_COUNT
+};
+
+typedef enum { VALUE_UINT32, VALUE_RGB } SettingType;
+
+typedef struct {
+    const char  *ns;
+    const char  *key;
+    SettingType  type;
+    int          slot;
+} SettingKey;
+
+static const SettingKey SETTING_KEYS[] = {
+    { "org.freedesktop.appearance", "color-scheme",   VALUE_UINT32, SETTING_COLOR_SCHEME },
+    { "org.freedesktop.appearance", "contrast",       VALUE_UINT32, SETTING_CONTRAST },
+    { "org.freedesktop.appearance", "reduced-motion", VALUE_UINT32, SETTING_REDUCED_MOTION },
+    { "org.freedesktop.appearance", "accent-color",   VALUE_RGB,    SETTING_ACCENT_RED },
+};
+#define SETTING_KEY_COUNT (int)(sizeof(SETTING_KEYS) / sizeof(SETTING_KEYS[0]))
+
+/* Namespaces requested by ReadAll */
+static const char *SETTING_NAMESPACES[] = { "org.freedesktop.appearance" };
+#define SETTING_NAMESPACE_COUNT (int)(sizeof(SETTING_NAMESPACES) / sizeof(SETTING_NAMESPACES[0]))
+
+/* Current snapshot (monitor thread writes, any thread reads) and the last
+ * one delivered to Java (monitor thread only) */
+static pthread_mutex_t g_settings_lock = PTHREAD_MUTEX_INITIALIZER;
+static double g_settings[SETTING_COUNT];
+static double g_delivered[SETTING_COUNT];
+
+static void reset_settings(double *values) {
+    for (int i = 0; i < SETTING_COUNT; i++) values[i] = -1.0;
+}
+
+static const SettingKey *find_setting(const char *ns, const char *key) {
+    for (int i = 0; i < SETTING_KEY_COUNT; i++) {
+        if (strcmp(SETTING_KEYS[i].ns, ns) == 0 && strcmp(SETTING_KEYS[i].key, key) == 0) {
+            return &SETTING_KEYS[i];
+        }
+    }
+    return NULL;
+}
+
+/* Steps into (possibly nested) variants: portals differ in how many they wrap */
+static void unwrap_variant(DBusMessageIter *iter, DBusMessageIter *out) {
+    *out = *iter;
+    while (dbus_message_iter_get_arg_type(out) == DBUS_TYPE_VARIANT) {
+        DBusMessageIter inner;
+        dbus_message_iter_recurse(out, &inner);
+        *out = inner;
+    }
+}
+
+/* Decodes one value into values[]. Returns 1 if it was understood. */
+static int decode_setting(const SettingKey *setting, DBusMessageIter *value, double *values) {
+    DBusMessageIter v;
+    unwrap_variant(value, &v);
+
+    switch (setting->type) {
+    case VALUE_UINT32:
+        if (dbus_message_iter_get_arg_type(&v) != DBUS_TYPE_UINT32) return 0;
+        dbus_uint32_t u;
+        dbus_message_iter_get_basic(&v, &u);
+        values[setting->slot] = (double)u;
+        return 1;
+    case VALUE_RGB: {
+        if (dbus_message_iter_get_arg_type(&v) != DBUS_TYPE_STRUCT) return 0;
+        DBusMessageIter field;
+        double rgb[3];
+        dbus_message_iter_recurse(&v, &field);
+        for (int i = 0; i < 3; i++) {
+            if (dbus_message_iter_get_arg_type(&field) != DBUS_TYPE_DOUBLE) return 0;
+            dbus_message_iter_get_basic(&field, &rgb[i]);
+            dbus_message_iter_next(&field);
+        }
+        /* Out-of-range components mean "no accent color" */
+        int valid = 1;
+        for (int i = 0; i < 3; i++) valid &= rgb[i] >= 0.0 && rgb[i] <= 1.0;
+        for (int i = 0; i < 3; i++) values[setting->slot + i] = valid ? rgb[i] : -1.0;
+        return 1;
+    }
+    }
+    return 0;
+}
+
 /**
- * Monitoring thread: listens for SettingChanged signals on the session bus.
+ * Fetch every table namespace with one ReadAll call.
+ * Reply signature: a{sa{sv}} — namespace → (key → value).
+ * Returns 1 on success; values[] keeps -1 for keys the portal lacks.
  */
-static void *monitor_thread(void *arg) {
-    (void)arg;
+static int read_all_settings(DBusConnection *conn, double *values) {
+    reset_settings(values);
+    DBusMessage *msg = dbus_message_new_method_call(
+        PORTAL_BUS, PORTAL_PATH, PORTAL_IFACE, "ReadAll");
+    if (msg == NULL) return 0;
+
+    DBusMessageIter args, array;
+    dbus_message_iter_init_append(msg, &args);
+    dbus_message_iter_open_container(&args, DBUS_TYPE_ARRAY, DBUS_TYPE_STRING_AS_STRING, &array);
+    for (int i = 0; i < SETTING_NAMESPACE_COUNT; i++) {
+        dbus_message_iter_append_basic(&array, DBUS_TYPE_STRING, &SETTING_NAMESPACES[i]);
+    }
+    dbus_message_iter_close_container(&args, &array);
+
+    DBusError err;
+    dbus_error_init(&err);
+    DBusMessage *reply = dbus_connection_send_with_reply_and_block(conn, msg, 1000, &err);
+    dbus_message_unref(msg);
+    dbus_error_free(&err);
+    if (reply == NULL) return 0;
+
+    DBusMessageIter iter, namespaces;
+    int ok = dbus_message_iter_init(reply, &iter) &&
+             dbus_message_iter_get_arg_type(&iter) == DBUS_TYPE_ARRAY;
+    if (ok) {
+        dbus_message_iter_recurse(&iter, &namespaces);
+        while (dbus_message_iter_get_arg_type(&namespaces) == DBUS_TYPE_DICT_ENTRY) {
+            DBusMessageIter nsEntry, keys;
+            const char *ns;
+            dbus_message_iter_recurse(&namespaces, &nsEntry);
+            dbus_message_iter_get_basic(&nsEntry, &ns);
+            dbus_message_iter_next(&nsEntry);
+            dbus_message_iter_recurse(&nsEntry, &keys);
+            while (dbus_message_iter_get_arg_type(&keys) == DBUS_TYPE_DICT_ENTRY) {
+                DBusMessageIter keyEntry;
+                const char *key;
+                dbus_message_iter_recurse(&keys, &keyEntry);
+                dbus_message_iter_get_basic(&keyEntry, &key);
+                dbus_message_iter_next(&keyEntry);
+                const SettingKey *setting = find_setting(ns, key);
+                if (setting != NULL) decode_setting(setting, &keyEntry, values);
+                dbus_message_iter_next(&keys);
+            }
+            dbus_message_iter_next(&namespaces);
+        }
+    }
+    dbus_message_unref(reply);
+    return ok;
+}
+
+/**
+ * Apply a SettingChanged signal (s s v) to the snapshot.
+ * Returns 1 if it concerned a tracked key.
+ */
+static int apply_setting_changed(DBusMessage *msg) {
+    DBusMessageIter iter;
+    const char *ns, *key;
+    if (!dbus_message_iter_init(msg, &iter)) return 0;
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING) return 0;
+    dbus_message_iter_get_basic(&iter, &ns);
+    if (!dbus_message_iter_next(&iter)) return 0;
+    if (dbus_message_iter_get_arg_type(&iter) != DBUS_TYPE_STRING) return 0;
+    dbus_message_iter_get_basic(&iter, &key);
+    if (!dbus_message_iter_next(&iter)) return 0;
+
+    const SettingKey *setting = find_setting(ns, key);
+    if (setting == NULL) return 0;
+
+    pthread_mutex_lock(&g_settings_lock);
+    int applied = decode_setting(setting, &iter, g_settings);
+    pthread_mutex_unlock(&g_settings_lock);
+    return applied;
+}
+
+/* Portal snapshot: ReadAll, or just the color-scheme Read for portals
+ * without ReadAll */
+static void read_portal_settings(DBusConnection *conn, double *values) {
+    if (!read_all_settings(conn, values)) {
+        int scheme = read_color_scheme_on(conn);
+        if (scheme >= 0) values[SETTING_COLOR_SCHEME] = scheme;
+    }
+}
+
+/* Snapshot from the portal-less backend: color-scheme and, on KDE, accent */
+static void read_fallback_settings(double *values) {
+    reset_settings(values);
+    int scheme = fallback_color_scheme(&values[SETTING_ACCENT_RED]);
+    if (scheme >= 0) values[SETTING_COLOR_SCHEME] = scheme;
+}
+
+/* Publish a snapshot to nativeGetSettings and nativeIsDark */
+static void store_settings(const double *values) {
+    pthread_mutex_lock(&g_settings_lock);
+    memcpy(g_settings, values, sizeof(g_settings));
+    pthread_mutex_unlock(&g_settings_lock);
+    int scheme = values[SETTING_COLOR_SCHEME] >= 0 ? (int)values[SETTING_COLOR_SCHEME] : SCHEME_NONE;
+    atomic_store_explicit(&g_color_scheme, scheme, memory_order_relaxed);
+}
+
+/* Dark-ness last delivered to onThemeChanged: -1 none yet (monitor thread only) */
+static int g_delivered_dark = -1;
+
+/**
+ * Deliver the final state of a burst: onThemeChanged if dark-ness changed,
+ * onSettingsChanged([D)V if the snapshot differs from the last delivery.
+ * Identical values are dropped.
+ */
+static void deliver_changes(JNIEnv *env) {
+    int scheme = atomic_load_explicit(&g_color_scheme, memory_order_relaxed);
+    int dark = scheme == 1;
+    if (scheme >= SCHEME_NONE && dark != g_delivered_dark) {
+        g_delivered_dark = dark;
+        if (env != NULL) notify_java(env, dark ? JNI_TRUE : JNI_FALSE);
+    }
+
+    double values[SETTING_COUNT];
+    pthread_mutex_lock(&g_settings_lock);
+    memcpy(values, g_settings, sizeof(values));
+    pthread_mutex_unlock(&g_settings_lock);
+    if (memcmp(values, g_delivered, sizeof(values)) == 0) return;
+    memcpy(g_delivered, values, sizeof(values));
+
+    if (env == NULL || g_bridge_class == NULL) return;
+    jdoubleArray array = (*env)->NewDoubleArray(env, SETTING_COUNT);
+    if (array != NULL) {
+        (*env)->SetDoubleArrayRegion(env, array, 0, SETTING_COUNT, values);
+        (*env)->CallStaticVoidMethod(env, g_bridge_class, g_on_settings_changed, array);
+        (*env)->DeleteLocalRef(env, array);
+    }
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  D-Bus watch callbacks                                              */
+/*  libdbus tells us which fds to wait on and for what; the monitor   */
+/*  thread polls exactly those, plus the stop eventfd.                 */
+/* ------------------------------------------------------------------ */
+static dbus_bool_t add_watch(DBusWatch *watch, void *data) {
+    (void)data;
+    if (g_watch_count == MAX_WATCHES) return FALSE;
+    g_watches[g_watch_count++] = watch;
+    return TRUE;
+}
+
+static void remove_watch(DBusWatch *watch, void *data) {
+    (void)data;
+    for (int i = 0; i < g_watch_count; i++) {
+        if (g_watches[i] == watch) {
+            g_watches[i] = g_watches[--g_watch_count];
+            return;
+        }
+    }
+}
+
+/* Enabled state is read from the watch at each poll() */
+static void toggle_watch(DBusWatch *watch, void *data) {
+    (void)watch; (void)data;
+}
+
+static int watch_is_registered(DBusWatch *watch) {
+    for (int i = 0; i < g_watch_count; i++) {
+        if (g_watches[i] == watch) return 1;
+    }
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Fallback file watches                                              */
+/*  Writers replace these files (write + rename), so the watches are  */
+/*  on the directories, filtered by name. The config directory is     */
+/*  always watched: it holds kdeglobals, and dconf/ may only appear   */
+/*  with the first GSettings write.                                   */
+/* ------------------------------------------------------------------ */
+#define WATCH_MASK (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE)
+
+static int g_inotify_fd = -1;
+static int g_wd_config = -1;  /* $XDG_CONFIG_HOME       */
+static int g_wd_dconf = -1;   /* $XDG_CONFIG_HOME/dconf */
+
+static void watch_dconf_dir(void) {
+    char path[1024];
+    if (g_wd_dconf < 0 && config_path("dconf", path, sizeof(path))) {
+        g_wd_dconf = inotify_add_watch(g_inotify_fd, path, WATCH_MASK | IN_ONLYDIR);
+    }
+}
+
+/* Returns 1 if watching (or already watching) the backend's files */
+static int start_fallback_watch(void) {
+    if (g_inotify_fd >= 0) return 1;
+    FallbackBackend backend = fallback_backend();
+    char path[1024];
+    if (backend == FALLBACK_NONE || !config_path(NULL, path, sizeof(path))) return 0;
+
+    g_inotify_fd = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (g_inotify_fd < 0) return 0;
+    g_wd_config = inotify_add_watch(g_inotify_fd, path, WATCH_MASK | IN_ONLYDIR);
+    if (backend == FALLBACK_GSETTINGS) watch_dconf_dir();
+    return 1;
+}
+
+static void stop_fallback_watch(void) {
+    if (g_inotify_fd < 0) return;
+    close(g_inotify_fd);
+    g_inotify_fd = -1;
+    g_wd_config = g_wd_dconf = -1;
+}
+
+/* Drain the inotify queue; returns 1 if the backend's file changed */
+static int read_fallback_events(void) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    int gsettings = fallback_backend() == FALLBACK_GSETTINGS;
+    int changed = 0;
+    ssize_t len;
+    while ((len = read(g_inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + len; ) {
+            const struct inotify_event *ev = (const struct inotify_event *)p;
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->len == 0) continue;
+            if (ev->wd == g_wd_config) {
+                if (gsettings && strcmp(ev->name, "dconf") == 0) {
+                    watch_dconf_dir();
+                    changed = 1;
+                } else if (!gsettings && strcmp(ev->name, "kdeglobals") == 0) {
+                    changed = 1;
+                }
+            } else if (ev->wd == g_wd_dconf && strcmp(ev->name, "user") == 0) {
+                changed = 1;
+            }
+        }
+    }
+    return changed;
+}
+
+/**
+ * Open the monitor's private connection and subscribe to SettingChanged.
+ * Returns NULL if the session bus is unavailable.
+ */
+static DBusConnection *open_monitor_connection(void) {
     DBusError err;
     dbus_error_init(&err);
 
     /* Use a private connection so closing it doesn't affect the shared one */
-    g_conn = dbus_bus_get_private(DBUS_BUS_SESSION, &err);
-    if (g_conn == NULL) {
+    DBusConnection *conn = dbus_bus_get_private(DBUS_BUS_SESSION, &err);
+    if (conn == NULL) {
         dbus_error_free(&err);
         return NULL;
     }
+    dbus_connection_set_exit_on_disconnect(conn, FALSE);
 
     /* Subscribe to SettingChanged signal */
-    dbus_bus_add_match(g_conn,
+    dbus_bus_add_match(conn,
         "type='signal',"
         "interface='org.freedesktop.portal.Settings',"
         "member='SettingChanged',"
         "path='/org/freedesktop/portal/desktop'",
         &err);
+    /* ...and to the portal starting or exiting, to switch backends */
+    if (!dbus_error_is_set(&err)) {
+        dbus_bus_add_match(conn,
+            "type='signal',"
+            "sender='org.freedesktop.DBus',"
+            "interface='org.freedesktop.DBus',"
+            "member='NameOwnerChanged',"
+            "arg0='org.freedesktop.portal.Desktop'",
+            &err);
+    }
     if (dbus_error_is_set(&err)) {
         dbus_error_free(&err);
-        dbus_connection_close(g_conn);
-        dbus_connection_unref(g_conn);
-        g_conn = NULL;
+        dbus_connection_close(conn);
+        dbus_connection_unref(conn);
+        return NULL;
+    }
+    dbus_connection_flush(conn);
+
+    g_watch_count = 0;
+    if (!dbus_connection_set_watch_functions(conn, add_watch, remove_watch,
+                                             toggle_watch, NULL, NULL)) {
+        dbus_connection_close(conn);
+        dbus_connection_unref(conn);
         return NULL;
     }
-    dbus_connection_flush(g_conn);
+    return conn;
+}
+
+/* handle_message() results */
+#define MESSAGE_CHANGED      1  /* a tracked setting or the color-scheme   */
+#define MESSAGE_PORTAL_OWNER 2  /* the portal started or exited           */
+
+static int handle_message(DBusMessage *msg) {
+    atomic_fetch_add_explicit(&g_stat_messages, 1, memory_order_relaxed);
+
+    if (dbus_message_is_signal(msg, "org.freedesktop.DBus", "NameOwnerChanged")) {
+        const char *name, *oldOwner, *newOwner;
+        if (!dbus_message_get_args(msg, NULL,
+                DBUS_TYPE_STRING, &name,
+                DBUS_TYPE_STRING, &oldOwner,
+                DBUS_TYPE_STRING, &newOwner,
+                DBUS_TYPE_INVALID) ||
+            strcmp(name, PORTAL_BUS) != 0) {
+            return 0;
+        }
+        atomic_store_explicit(&g_portal_state,
+            newOwner[0] ? PORTAL_PRESENT : PORTAL_ABSENT, memory_order_relaxed);
+        return MESSAGE_PORTAL_OWNER;
+    }
+
+    if (!dbus_message_is_signal(msg,
+            "org.freedesktop.portal.Settings", "SettingChanged")) {
+        return 0;
+    }
+
+    int changed = apply_setting_changed(msg);
+    int scheme = extract_signal_color_scheme(msg);
+    if (scheme >= 0) {
+        atomic_store_explicit(&g_color_scheme, scheme, memory_order_relaxed);
+        changed = 1;
+    }
+    return changed ? MESSAGE_CHANGED : 0;
+}
+
+/**
+ * Snapshot from whichever source serves now: the portal when it owns its
+ * name (connection available), otherwise the fallback backend, watched.
+ */
+static void read_current_settings(DBusConnection *conn, double *values) {
+    if (conn != NULL && portal_available(conn)) {
+        stop_fallback_watch();
+        read_portal_settings(conn, values);
+    } else {
+        start_fallback_watch();
+        read_fallback_settings(values);
+    }
+}
 
-    /* Dispatch loop */
-    while (g_running) {
-        /* Block for up to 500ms waiting for messages */
-        if (!dbus_connection_read_write(g_conn, 500)) {
-            break; /* connection closed */
+/**
+ * Monitoring thread: listens for SettingChanged signals on the session bus,
+ * or for fallback file changes, and keeps g_color_scheme current. Blocks in
+ * poll() with no timeout, except while a burst of changes is pending
+ * delivery. g_conn is NULL when there is no session bus.
+ */
+static void *monitor_thread(void *arg) {
+    (void)arg;
+    struct pollfd fds[MAX_WATCHES + 2];
+    DBusWatch *polled[MAX_WATCHES + 2];
+
+    /* Attached once; the daemon flag keeps it from holding up JVM exit */
+    JNIEnv *env = NULL;
+    if (g_jvm != NULL) {
+        JavaVMAttachArgs attachArgs = { JNI_VERSION_1_8, "nucleus-portal-monitor", NULL };
+        if ((*g_jvm)->AttachCurrentThreadAsDaemon(g_jvm, (void **)&env, &attachArgs) != JNI_OK) {
+            env = NULL;
         }
+    }
+
+    /* Pending burst: 0 when none, else when it started / last changed */
+    int64_t burstStart = 0, burstLast = 0;
+    int changed = 0;  /* carried over from the fallback watch */
+
+    /* Work done for one wakeup: from poll() returning to the next poll() */
+    NucleusStatsScope wakeup = { PROBE_MONITOR_WAKEUP, 0, 0 };
 
+    for (;;) {
+        /* Dispatch everything already read, including messages queued
+         * while nativeStartObserving did its initial Read */
         DBusMessage *msg;
-        while ((msg = dbus_connection_pop_message(g_conn)) != NULL) {
-            if (dbus_message_is_signal(msg,
-                    "org.freedesktop.portal.Settings", "SettingChanged")) {
-                int scheme = extract_signal_color_scheme(msg);
-                if (scheme >= 0) {
-                    notify_java(scheme == 1 ? JNI_TRUE : JNI_FALSE);
-                }
-            }
+        int results = 0;
+        while (g_conn != NULL && (msg = dbus_connection_pop_message(g_conn)) != NULL) {
+            results |= handle_message(msg);
             dbus_message_unref(msg);
         }
+        if (results & MESSAGE_PORTAL_OWNER) {
+            /* Switch source; the blocking ReadAll only happens on a portal
+             * that just took its name */
+            double values[SETTING_COUNT];
+            read_current_settings(g_conn, values);
+            store_settings(values);
+        }
+        changed |= results != 0;
+
+        int64_t now = monotonic_millis();
+        if (changed) {
+            if (burstStart == 0) burstStart = now;
+            burstLast = now;
+        }
+        int timeout = -1;
+        if (burstStart != 0) {
+            int64_t due = burstLast + COALESCE_QUIET_MS;
+            if (due > burstStart + COALESCE_MAX_MS) due = burstStart + COALESCE_MAX_MS;
+            if (now >= due) {
+                deliver_changes(env);
+                burstStart = 0;
+            } else {
+                timeout = (int)(due - now);
+            }
+        }
+        changed = 0;
+        if (g_conn != NULL && !dbus_connection_get_is_connected(g_conn)) {
+            wakeup.failed = 1;
+            dbus_connection_close(g_conn);
+            dbus_connection_unref(g_conn);
+            g_conn = NULL;
+            g_watch_count = 0;
+            /* The portal went with the bus: carry on with the fallback backend */
+            atomic_store_explicit(&g_portal_state, PORTAL_UNKNOWN, memory_order_relaxed);
+            double values[SETTING_COUNT];
+            read_current_settings(NULL, values);
+            store_settings(values);
+            if (g_inotify_fd >= 0) {
+                changed = 1;  /* deliver what the fallback reports */
+                continue;
+            }
+        }
+        if (g_conn == NULL && g_inotify_fd < 0) break; /* nothing left to watch */
+
+        int nfds = 0;
+        fds[nfds].fd = g_wake_fd;
+        fds[nfds].events = POLLIN;
+        polled[nfds++] = NULL;
+        int inotifyIndex = -1;
+        if (g_inotify_fd >= 0) {
+            inotifyIndex = nfds;
+            fds[nfds].fd = g_inotify_fd;
+            fds[nfds].events = POLLIN;
+            polled[nfds++] = NULL;
+        }
+        for (int i = 0; i < g_watch_count; i++) {
+            DBusWatch *watch = g_watches[i];
+            if (!dbus_watch_get_enabled(watch)) continue;
+            unsigned int flags = dbus_watch_get_flags(watch);
+            fds[nfds].fd = dbus_watch_get_unix_fd(watch);
+            fds[nfds].events = (short)(((flags & DBUS_WATCH_READABLE) ? POLLIN : 0) |
+                                       ((flags & DBUS_WATCH_WRITABLE) ? POLLOUT : 0));
+            polled[nfds++] = watch;
+        }
+
+        nucleus_stats_end(&wakeup);
+        if (poll(fds, (nfds_t)nfds, timeout) < 0) continue; /* EINTR */
+        wakeup = nucleus_stats_begin(PROBE_MONITOR_WAKEUP);
+        atomic_fetch_add_explicit(&g_stat_wakeups, 1, memory_order_relaxed);
+
+        if (fds[0].revents) break; /* nativeStopObserving */
+
+        if (inotifyIndex >= 0 && fds[inotifyIndex].revents && read_fallback_events()) {
+            double values[SETTING_COUNT];
+            read_fallback_settings(values);
+            store_settings(values);
+            changed = 1;
+        }
+
+        int busActivity = 0;
+        for (int i = 1; i < nfds; i++) {
+            short re = fds[i].revents;
+            if (i == inotifyIndex) continue;
+            /* A callback may have removed the watch during an earlier handle */
+            if (!re || !watch_is_registered(polled[i])) continue;
+            unsigned int flags = 0;
+            if (re & POLLIN)  flags |= DBUS_WATCH_READABLE;
+            if (re & POLLOUT) flags |= DBUS_WATCH_WRITABLE;
+            if (re & POLLERR) flags |= DBUS_WATCH_ERROR;
+            if (re & POLLHUP) flags |= DBUS_WATCH_HANGUP;
+            dbus_watch_handle(polled[i], flags);
+            busActivity = 1;
+        }
+        if (busActivity) {
+            atomic_fetch_add_explicit(&g_stat_bus_wakeups, 1, memory_order_relaxed);
+        }
     }
+    nucleus_stats_end(&wakeup);
 
-    dbus_connection_close(g_conn);
-    dbus_connection_unref(g_conn);
-    g_conn = NULL;
-    dbus_error_free(&err);
+    if (g_conn != NULL) {
+        dbus_connection_close(g_conn);
+        dbus_connection_unref(g_conn);
+        g_conn = NULL;
+    }
+    g_watch_count = 0;
+    stop_fallback_watch();
+    /* No longer kept current */
+    atomic_store_explicit(&g_color_scheme, SCHEME_UNKNOWN, memory_order_relaxed);
+    atomic_store(&g_thread_exited, 1);
+    if (env != NULL) {
+        (*g_jvm)->DetachCurrentThread(g_jvm);
+    }
     return NULL;
 }
 
+/* Joins the monitor thread once it has been asked to stop or has stopped */
+static void reap_monitor_thread(void) {
+    pthread_join(g_thread, NULL);
+    close(g_wake_fd);
+    g_wake_fd = -1;
+    g_running = 0;
+}
+
 /* ------------------------------------------------------------------ */
 /*  nativeStartObserving()                                             */
 /* ------------------------------------------------------------------ */
@@ -265,10 +1217,49 @@ Java_io_github_kdroidfilter_nucleus_darkmodedetector_linux_NativeLinuxBridge_nat
     JNIEnv *env, jclass clazz)
 {
     (void)env; (void)clazz;
-    if (g_running) return; /* already observing */
+    NUCLEUS_STATS_SCOPE(PROBE_START_OBSERVING);
+    if (g_running) {
+        if (!atomic_load(&g_thread_exited)) return; /* already observing */
+        /* The monitor lost its bus with no fallback to watch: start over */
+        reap_monitor_thread();
+    }
+    atomic_store(&g_thread_exited, 0);
+    /* Cached while not observing: NameOwnerChanged only keeps it current from here on */
+    atomic_store_explicit(&g_portal_state, PORTAL_UNKNOWN, memory_order_relaxed);
+
+    /* Without a session bus only the fallback backend can be watched */
+    DBusConnection *conn = session_bus_configured() ? open_monitor_connection() : NULL;
+
+    /* One snapshot up front: from here on, nativeIsDark and nativeGetSettings
+     * serve cached values. Signals arriving meanwhile stay queued on conn for
+     * the thread. */
+    double values[SETTING_COUNT];
+    read_current_settings(conn, values);
+    if (conn == NULL && g_inotify_fd < 0) {
+        NUCLEUS_STATS_FAIL();
+        return; /* nothing to observe */
+    }
+    store_settings(values);
+    memcpy(g_delivered, values, sizeof(values));
+    /* Java reads the initial value itself: only later changes are delivered */
+    g_delivered_dark = values[SETTING_COLOR_SCHEME] == 1;
 
+    g_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    g_conn = conn;
     g_running = 1;
-    pthread_create(&g_thread, NULL, monitor_thread, NULL);
+    if (g_wake_fd < 0 || pthread_create(&g_thread, NULL, monitor_thread, NULL) != 0) {
+        NUCLEUS_STATS_FAIL();
+        if (g_wake_fd >= 0) close(g_wake_fd);
+        g_wake_fd = -1;
+        g_running = 0;
+        g_conn = NULL;
+        atomic_store_explicit(&g_color_scheme, SCHEME_UNKNOWN, memory_order_relaxed);
+        stop_fallback_watch();
+        if (conn != NULL) {
+            dbus_connection_close(conn);
+            dbus_connection_unref(conn);
+        }
+    }
 }
 
 /* ------------------------------------------------------------------ */
@@ -279,10 +1270,77 @@ Java_io_github_kdroidfilter_nucleus_darkmodedetector_linux_NativeLinuxBridge_nat
     JNIEnv *env, jclass clazz)
 {
     (void)env; (void)clazz;
+    NUCLEUS_STATS_SCOPE(PROBE_STOP_OBSERVING);
     if (!g_running) return;
 
-    g_running = 0;
-    /* The dispatch loop will exit on the next timeout or when the connection
-       is closed. We join the thread to ensure clean shutdown. */
-    pthread_join(g_thread, NULL);
+    /* Wake the thread out of poll(); it closes the connection and exits */
+    uint64_t one = 1;
+    ssize_t n = write(g_wake_fd, &one, sizeof(one));
+    (void)n;
+    reap_monitor_thread();
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeGetMonitorStats()                                            */
+/*  { poll() wakeups, wakeups with D-Bus fd activity, messages        */
+/*    dispatched } since the library was loaded. With no bus traffic  */
+/*  the first two stay constant: the monitor never wakes on its own.  */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jlongArray JNICALL
+Java_io_github_kdroidfilter_nucleus_darkmodedetector_linux_NativeLinuxBridge_nativeGetMonitorStats(
+    JNIEnv *env, jclass clazz)
+{
+    (void)clazz;
+    jlong stats[3] = {
+        atomic_load_explicit(&g_stat_wakeups, memory_order_relaxed),
+        atomic_load_explicit(&g_stat_bus_wakeups, memory_order_relaxed),
+        atomic_load_explicit(&g_stat_messages, memory_order_relaxed),
+    };
+    jlongArray result = (*env)->NewLongArray(env, 3);
+    if (result != NULL) (*env)->SetLongArrayRegion(env, result, 0, 3, stats);
+    return result;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeGetSettings()                                                */
+/*  The current settings snapshot (SETTING_COUNT doubles, -1 =        */
+/*  unknown), or null when not observing.                             */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jdoubleArray JNICALL
+Java_io_github_kdroidfilter_nucleus_darkmodedetector_linux_NativeLinuxBridge_nativeGetSettings(
+    JNIEnv *env, jclass clazz)
+{
+    (void)clazz;
+    NUCLEUS_STATS_SCOPE(PROBE_GET_SETTINGS);
+    if (!g_running || atomic_load(&g_thread_exited)) return NULL;
+
+    double values[SETTING_COUNT];
+    pthread_mutex_lock(&g_settings_lock);
+    memcpy(values, g_settings, sizeof(values));
+    pthread_mutex_unlock(&g_settings_lock);
+
+    jdoubleArray result = (*env)->NewDoubleArray(env, SETTING_COUNT);
+    if (result != NULL) (*env)->SetDoubleArrayRegion(env, result, 0, SETTING_COUNT, values);
+    return result;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeGetStats() / nativeSetStatsEnabled()                         */
+/*  Call statistics, NUCLEUS_STATS_FIELDS longs per PROBE_*, see       */
+/*  nucleus_native_stats.h.                                            */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jlongArray JNICALL
+Java_io_github_kdroidfilter_nucleus_darkmodedetector_linux_NativeLinuxBridge_nativeGetStats(
+    JNIEnv *env, jclass clazz)
+{
+    (void)clazz;
+    return nucleus_stats_to_java(env);
+}
+
+JNIEXPORT void JNICALL
+Java_io_github_kdroidfilter_nucleus_darkmodedetector_linux_NativeLinuxBridge_nativeSetStatsEnabled(
+    JNIEnv *env, jclass clazz, jboolean enabled)
+{
+    (void)env; (void)clazz;
+    nucleus_stats_set_enabled(enabled);
 }
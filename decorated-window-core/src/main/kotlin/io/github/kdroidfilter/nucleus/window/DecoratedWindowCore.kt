@@ -5,12 +5,14 @@ import androidx.compose.runtime.Composable
 import androidx.compose.runtime.CompositionLocalProvider
 import androidx.compose.runtime.DisposableEffect
 import androidx.compose.runtime.Immutable
+import androidx.compose.runtime.LaunchedEffect
 import androidx.compose.runtime.ProvidableCompositionLocal
 import androidx.compose.runtime.Stable
 import androidx.compose.runtime.compositionLocalOf
 import androidx.compose.runtime.getValue
 import androidx.compose.runtime.mutableStateOf
 import androidx.compose.runtime.remember
+import androidx.compose.runtime.rememberUpdatedState
 import androidx.compose.runtime.setValue
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.awt.ComposeWindow
@@ -34,6 +36,8 @@ import io.github.kdroidfilter.nucleus.window.internal.insideBorder
 import io.github.kdroidfilter.nucleus.window.styling.LocalDecoratedWindowStyle
 import java.awt.ComponentOrientation
 import java.awt.Frame
+import java.awt.Insets
+import java.awt.Rectangle
 import java.awt.event.ComponentEvent
 import java.awt.event.ComponentListener
 import java.awt.event.WindowAdapter
@@ -152,6 +156,45 @@ value class DecoratedWindowState(
     }
 }
 
+/**
+ * Compositor hints for an undecorated window, in window-relative logical pixels.
+ *
+ * @property opaqueRegion Parts of the window that are fully opaque (everything but the rounded corners).
+ * @property bypassCompositor Whether the compositor may unredirect the window (fullscreen).
+ */
+data class WindowCompositorHints(
+    val opaqueRegion: List<Rectangle>,
+    val bypassCompositor: Boolean,
+)
+
+/**
+ * Window state as reported by the window manager itself, for variants that can observe it
+ * natively. AWT doesn't surface tiling or frame extents and may report maximize changes late;
+ * when provided to [DecoratedWindowBody] this takes precedence over AWT's view.
+ *
+ * @property tiledEdges Edges the window is tiled/snapped against ([TiledTop], [TiledRight],
+ *   [TiledBottom], [TiledLeft] bits).
+ * @property frameExtents Frame margins the WM draws around the window (`_NET_FRAME_EXTENTS`),
+ *   in physical pixels.
+ */
+data class WindowManagerState(
+    val maximized: Boolean,
+    val fullscreen: Boolean,
+    val minimized: Boolean,
+    val tiledEdges: Int,
+    val frameExtents: Insets,
+) {
+    val isTiled: Boolean
+        get() = tiledEdges != 0
+
+    companion object {
+        const val TiledTop: Int = 1 shl 0
+        const val TiledRight: Int = 1 shl 1
+        const val TiledBottom: Int = 1 shl 2
+        const val TiledLeft: Int = 1 shl 3
+    }
+}
+
 data class TitleBarInfo(
     val title: String,
     val icon: Painter?,
@@ -165,13 +208,26 @@ val LocalTitleBarInfo: ProvidableCompositionLocal<TitleBarInfo> =
 /**
  * Shared body for DecoratedWindow, used by both JBR and JNI variants.
  * Each variant calls this from within a [Window] composable, passing the appropriate [undecorated] flag.
+ *
+ * When [onStartResize] is provided and the window is undecorated, an invisible resize border is
+ * laid over the window edges; pressing it hands the gesture to the callback (typically a native
+ * window-manager resize). The callback returns `true` when it took over the resize.
+ *
+ * When [onCompositorHints] is provided and the window is undecorated, it receives the window's
+ * opaque region and bypass-compositor preference every time its size, shape or state changes.
+ *
+ * When [windowManagerState] is non-null, maximized/fullscreen/minimized and tiling come from it
+ * instead of AWT, so the title bar and border lay out once per real state change.
  */
-@Suppress("FunctionNaming", "MagicNumber", "CyclomaticComplexMethod")
+@Suppress("FunctionNaming", "MagicNumber", "CyclomaticComplexMethod", "LongMethod")
 @Composable
 fun FrameWindowScope.DecoratedWindowBody(
     title: String,
     icon: Painter?,
     undecorated: Boolean,
+    onStartResize: ((WindowResizeEdge) -> Boolean)? = null,
+    onCompositorHints: ((WindowCompositorHints) -> Unit)? = null,
+    windowManagerState: WindowManagerState? = null,
     content: @Composable DecoratedWindowScope.() -> Unit,
 ) {
     var decoratedWindowState by remember { mutableStateOf(DecoratedWindowState.of(window)) }
@@ -180,51 +236,100 @@ fun FrameWindowScope.DecoratedWindowBody(
     val linuxDe = remember { LinuxDesktopEnvironment.Current }
     val gnomeCornerArc = 24f
     val kdeCornerArc = 10f
+    val currentOnCompositorHints by rememberUpdatedState(onCompositorHints)
+
+    val currentWindowManagerState by rememberUpdatedState(windowManagerState)
+    val currentUndecorated by rememberUpdatedState(undecorated)
+    // AWT extended state as last reported to the listeners below
+    var trackedExtendedState by remember(window) { mutableStateOf(window.extendedState) }
+
+    // The window minus its rounded corners, as two overlapping bands.
+    fun opaqueRegion(isMaxOrFull: Boolean): List<Rectangle> {
+        val w = window.width
+        val h = window.height
+        return when {
+            isMaxOrFull -> listOf(Rectangle(0, 0, w, h))
+            linuxDe == LinuxDesktopEnvironment.Gnome -> {
+                val r = (gnomeCornerArc / 2).toInt()
+                listOf(Rectangle(0, r, w, h - 2 * r), Rectangle(r, 0, w - 2 * r, h))
+            }
+            linuxDe == LinuxDesktopEnvironment.KDE -> {
+                // Only the top corners are rounded on KDE
+                val r = (kdeCornerArc / 2).toInt()
+                listOf(Rectangle(0, r, w, h - r), Rectangle(r, 0, w - 2 * r, r))
+            }
+            else -> listOf(Rectangle(0, 0, w, h))
+        }
+    }
 
-    DisposableEffect(window) {
-        var trackedExtendedState = window.extendedState
-
-        fun updateWindowShape() {
-            decoratedWindowState = DecoratedWindowState.of(window)
-            val ws = decoratedWindowState
-            val hasAnyMaxBit =
-                (trackedExtendedState and (Frame.MAXIMIZED_VERT or Frame.MAXIMIZED_HORIZ)) != 0
-            val gc = window.graphicsConfiguration
-            val fillsScreen =
-                gc != null &&
-                    (
-                        window.height >= gc.bounds.height * 0.9 ||
-                            window.width >= gc.bounds.width * 0.9
-                    )
-            isMaximizedInAnyDirection = ws.isMaximized || hasAnyMaxBit || fillsScreen
-            val isMaxOrFull = ws.isFullscreen || isMaximizedInAnyDirection
-            when (linuxDe) {
-                LinuxDesktopEnvironment.Gnome -> {
-                    window.shape =
-                        if (isMaxOrFull) {
-                            null
-                        } else {
-                            val w = window.width.toFloat()
-                            val h = window.height.toFloat()
-                            RoundRectangle2D.Float(0f, 0f, w, h, gnomeCornerArc, gnomeCornerArc)
-                        }
-                }
-                LinuxDesktopEnvironment.KDE -> {
-                    window.shape =
-                        if (isMaxOrFull) {
-                            null
-                        } else {
-                            val w = window.width.toFloat()
-                            val h = window.height.toFloat()
-                            Area(RoundRectangle2D.Float(0f, 0f, w, h, kdeCornerArc, kdeCornerArc)).apply {
-                                add(Area(Rectangle2D.Float(0f, h - kdeCornerArc, w, kdeCornerArc)))
-                            }
+    fun updateWindowShape() {
+        val wmState = currentWindowManagerState
+        decoratedWindowState =
+            if (wmState != null) {
+                DecoratedWindowState.of(
+                    fullscreen = wmState.fullscreen,
+                    minimized = wmState.minimized,
+                    maximized = wmState.maximized,
+                    active = window.isActive,
+                )
+            } else {
+                DecoratedWindowState.of(window)
+            }
+        val ws = decoratedWindowState
+        isMaximizedInAnyDirection =
+            if (wmState != null) {
+                // Tiled windows sit against screen edges: square corners, no border
+                wmState.maximized || wmState.isTiled
+            } else {
+                val hasAnyMaxBit =
+                    (trackedExtendedState and (Frame.MAXIMIZED_VERT or Frame.MAXIMIZED_HORIZ)) != 0
+                val gc = window.graphicsConfiguration
+                val fillsScreen =
+                    gc != null &&
+                        (
+                            window.height >= gc.bounds.height * 0.9 ||
+                                window.width >= gc.bounds.width * 0.9
+                        )
+                ws.isMaximized || hasAnyMaxBit || fillsScreen
+            }
+        val isMaxOrFull = ws.isFullscreen || isMaximizedInAnyDirection
+        when (linuxDe) {
+            LinuxDesktopEnvironment.Gnome -> {
+                window.shape =
+                    if (isMaxOrFull) {
+                        null
+                    } else {
+                        val w = window.width.toFloat()
+                        val h = window.height.toFloat()
+                        RoundRectangle2D.Float(0f, 0f, w, h, gnomeCornerArc, gnomeCornerArc)
+                    }
+            }
+            LinuxDesktopEnvironment.KDE -> {
+                window.shape =
+                    if (isMaxOrFull) {
+                        null
+                    } else {
+                        val w = window.width.toFloat()
+                        val h = window.height.toFloat()
+                        Area(RoundRectangle2D.Float(0f, 0f, w, h, kdeCornerArc, kdeCornerArc)).apply {
+                            add(Area(Rectangle2D.Float(0f, h - kdeCornerArc, w, kdeCornerArc)))
                         }
-                }
-                else -> {}
+                    }
             }
+            else -> {}
+        }
+        if (currentUndecorated) {
+            currentOnCompositorHints?.invoke(
+                WindowCompositorHints(
+                    opaqueRegion = opaqueRegion(isMaxOrFull),
+                    bypassCompositor = ws.isFullscreen,
+                ),
+            )
         }
+    }
 
+    // Keyed on the window only: WM state pushes must not re-register the listeners
+    DisposableEffect(window) {
         updateWindowShape()
 
         val adapter =
@@ -278,6 +383,11 @@ fun FrameWindowScope.DecoratedWindowBody(
         }
     }
 
+    // Each real WM state change re-runs the shape update once
+    LaunchedEffect(windowManagerState) {
+        if (windowManagerState != null) updateWindowShape()
+    }
+
     val style = LocalDecoratedWindowStyle.current
     val borderShape =
         when (linuxDe) {
@@ -303,6 +413,18 @@ fun FrameWindowScope.DecoratedWindowBody(
             Modifier
         }
 
+    val resizeBorder =
+        Modifier.windowResizeBorder(
+            enabled =
+                undecorated &&
+                    onStartResize != null &&
+                    window.isResizable &&
+                    !decoratedWindowState.isFullscreen &&
+                    !decoratedWindowState.isMaximized &&
+                    !isMaximizedInAnyDirection,
+            onStartResize = { edge -> onStartResize?.invoke(edge) ?: false },
+        )
+
     // Detect platform layout direction from JVM locale so that RTL locales
     // (Hebrew, Arabic, …) automatically mirror the title bar and content.
     // Compose Desktop does not propagate java.util.Locale into LocalLayoutDirection.
@@ -331,7 +453,7 @@ fun FrameWindowScope.DecoratedWindowBody(
                     }
                 scope.content()
             },
-            modifier = undecoratedWindowBorder,
+            modifier = undecoratedWindowBorder.then(resizeBorder),
             measurePolicy = DecoratedWindowMeasurePolicy,
         )
     }
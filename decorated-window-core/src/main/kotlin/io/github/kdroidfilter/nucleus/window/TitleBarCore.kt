@@ -12,6 +12,7 @@ import androidx.compose.runtime.Stable
 import androidx.compose.runtime.getValue
 import androidx.compose.runtime.remember
 import androidx.compose.runtime.staticCompositionLocalOf
+import androidx.compose.runtime.withFrameNanos
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.focus.focusProperties
@@ -41,8 +42,12 @@ import androidx.compose.ui.unit.Dp
 import androidx.compose.ui.unit.offset
 import io.github.kdroidfilter.nucleus.window.styling.LocalTitleBarStyle
 import io.github.kdroidfilter.nucleus.window.styling.TitleBarStyle
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.coroutineScope
 import kotlinx.coroutines.currentCoroutineContext
 import kotlinx.coroutines.isActive
+import kotlinx.coroutines.launch
+import java.awt.MouseInfo
 import java.awt.Window
 import kotlin.math.max
 
@@ -308,51 +313,85 @@ class TitleBarChildDataNode(
 // Handles window dragging via Compose pointer events.
 // Drag starts only when the press is not consumed by a child composable (e.g. a button),
 // so interactive elements in the title bar keep working correctly.
-fun Modifier.windowDragHandler(window: Window): Modifier =
-    pointerInput(window) {
+// Move events only mark the drag as pending: the window is moved at most once per
+// display frame, from a single pointer query, however fast the mouse reports.
+// [moveWindow] performs the move (e.g. through a native bridge); when it is null or
+// returns false the drag falls back to Window.setLocation. See [WindowDragStats].
+fun Modifier.windowDragHandler(
+    window: Window,
+    moveWindow: ((Window, Int, Int) -> Boolean)? = null,
+): Modifier =
+    pointerInput(window, moveWindow) {
         val ctx = currentCoroutineContext()
-        awaitPointerEventScope {
+        coroutineScope {
+            // Pointer handling and the frame loop both run on the UI thread,
+            // so the drag state below needs no synchronization.
             var dragging = false
+            var pending = false
             var startScreenX = 0
             var startScreenY = 0
             var startWindowX = 0
             var startWindowY = 0
+            var dragStartNanos = 0L
+            var moves = 0
+            var pointerEvents = 0
+            val frameRequests = Channel<Unit>(Channel.CONFLATED)
+
+            fun moveToPointer() {
+                pending = false
+                val loc = MouseInfo.getPointerInfo()?.location ?: return
+                val x = startWindowX + (loc.x - startScreenX)
+                val y = startWindowY + (loc.y - startScreenY)
+                if (moveWindow?.invoke(window, x, y) != true) {
+                    window.setLocation(x, y)
+                }
+                moves++
+            }
 
-            @Suppress("LoopWithTooManyJumpStatements")
-            while (ctx.isActive) {
-                val event = awaitPointerEvent(PointerEventPass.Main)
-                val change = event.changes.firstOrNull() ?: continue
-
-                when (event.type) {
-                    PointerEventType.Press -> {
-                        if (!change.isConsumed) {
-                            val loc =
-                                java.awt.MouseInfo
-                                    .getPointerInfo()
-                                    ?.location
-                            startScreenX = loc?.x ?: 0
-                            startScreenY = loc?.y ?: 0
-                            startWindowX = window.x
-                            startWindowY = window.y
-                            dragging = true
+            launch {
+                for (request in frameRequests) {
+                    withFrameNanos { }
+                    if (pending) moveToPointer()
+                }
+            }
+
+            awaitPointerEventScope {
+                @Suppress("LoopWithTooManyJumpStatements")
+                while (ctx.isActive) {
+                    val event = awaitPointerEvent(PointerEventPass.Main)
+                    val change = event.changes.firstOrNull() ?: continue
+
+                    when (event.type) {
+                        PointerEventType.Press -> {
+                            if (!change.isConsumed) {
+                                val loc = MouseInfo.getPointerInfo()?.location
+                                startScreenX = loc?.x ?: 0
+                                startScreenY = loc?.y ?: 0
+                                startWindowX = window.x
+                                startWindowY = window.y
+                                dragStartNanos = System.nanoTime()
+                                moves = 0
+                                pointerEvents = 0
+                                dragging = true
+                            }
                         }
-                    }
-                    PointerEventType.Move -> {
-                        if (dragging) {
-                            val loc =
-                                java.awt.MouseInfo
-                                    .getPointerInfo()
-                                    ?.location ?: continue
-                            window.setLocation(
-                                startWindowX + (loc.x - startScreenX),
-                                startWindowY + (loc.y - startScreenY),
-                            )
+                        PointerEventType.Move -> {
+                            if (dragging) {
+                                pointerEvents++
+                                pending = true
+                                frameRequests.trySend(Unit)
+                            }
                         }
+                        PointerEventType.Release -> {
+                            if (dragging) {
+                                // Land exactly where the pointer was released
+                                if (pending) moveToPointer()
+                                dragging = false
+                                WindowDragStats.record(System.nanoTime() - dragStartNanos, moves, pointerEvents)
+                            }
+                        }
+                        else -> Unit
                     }
-                    PointerEventType.Release -> {
-                        dragging = false
-                    }
-                    else -> Unit
                 }
             }
         }
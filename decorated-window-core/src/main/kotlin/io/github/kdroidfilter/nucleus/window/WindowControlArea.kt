@@ -27,12 +27,25 @@ import java.awt.event.WindowEvent
 
 private val isKde = LinuxDesktopEnvironment.Current == LinuxDesktopEnvironment.KDE
 
+/**
+ * Linux close/maximize/minimize buttons.
+ * [setMaximized] and [minimize] default to `Frame.extendedState`; variants with a native
+ * window-manager path (e.g. `_NET_WM_STATE`) can pass their own.
+ */
 @Suppress("FunctionNaming")
 @Composable
 fun TitleBarScope.WindowControlArea(
     window: java.awt.Window,
     state: DecoratedWindowState,
     style: TitleBarStyle,
+    setMaximized: (Boolean) -> Unit = { maximized ->
+        (window as? Frame)?.extendedState = if (maximized) Frame.MAXIMIZED_BOTH else Frame.NORMAL
+    },
+    minimize: () -> Unit = {
+        (window as? Frame)?.let {
+            it.extendedState = it.extendedState or Frame.ICONIFIED
+        }
+    },
 ) {
     val icons = linuxTitleBarIcons()
 
@@ -55,7 +68,7 @@ fun TitleBarScope.WindowControlArea(
     if (frame != null && frame.isResizable) {
         if (state.isMaximized) {
             ControlButton(
-                onClick = { frame.extendedState = Frame.NORMAL },
+                onClick = { setMaximized(false) },
                 state = state,
                 icon = icons.restore,
                 iconHover = icons.restoreHover,
@@ -65,7 +78,7 @@ fun TitleBarScope.WindowControlArea(
             )
         } else {
             ControlButton(
-                onClick = { frame.extendedState = Frame.MAXIMIZED_BOTH },
+                onClick = { setMaximized(true) },
                 state = state,
                 icon = icons.maximize,
                 iconHover = icons.maximizeHover,
@@ -78,11 +91,7 @@ fun TitleBarScope.WindowControlArea(
 
     // Minimize button (placed last with Alignment.End, so it's leftmost)
     ControlButton(
-        onClick = {
-            (window as? Frame)?.let {
-                it.extendedState = it.extendedState or Frame.ICONIFIED
-            }
-        },
+        onClick = minimize,
         state = state,
         icon = icons.minimize,
         iconHover = icons.minimizeHover,
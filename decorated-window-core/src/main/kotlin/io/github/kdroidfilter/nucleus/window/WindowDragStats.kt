@@ -0,0 +1,40 @@
+package io.github.kdroidfilter.nucleus.window
+
+/**
+ * Diagnostics for the Compose window drag ([windowDragHandler]), used when the
+ * window manager can't drive the move itself.
+ *
+ * Pointer Move events are coalesced to at most one window move per display
+ * frame, so on high-polling-rate mice [lastPointerEventRate] can be several
+ * times [lastMoveRate].
+ */
+object WindowDragStats {
+    /** Window moves per second achieved by the most recent drag (0 before the first one). */
+    @Volatile
+    var lastMoveRate: Double = 0.0
+        private set
+
+    /** Pointer Move events per second received during the most recent drag. */
+    @Volatile
+    var lastPointerEventRate: Double = 0.0
+        private set
+
+    /** Total window moves issued by all drags so far. */
+    @Volatile
+    var totalMoves: Long = 0L
+        private set
+
+    internal fun record(
+        durationNanos: Long,
+        moves: Int,
+        pointerEvents: Int,
+    ) {
+        totalMoves += moves
+        if (durationNanos <= 0L) return
+        val seconds = durationNanos / NANOS_PER_SECOND
+        lastMoveRate = moves / seconds
+        lastPointerEventRate = pointerEvents / seconds
+    }
+
+    private const val NANOS_PER_SECOND = 1_000_000_000.0
+}
@@ -0,0 +1,111 @@
+package io.github.kdroidfilter.nucleus.window
+
+import androidx.compose.runtime.getValue
+import androidx.compose.runtime.mutableStateOf
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.setValue
+import androidx.compose.ui.ExperimentalComposeUiApi
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.composed
+import androidx.compose.ui.geometry.Offset
+import androidx.compose.ui.input.pointer.PointerButton
+import androidx.compose.ui.input.pointer.PointerEventPass
+import androidx.compose.ui.input.pointer.PointerEventType
+import androidx.compose.ui.input.pointer.PointerIcon
+import androidx.compose.ui.input.pointer.onPointerEvent
+import androidx.compose.ui.input.pointer.pointerHoverIcon
+import androidx.compose.ui.unit.Dp
+import androidx.compose.ui.unit.IntSize
+import androidx.compose.ui.unit.dp
+import java.awt.Cursor
+
+/**
+ * One of the eight window edges/corners a resize can start from.
+ * Declared in `_NET_WM_MOVERESIZE_SIZE_*` order (top-left, clockwise).
+ */
+enum class WindowResizeEdge(
+    internal val cursor: Int,
+) {
+    TopLeft(Cursor.NW_RESIZE_CURSOR),
+    Top(Cursor.N_RESIZE_CURSOR),
+    TopRight(Cursor.NE_RESIZE_CURSOR),
+    Right(Cursor.E_RESIZE_CURSOR),
+    BottomRight(Cursor.SE_RESIZE_CURSOR),
+    Bottom(Cursor.S_RESIZE_CURSOR),
+    BottomLeft(Cursor.SW_RESIZE_CURSOR),
+    Left(Cursor.W_RESIZE_CURSOR),
+}
+
+// Thickness of the invisible resize zone along each edge, and the length of
+// the corner zones measured along the edges.
+internal val ResizeBorderThickness: Dp = 6.dp
+internal val ResizeCornerSize: Dp = 16.dp
+
+@Suppress("ReturnCount")
+private fun edgeAt(
+    position: Offset,
+    size: IntSize,
+    thickness: Float,
+    corner: Float,
+): WindowResizeEdge? {
+    val left = position.x < thickness
+    val right = position.x >= size.width - thickness
+    val top = position.y < thickness
+    val bottom = position.y >= size.height - thickness
+    if (!left && !right && !top && !bottom) return null
+
+    val nearLeft = position.x < corner
+    val nearRight = position.x >= size.width - corner
+    val nearTop = position.y < corner
+    val nearBottom = position.y >= size.height - corner
+
+    return when {
+        (top && nearLeft) || (left && nearTop) -> WindowResizeEdge.TopLeft
+        (top && nearRight) || (right && nearTop) -> WindowResizeEdge.TopRight
+        (bottom && nearLeft) || (left && nearBottom) -> WindowResizeEdge.BottomLeft
+        (bottom && nearRight) || (right && nearBottom) -> WindowResizeEdge.BottomRight
+        top -> WindowResizeEdge.Top
+        bottom -> WindowResizeEdge.Bottom
+        left -> WindowResizeEdge.Left
+        else -> WindowResizeEdge.Right
+    }
+}
+
+// Invisible resize border for undecorated windows. Presses inside the edge zone
+// are handed to [onStartResize] before any child sees them (Initial pass); when it
+// returns true the press is consumed so the window manager owns the gesture.
+@OptIn(ExperimentalComposeUiApi::class)
+internal fun Modifier.windowResizeBorder(
+    enabled: Boolean,
+    onStartResize: (WindowResizeEdge) -> Boolean,
+): Modifier {
+    if (!enabled) return this
+    return composed {
+        var hoveredEdge by remember { mutableStateOf<WindowResizeEdge?>(null) }
+        val edge = hoveredEdge
+
+        this
+            .onPointerEvent(PointerEventType.Move, PointerEventPass.Initial) {
+                val change = currentEvent.changes.firstOrNull() ?: return@onPointerEvent
+                hoveredEdge =
+                    edgeAt(change.position, size, ResizeBorderThickness.toPx(), ResizeCornerSize.toPx())
+            }.onPointerEvent(PointerEventType.Exit, PointerEventPass.Initial) {
+                hoveredEdge = null
+            }.onPointerEvent(PointerEventType.Press, PointerEventPass.Initial) {
+                if (currentEvent.button != PointerButton.Primary) return@onPointerEvent
+                val change = currentEvent.changes.firstOrNull() ?: return@onPointerEvent
+                val pressedEdge =
+                    edgeAt(change.position, size, ResizeBorderThickness.toPx(), ResizeCornerSize.toPx())
+                        ?: return@onPointerEvent
+                if (onStartResize(pressedEdge)) {
+                    currentEvent.changes.forEach { it.consume() }
+                }
+            }.then(
+                if (edge != null) {
+                    Modifier.pointerHoverIcon(PointerIcon(Cursor(edge.cursor)), overrideDescendants = true)
+                } else {
+                    Modifier
+                },
+            )
+    }
+}
@@ -66,6 +66,7 @@ val buildNativeLinux by tasks.registering(Exec::class) {
     val checkFile = File(outputDir, "linux-x64/libnucleus_linux_jni.so")
     onlyIf { Os.isFamily(Os.FAMILY_UNIX) && !Os.isFamily(Os.FAMILY_MAC) && !checkFile.exists() }
     inputs.dir(nativeDir)
+    inputs.dir(rootProject.file("core-runtime/src/main/native/include"))
     outputs.dir(outputDir)
     workingDir(nativeDir)
     commandLine("bash", "build.sh")
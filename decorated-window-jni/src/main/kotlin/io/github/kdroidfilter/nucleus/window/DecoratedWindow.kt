@@ -1,13 +1,19 @@
 package io.github.kdroidfilter.nucleus.window
 
 import androidx.compose.runtime.Composable
+import androidx.compose.runtime.remember
 import androidx.compose.ui.graphics.painter.Painter
 import androidx.compose.ui.input.key.KeyEvent
 import androidx.compose.ui.window.Window
 import androidx.compose.ui.window.WindowState
 import androidx.compose.ui.window.rememberWindowState
 import io.github.kdroidfilter.nucleus.core.runtime.Platform
+import io.github.kdroidfilter.nucleus.window.utils.linux.JniLinuxWindowBridge
+import io.github.kdroidfilter.nucleus.window.utils.linux.LinuxCompositorHints
+import io.github.kdroidfilter.nucleus.window.utils.linux.LinuxFrameSyncEffect
+import io.github.kdroidfilter.nucleus.window.utils.linux.rememberLinuxWindowManagerState
 import io.github.kdroidfilter.nucleus.window.utils.windows.JniWindowsDecorationBridge
+import java.awt.MouseInfo
 
 @Suppress("FunctionNaming", "LongParameterList")
 @Composable
@@ -54,10 +60,54 @@ fun DecoratedWindow(
         onPreviewKeyEvent,
         onKeyEvent,
     ) {
+        val isNativeLinux = Platform.Current == Platform.Linux && JniLinuxWindowBridge.isLoaded
+
+        // On Linux, edge/corner resizing is delegated to the window manager via
+        // _NET_WM_MOVERESIZE so it runs at compositor frame rate. A WM without it
+        // gets no resize border, rather than one that swallows presses.
+        val wmResizeSupported =
+            remember {
+                isNativeLinux && JniLinuxWindowBridge.hasWmCapability(JniLinuxWindowBridge.WM_CAP_MOVERESIZE)
+            }
+        val onStartResize: ((WindowResizeEdge) -> Boolean)? =
+            if (wmResizeSupported) {
+                { edge ->
+                    val mouseLocation = MouseInfo.getPointerInfo()?.location
+                    mouseLocation != null &&
+                        JniLinuxWindowBridge.nativeStartWindowResize(
+                            window,
+                            mouseLocation.x,
+                            mouseLocation.y,
+                            1,
+                            edge.ordinal,
+                        )
+                }
+            } else {
+                null
+            }
+
+        // Opaque region / bypass-compositor hints so the compositor can skip blending
+        val onCompositorHints: ((WindowCompositorHints) -> Unit)? =
+            if (isNativeLinux) {
+                { hints -> LinuxCompositorHints.apply(window, hints) }
+            } else {
+                null
+            }
+
+        if (isNativeLinux) {
+            LinuxFrameSyncEffect(window)
+        }
+
+        // WM-reported maximized/tiled/fullscreen state, ahead of AWT's (late) events
+        val windowManagerState = if (isNativeLinux) rememberLinuxWindowManagerState(window) else null
+
         DecoratedWindowBody(
             title = title,
             icon = icon,
             undecorated = undecorated,
+            onStartResize = onStartResize,
+            onCompositorHints = onCompositorHints,
+            windowManagerState = windowManagerState,
             content = content,
         )
     }
@@ -4,6 +4,7 @@ import androidx.compose.foundation.layout.PaddingValues
 import androidx.compose.foundation.layout.Spacer
 import androidx.compose.foundation.layout.fillMaxSize
 import androidx.compose.runtime.Composable
+import androidx.compose.runtime.remember
 import androidx.compose.ui.ExperimentalComposeUiApi
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.graphics.Color
@@ -46,6 +47,9 @@ private fun DecoratedDialogScope.NativeLinuxDialogTitleBar(
 ) {
     val linuxStyle = createLinuxTitleBarStyle(style)
     val dialogState = state
+    // Without _NET_WM_MOVERESIZE, drag in Compose and move through the bridge
+    val wmMoveSupported =
+        remember { JniLinuxWindowBridge.hasWmCapability(JniLinuxWindowBridge.WM_CAP_MOVERESIZE) }
 
     DialogTitleBarImpl(
         modifier = modifier,
@@ -65,6 +69,7 @@ private fun DecoratedDialogScope.NativeLinuxDialogTitleBar(
                         .fillMaxSize()
                         .onPointerEvent(PointerEventType.Press, PointerEventPass.Main) {
                             if (
+                                wmMoveSupported &&
                                 this.currentEvent.button == PointerButton.Primary &&
                                 this.currentEvent.changes.any { !it.isConsumed }
                             ) {
@@ -79,7 +84,13 @@ private fun DecoratedDialogScope.NativeLinuxDialogTitleBar(
                                     )
                                 }
                             }
-                        },
+                        }.then(
+                            if (wmMoveSupported) {
+                                Modifier
+                            } else {
+                                Modifier.windowDragHandler(window, JniLinuxWindowBridge::moveWindow)
+                            },
+                        ),
             )
         },
     ) { _ ->
@@ -4,6 +4,7 @@ import androidx.compose.foundation.layout.PaddingValues
 import androidx.compose.foundation.layout.Spacer
 import androidx.compose.foundation.layout.fillMaxSize
 import androidx.compose.runtime.Composable
+import androidx.compose.runtime.remember
 import androidx.compose.ui.ExperimentalComposeUiApi
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.graphics.Color
@@ -49,6 +50,10 @@ private fun DecoratedWindowScope.NativeLinuxTitleBar(
     val linuxStyle = createLinuxTitleBarStyle(style)
     val viewConfig = LocalViewConfiguration.current
     var lastPressTime = 0L
+    // Without _NET_WM_MOVERESIZE the WM can't drive the move: drag in Compose and
+    // move the window through the bridge instead.
+    val wmMoveSupported =
+        remember { JniLinuxWindowBridge.hasWmCapability(JniLinuxWindowBridge.WM_CAP_MOVERESIZE) }
 
     TitleBarImpl(
         modifier = modifier,
@@ -74,13 +79,9 @@ private fun DecoratedWindowScope.NativeLinuxTitleBar(
                                 val now = System.currentTimeMillis()
                                 val elapsed = now - lastPressTime
                                 if (elapsed in viewConfig.doubleTapMinTimeMillis..viewConfig.doubleTapTimeoutMillis) {
-                                    // Double-click: toggle maximize
-                                    if (state.isMaximized) {
-                                        window.extendedState = Frame.NORMAL
-                                    } else {
-                                        window.extendedState = Frame.MAXIMIZED_BOTH
-                                    }
-                                } else {
+                                    // Double-click: toggle maximize as a single _NET_WM_STATE request
+                                    setMaximizedNative(window, !state.isMaximized)
+                                } else if (wmMoveSupported) {
                                     // Single press: initiate native WM move
                                     val mouseLocation = MouseInfo.getPointerInfo()?.location
                                     if (mouseLocation != null) {
@@ -94,15 +95,42 @@ private fun DecoratedWindowScope.NativeLinuxTitleBar(
                                 }
                                 lastPressTime = now
                             }
-                        },
+                        }.then(
+                            if (wmMoveSupported) {
+                                Modifier
+                            } else {
+                                Modifier.windowDragHandler(window, JniLinuxWindowBridge::moveWindow)
+                            },
+                        ),
             )
         },
     ) { currentState ->
-        WindowControlArea(window, currentState, linuxStyle)
+        WindowControlArea(
+            window = window,
+            state = currentState,
+            style = linuxStyle,
+            setMaximized = { maximized -> setMaximizedNative(window, maximized) },
+            minimize = {
+                if (!JniLinuxWindowBridge.minimize(window)) {
+                    window.extendedState = window.extendedState or Frame.ICONIFIED
+                }
+            },
+        )
         content(currentState)
     }
 }
 
+// Maximizes/restores through _NET_WM_STATE when the WM supports it, otherwise
+// through Frame.extendedState.
+private fun setMaximizedNative(
+    window: Frame,
+    maximized: Boolean,
+) {
+    if (!JniLinuxWindowBridge.setMaximized(window, maximized)) {
+        window.extendedState = if (maximized) Frame.MAXIMIZED_BOTH else Frame.NORMAL
+    }
+}
+
 // Fallback title bar: Compose-based drag and double-click (no native lib).
 @OptIn(ExperimentalComposeUiApi::class)
 @Suppress("FunctionNaming")
@@ -1,12 +1,37 @@
 package io.github.kdroidfilter.nucleus.window.utils.linux
 
-import java.nio.file.Files
+import io.github.kdroidfilter.nucleus.core.runtime.NativeLibraryLoader
+import io.github.kdroidfilter.nucleus.core.runtime.NucleusNativeStats
+import java.util.concurrent.ConcurrentHashMap
 import java.util.logging.Level
 import java.util.logging.Logger
+import kotlin.math.roundToInt
 
 internal object JniLinuxWindowBridge {
     private val logger = Logger.getLogger(JniLinuxWindowBridge::class.java.simpleName)
 
+    // Native call statistics probes, in nativeGetStats order (PROBE_* in nucleus_linux_window.c)
+    private val STATS_PROBES =
+        listOf(
+            "JNI_OnLoad",
+            "nativeStartWindowMove",
+            "nativeStartWindowResize",
+            "nativeMoveWindow",
+            "nativeIsWmMoveResizeSupported",
+            "nativeGetWmCapabilities",
+            "nativeObserveWindowState",
+            "nativeStopObservingWindowState",
+            "nativeSetWindowState",
+            "nativeMinimizeWindow",
+            "nativeEnableFrameSync",
+            "nativeFrameSyncPresented",
+            "nativeDisableFrameSync",
+            "nativeSetOpaqueRegion",
+            "nativeSetBypassCompositor",
+            "watcher wakeup",
+            "window state push",
+        )
+
     @Volatile
     private var loaded = false
 
@@ -17,35 +42,13 @@ internal object JniLinuxWindowBridge {
     private fun loadNativeLibrary() {
         if (loaded) return
 
-        // Try system library path first (packaged app)
-        try {
-            System.loadLibrary("nucleus_linux_jni")
-            loaded = true
-            return
-        } catch (_: UnsatisfiedLinkError) {
-            // Fall through to JAR extraction
-        }
-
-        // Fallback: extract from JAR resources
-        @Suppress("TooGenericExceptionCaught")
+        // Library path first (packaged app), else the copy bundled in the JAR,
+        // extracted once into the per-user native library cache
         try {
-            val arch =
-                System.getProperty("os.arch").let {
-                    if (it == "aarch64" || it == "arm64") "aarch64" else "x64"
-                }
-            val resourcePath = "/nucleus/native/linux-$arch/libnucleus_linux_jni.so"
-            val stream =
-                JniLinuxWindowBridge::class.java
-                    .getResourceAsStream(resourcePath)
-                    ?: throw UnsatisfiedLinkError("Native library not found in JAR at $resourcePath")
-            val tempDir = Files.createTempDirectory("nucleus-jni-native")
-            val tempLib = tempDir.resolve("libnucleus_linux_jni.so")
-            stream.use { Files.copy(it, tempLib) }
-            tempLib.toFile().deleteOnExit()
-            tempDir.toFile().deleteOnExit()
-            System.load(tempLib.toAbsolutePath().toString())
+            NativeLibraryLoader.load(JniLinuxWindowBridge::class.java, "nucleus_linux_jni") { System.load(it) }
             loaded = true
-        } catch (e: Exception) {
+            NucleusNativeStats.register("nucleus_linux_jni", STATS_PROBES, ::nativeGetStats, ::nativeSetStatsEnabled)
+        } catch (e: UnsatisfiedLinkError) {
             logger.log(Level.WARNING, "Failed to load nucleus_linux_jni native library", e)
         }
     }
@@ -64,7 +67,263 @@ internal object JniLinuxWindowBridge {
         button: Int,
     ): Boolean
 
+    // Initiates a native window resize via _NET_WM_MOVERESIZE.
+    // edge: _NET_WM_MOVERESIZE_SIZE_* direction (0 = top-left, clockwise to 7 = left).
+    // Returns true on success, false when the WM does not support _NET_WM_MOVERESIZE.
+    @JvmStatic
+    external fun nativeStartWindowResize(
+        awtWindow: java.awt.Window,
+        rootX: Int,
+        rootY: Int,
+        button: Int,
+        edge: Int,
+    ): Boolean
+
+    // Moves the shell window to (x, y), in physical root coordinates, with a
+    // single asynchronous XMoveWindow on the bridge's own X connection.
+    // Returns true on success.
+    @JvmStatic
+    external fun nativeMoveWindow(
+        awtWindow: java.awt.Window,
+        x: Int,
+        y: Int,
+    ): Boolean
+
     // Checks if the window manager supports _NET_WM_MOVERESIZE.
     @JvmStatic
     external fun nativeIsWmMoveResizeSupported(awtWindow: java.awt.Window): Boolean
+
+    // Returns the WM capability bitmap (WM_CAP_* bits). The snapshot is filled once
+    // and only refreshed after the root window's _NET_SUPPORTED or
+    // _NET_SUPPORTING_WM_CHECK changes, so repeated calls don't touch the X server.
+    @JvmStatic
+    external fun nativeGetWmCapabilities(): Long
+
+    // Sends a single _NET_WM_STATE request changing up to two state properties at once.
+    // action: STATE_ACTION_*; first/second: STATE_* codes (second may be STATE_NONE).
+    // Returns true if the request was sent.
+    @JvmStatic
+    external fun nativeSetWindowState(
+        awtWindow: java.awt.Window,
+        action: Int,
+        first: Int,
+        second: Int,
+    ): Boolean
+
+    // Iconifies the window with an ICCCM WM_CHANGE_STATE request.
+    @JvmStatic
+    external fun nativeMinimizeWindow(awtWindow: java.awt.Window): Boolean
+
+    // Maximizes or restores the window as one WM transaction (MAXIMIZED_VERT|HORZ together).
+    // Returns false when the WM doesn't support it so callers can fall back to extendedState.
+    fun setMaximized(
+        window: java.awt.Window,
+        maximized: Boolean,
+    ): Boolean =
+        hasWmCapability(WM_CAP_STATE or WM_CAP_STATE_MAXIMIZED_VERT or WM_CAP_STATE_MAXIMIZED_HORZ) &&
+            nativeSetWindowState(
+                window,
+                if (maximized) STATE_ACTION_ADD else STATE_ACTION_REMOVE,
+                STATE_MAXIMIZED_VERT,
+                STATE_MAXIMIZED_HORZ,
+            )
+
+    // Enters or leaves fullscreen via _NET_WM_STATE_FULLSCREEN.
+    fun setFullscreen(
+        window: java.awt.Window,
+        fullscreen: Boolean,
+    ): Boolean =
+        hasWmCapability(WM_CAP_STATE or WM_CAP_STATE_FULLSCREEN) &&
+            nativeSetWindowState(
+                window,
+                if (fullscreen) STATE_ACTION_ADD else STATE_ACTION_REMOVE,
+                STATE_FULLSCREEN,
+                STATE_NONE,
+            )
+
+    // Iconifies the window; returns false when the native library is unavailable.
+    fun minimize(window: java.awt.Window): Boolean = loaded && nativeMinimizeWindow(window)
+
+    // Moves the window to (x, y) in AWT (logical) screen coordinates; returns false
+    // when the native library is unavailable so the caller can use setLocation.
+    fun moveWindow(
+        window: java.awt.Window,
+        x: Int,
+        y: Int,
+    ): Boolean {
+        if (!loaded) return false
+        val scale = window.graphicsConfiguration?.defaultTransform?.scaleX ?: 1.0
+        return nativeMoveWindow(window, (x * scale).roundToInt(), (y * scale).roundToInt())
+    }
+
+    // Creates the window's XSync counter and advertises _NET_WM_SYNC_REQUEST.
+    // Returns the XID handle onNativeSyncRequests reports once frame sync is active
+    // for the window, or 0.
+    @JvmStatic
+    external fun nativeEnableFrameSync(awtWindow: java.awt.Window): Long
+
+    // Hook for the render loop: call after presenting the frame for the size the WM
+    // requested. Returns true if a pending sync request was acknowledged.
+    @JvmStatic
+    external fun nativeFrameSyncPresented(awtWindow: java.awt.Window): Boolean
+
+    // Withdraws _NET_WM_SYNC_REQUEST and destroys the window's XSync counter.
+    @JvmStatic
+    external fun nativeDisableFrameSync(awtWindow: java.awt.Window)
+
+    // Sets _NET_WM_OPAQUE_REGION. rects: packed x, y, width, height quadruples in
+    // physical pixels, relative to the window (max 16 rectangles). Empty removes the hint.
+    @JvmStatic
+    external fun nativeSetOpaqueRegion(
+        awtWindow: java.awt.Window,
+        rects: IntArray,
+    ): Boolean
+
+    // Sets _NET_WM_BYPASS_COMPOSITOR. mode: BYPASS_COMPOSITOR_*.
+    @JvmStatic
+    external fun nativeSetBypassCompositor(
+        awtWindow: java.awt.Window,
+        mode: Int,
+    ): Boolean
+
+    // AWT lock statistics for benchmarks and diagnostics: { holds, total hold nanos,
+    // max hold nanos } accumulated by the bridge since the last reset.
+    @JvmStatic
+    external fun nativeGetAwtLockStats(): LongArray
+
+    @JvmStatic
+    external fun nativeResetAwtLockStats()
+
+    // Call statistics, read through NucleusNativeStats: { calls, errors, total nanos,
+    // max nanos } per STATS_PROBES entry.
+    @JvmStatic
+    private external fun nativeGetStats(): LongArray
+
+    @JvmStatic
+    private external fun nativeSetStatsEnabled(enabled: Boolean)
+
+    // Starts pushing the window's WM state (WINDOW_STATE_* bits and _NET_FRAME_EXTENTS)
+    // to onNativeWindowStates: once now, then once per settled change.
+    // Returns the XID handle for nativeStopObservingWindowState, or 0 if unavailable.
+    @JvmStatic
+    external fun nativeObserveWindowState(awtWindow: java.awt.Window): Long
+
+    @JvmStatic
+    external fun nativeStopObservingWindowState(xid: Long)
+
+    // Receives the state of one or more observed windows in a single call from the
+    // native watcher thread: WINDOW_STATE_RECORD_SIZE longs per window.
+    private val windowStateListeners = ConcurrentHashMap<Long, (LongArray) -> Unit>()
+    private val lastWindowStates = ConcurrentHashMap<Long, LongArray>()
+
+    @JvmStatic
+    fun onNativeWindowStates(batch: LongArray) {
+        for (offset in batch.indices step WINDOW_STATE_RECORD_SIZE) {
+            val record = batch.copyOfRange(offset, offset + WINDOW_STATE_RECORD_SIZE)
+            val xid = record[0]
+            lastWindowStates[xid] = record
+            windowStateListeners[xid]?.invoke(record)
+        }
+    }
+
+    // Observes [window]'s WM state; [listener] is called on the watcher thread with a
+    // record of { xid, WINDOW_STATE_* bits, frame extents left, right, top, bottom }.
+    // Returns the handle for stopObservingWindowState, or 0 when unavailable.
+    fun observeWindowState(
+        window: java.awt.Window,
+        listener: (LongArray) -> Unit,
+    ): Long {
+        if (!loaded) return 0L
+        val xid = nativeObserveWindowState(window)
+        if (xid == 0L) return 0L
+        windowStateListeners[xid] = listener
+        // The initial state may have been pushed before the listener was registered
+        lastWindowStates[xid]?.let(listener)
+        return xid
+    }
+
+    fun stopObservingWindowState(handle: Long) {
+        if (handle == 0L) return
+        windowStateListeners.remove(handle)
+        lastWindowStates.remove(handle)
+        nativeStopObservingWindowState(handle)
+    }
+
+    // Receives, from the native watcher thread, the windows whose sync request was not
+    // acknowledged by a resize (the WM's configure brought no size change).
+    private val syncRequestListeners = ConcurrentHashMap<Long, () -> Unit>()
+
+    @JvmStatic
+    fun onNativeSyncRequests(xids: LongArray) {
+        for (xid in xids) syncRequestListeners[xid]?.invoke()
+    }
+
+    // Enables frame sync for [window]; [onSyncRequest] is called on the watcher thread
+    // when a sync request is waiting for a presented frame that no resize will bring.
+    // Returns the handle for disableFrameSync, or 0 when unavailable.
+    fun enableFrameSync(
+        window: java.awt.Window,
+        onSyncRequest: () -> Unit,
+    ): Long {
+        if (!loaded) return 0L
+        val xid = nativeEnableFrameSync(window)
+        if (xid != 0L) syncRequestListeners[xid] = onSyncRequest
+        return xid
+    }
+
+    fun disableFrameSync(
+        window: java.awt.Window,
+        handle: Long,
+    ) {
+        if (handle == 0L) return
+        syncRequestListeners.remove(handle)
+        nativeDisableFrameSync(window)
+    }
+
+    // Returns true if the WM advertises every bit in [capability].
+    fun hasWmCapability(capability: Long): Boolean = loaded && (nativeGetWmCapabilities() and capability) == capability
+
+    // _NET_WM_STATE actions and state codes (must match STATE_ATOMS in nucleus_linux_window.c).
+    const val STATE_ACTION_REMOVE = 0
+    const val STATE_ACTION_ADD = 1
+    const val STATE_ACTION_TOGGLE = 2
+
+    const val STATE_NONE = 0
+    const val STATE_MAXIMIZED_VERT = 1
+    const val STATE_MAXIMIZED_HORZ = 2
+    const val STATE_FULLSCREEN = 3
+    const val STATE_HIDDEN = 4
+    const val STATE_ABOVE = 5
+
+    // Window state bits pushed by the native observer (must match WINDOW_STATE_* in
+    // nucleus_linux_window.c).
+    const val WINDOW_STATE_MAXIMIZED_VERT = 1L shl 0
+    const val WINDOW_STATE_MAXIMIZED_HORZ = 1L shl 1
+    const val WINDOW_STATE_FULLSCREEN = 1L shl 2
+    const val WINDOW_STATE_HIDDEN = 1L shl 3
+    const val WINDOW_STATE_TILED_TOP = 1L shl 4
+    const val WINDOW_STATE_TILED_RIGHT = 1L shl 5
+    const val WINDOW_STATE_TILED_BOTTOM = 1L shl 6
+    const val WINDOW_STATE_TILED_LEFT = 1L shl 7
+    const val WINDOW_STATE_RECORD_SIZE = 6
+
+    // _NET_WM_BYPASS_COMPOSITOR values.
+    const val BYPASS_COMPOSITOR_NONE = 0
+    const val BYPASS_COMPOSITOR_ON = 1
+    const val BYPASS_COMPOSITOR_NEVER = 2
+
+    // Bit values must match CAPABILITY_ATOMS in nucleus_linux_window.c.
+    const val WM_CAP_PRESENT = 1L shl 0
+    const val WM_CAP_MOVERESIZE = 1L shl 1
+    const val WM_CAP_STATE = 1L shl 2
+    const val WM_CAP_STATE_MAXIMIZED_VERT = 1L shl 3
+    const val WM_CAP_STATE_MAXIMIZED_HORZ = 1L shl 4
+    const val WM_CAP_STATE_FULLSCREEN = 1L shl 5
+    const val WM_CAP_STATE_HIDDEN = 1L shl 6
+    const val WM_CAP_STATE_ABOVE = 1L shl 7
+    const val WM_CAP_FRAME_EXTENTS = 1L shl 8
+    const val WM_CAP_SYNC_REQUEST = 1L shl 9
+    const val WM_CAP_OPAQUE_REGION = 1L shl 10
+    const val WM_CAP_BYPASS_COMPOSITOR = 1L shl 11
+    const val WM_CAP_GTK_FRAME_EXTENTS = 1L shl 12
 }
@@ -0,0 +1,48 @@
+package io.github.kdroidfilter.nucleus.window.utils.linux
+
+import io.github.kdroidfilter.nucleus.window.WindowCompositorHints
+import java.awt.Window
+import java.util.WeakHashMap
+import kotlin.math.ceil
+import kotlin.math.floor
+
+// Pushes DecoratedWindowBody's compositor hints to the window's X11 properties.
+// Hints are only re-sent when they change, and only remembered once the native
+// calls succeed (the X window may not exist yet on the first update).
+internal object LinuxCompositorHints {
+    private val applied = WeakHashMap<Window, WindowCompositorHints>()
+
+    fun apply(
+        window: Window,
+        hints: WindowCompositorHints,
+    ) {
+        if (!JniLinuxWindowBridge.isLoaded || applied[window] == hints) return
+
+        val scale = window.graphicsConfiguration?.defaultTransform?.scaleX ?: 1.0
+        val packed = IntArray(hints.opaqueRegion.size * 4)
+        hints.opaqueRegion.forEachIndexed { i, rect ->
+            // Round inwards: an opaque region must never cover translucent pixels
+            val x0 = ceil(rect.x * scale).toInt()
+            val y0 = ceil(rect.y * scale).toInt()
+            val x1 = floor((rect.x + rect.width) * scale).toInt()
+            val y1 = floor((rect.y + rect.height) * scale).toInt()
+            packed[i * 4] = x0
+            packed[i * 4 + 1] = y0
+            packed[i * 4 + 2] = maxOf(0, x1 - x0)
+            packed[i * 4 + 3] = maxOf(0, y1 - y0)
+        }
+
+        val bypass =
+            if (hints.bypassCompositor) {
+                JniLinuxWindowBridge.BYPASS_COMPOSITOR_ON
+            } else {
+                JniLinuxWindowBridge.BYPASS_COMPOSITOR_NONE
+            }
+
+        if (JniLinuxWindowBridge.nativeSetOpaqueRegion(window, packed) &&
+            JniLinuxWindowBridge.nativeSetBypassCompositor(window, bypass)
+        ) {
+            applied[window] = hints
+        }
+    }
+}
@@ -0,0 +1,64 @@
+package io.github.kdroidfilter.nucleus.window.utils.linux
+
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.DisposableEffect
+import androidx.compose.runtime.LaunchedEffect
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.withFrameNanos
+import androidx.compose.ui.awt.ComposeWindow
+import kotlinx.coroutines.channels.Channel
+import java.awt.event.ComponentAdapter
+import java.awt.event.ComponentEvent
+import javax.swing.SwingUtilities
+
+// Frame-synchronised resizing via _NET_WM_SYNC_REQUEST.
+// Each resize waits for the Compose frame laid out at the new size, then publishes the
+// serial the WM asked for, so the WM sends the next configure only once we caught up.
+// A request whose configure brings no size change (clamped by the minimum size, or a
+// move) has no resize event: the bridge reports it and the next presented frame acks it.
+@Suppress("FunctionNaming")
+@Composable
+internal fun LinuxFrameSyncEffect(window: ComposeWindow) {
+    val resized = remember(window) { Channel<Unit>(Channel.CONFLATED) }
+
+    DisposableEffect(window) {
+        val supported = JniLinuxWindowBridge.hasWmCapability(JniLinuxWindowBridge.WM_CAP_SYNC_REQUEST)
+        var handle = 0L
+
+        // The X window may not exist yet on first composition, so retry until it does.
+        fun ensureEnabled() {
+            if (supported && handle == 0L) {
+                handle = JniLinuxWindowBridge.enableFrameSync(window) { resized.trySend(Unit) }
+            }
+        }
+
+        val listener =
+            object : ComponentAdapter() {
+                override fun componentShown(e: ComponentEvent?) {
+                    ensureEnabled()
+                }
+
+                override fun componentResized(e: ComponentEvent?) {
+                    ensureEnabled()
+                    if (handle != 0L) resized.trySend(Unit)
+                }
+            }
+
+        ensureEnabled()
+        if (supported) window.addComponentListener(listener)
+
+        onDispose {
+            if (supported) window.removeComponentListener(listener)
+            JniLinuxWindowBridge.disableFrameSync(window, handle)
+        }
+    }
+
+    LaunchedEffect(window) {
+        for (event in resized) {
+            // Frame callbacks run at the start of the frame rendered at the new size;
+            // invokeLater lands after that EDT task has drawn and presented it.
+            withFrameNanos { }
+            SwingUtilities.invokeLater { JniLinuxWindowBridge.nativeFrameSyncPresented(window) }
+        }
+    }
+}
@@ -0,0 +1,79 @@
+package io.github.kdroidfilter.nucleus.window.utils.linux
+
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.DisposableEffect
+import androidx.compose.runtime.getValue
+import androidx.compose.runtime.mutableStateOf
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.setValue
+import io.github.kdroidfilter.nucleus.window.WindowManagerState
+import java.awt.Insets
+import java.awt.Window
+import java.awt.event.HierarchyEvent
+import java.awt.event.HierarchyListener
+import javax.swing.SwingUtilities
+
+// Follows the window's state as the window manager reports it, through the native
+// watcher (one batched update per settled change). Null until the first update, or
+// when the native observer is unavailable, in which case callers keep AWT's view.
+@Composable
+internal fun rememberLinuxWindowManagerState(window: Window): WindowManagerState? {
+    var state by remember(window) { mutableStateOf<WindowManagerState?>(null) }
+
+    DisposableEffect(window) {
+        var handle = 0L
+
+        fun start() {
+            if (handle != 0L || !window.isDisplayable) return
+            handle =
+                JniLinuxWindowBridge.observeWindowState(window) { record ->
+                    val update = record.toWindowManagerState()
+                    SwingUtilities.invokeLater { state = update }
+                }
+        }
+
+        fun stop() {
+            JniLinuxWindowBridge.stopObservingWindowState(handle)
+            handle = 0L
+        }
+
+        // The X window only exists while the peer does
+        val listener =
+            HierarchyListener { e ->
+                if (e.changeFlags and HierarchyEvent.DISPLAYABILITY_CHANGED.toLong() != 0L) {
+                    if (window.isDisplayable) start() else stop()
+                }
+            }
+        window.addHierarchyListener(listener)
+        start()
+
+        onDispose {
+            window.removeHierarchyListener(listener)
+            stop()
+        }
+    }
+
+    return state
+}
+
+// { xid, WINDOW_STATE_* bits, extents left, right, top, bottom }
+private fun LongArray.toWindowManagerState(): WindowManagerState {
+    val bits = this[1]
+    fun has(flag: Long) = bits and flag != 0L
+
+    var tiledEdges = 0
+    if (has(JniLinuxWindowBridge.WINDOW_STATE_TILED_TOP)) tiledEdges = tiledEdges or WindowManagerState.TiledTop
+    if (has(JniLinuxWindowBridge.WINDOW_STATE_TILED_RIGHT)) tiledEdges = tiledEdges or WindowManagerState.TiledRight
+    if (has(JniLinuxWindowBridge.WINDOW_STATE_TILED_BOTTOM)) tiledEdges = tiledEdges or WindowManagerState.TiledBottom
+    if (has(JniLinuxWindowBridge.WINDOW_STATE_TILED_LEFT)) tiledEdges = tiledEdges or WindowManagerState.TiledLeft
+
+    return WindowManagerState(
+        maximized =
+            has(JniLinuxWindowBridge.WINDOW_STATE_MAXIMIZED_VERT) &&
+                has(JniLinuxWindowBridge.WINDOW_STATE_MAXIMIZED_HORZ),
+        fullscreen = has(JniLinuxWindowBridge.WINDOW_STATE_FULLSCREEN),
+        minimized = has(JniLinuxWindowBridge.WINDOW_STATE_HIDDEN),
+        tiledEdges = tiledEdges,
+        frameExtents = Insets(this[4].toInt(), this[2].toInt(), this[5].toInt(), this[3].toInt()),
+    )
+}
@@ -1,194 +1,1126 @@
 /**
- * JNI bridge for Linux native window move via _NET_WM_MOVERESIZE.
+ * JNI bridge for Linux native window move/resize via _NET_WM_MOVERESIZE.
  *
  * Replicates the JBR's XNETProtocol logic:
- *   1. Acquire AWT lock (SunToolkit.awtLock())
- *   2. Ungrab pointer and keyboard
- *   3. Send _NET_WM_MOVERESIZE ClientMessage to the root window
- *   4. XFlush + release AWT lock
+ *   1. Ungrab pointer and keyboard on AWT's connection (brief AWT lock)
+ *   2. Query the pointer and send the _NET_WM_MOVERESIZE ClientMessage
+ *      to the root window over the bridge's own X connection
  *
  * X11 handles are obtained via JNI reflection into AWT internals
  * (bypasses JPMS restrictions, same pattern as the Windows nativeGetHwnd).
  *
- * Linked libraries: -lX11
+ * Window commands (EWMH ClientMessages, property reads and writes) use a
+ * private Display* guarded by a plain mutex, so they never hold the AWT
+ * lock while the toolkit thread is dispatching events. If that connection
+ * cannot be opened, they fall back to AWT's Display under the AWT lock.
+ *
+ * Everything that never changes for the life of the process (class refs,
+ * method IDs, the AWT Display* and interned atoms) is resolved once in
+ * JNI_OnLoad, and each java.awt.Window's shell XID is cached until its
+ * peer is disposed, so a title-bar press costs no FindClass/GetMethodID
+ * lookups and no XInternAtom round trip.
+ *
+ * WM capabilities (_NET_SUPPORTED) are kept as a bitmap snapshot that a
+ * watcher thread, on its own X connection, invalidates when the root
+ * window's _NET_SUPPORTED or _NET_SUPPORTING_WM_CHECK changes.
+ *
+ * The same thread observes shell windows on request (PropertyNotify and
+ * ConfigureNotify): maximized/tiled/fullscreen state and _NET_FRAME_EXTENTS
+ * are re-read once an event burst settles and pushed to Kotlin in one
+ * batched call, only when they actually changed.
+ *
+ * Maximize/fullscreen/minimize requests are sent directly as
+ * _NET_WM_STATE / WM_CHANGE_STATE ClientMessages, so a state change is a
+ * single WM transaction instead of a round trip through XToolkit.
+ *
+ * Frame-synchronised resizing (_NET_WM_SYNC_REQUEST): the bridge owns an
+ * XSync counter per window and watches AWT's incoming ClientMessages with
+ * an Xlib wire-to-event hook (AWT ignores unknown WM_PROTOCOLS). The serial
+ * the WM asks for is published once Compose has presented the frame for
+ * the new size, so the WM paces resizes to our real render throughput.
+ * Requests that no resize acknowledges (the size was clamped, or did not
+ * change) are handed to Kotlin by the watcher and acked on the next frame.
+ *
+ * Compositor hints (_NET_WM_OPAQUE_REGION and _NET_WM_BYPASS_COMPOSITOR)
+ * let the compositor skip blending the opaque body of our
+ * client-side-decorated windows and unredirect fullscreen.
+ *
+ * Each JNI entry point, watcher wakeup and state push is a probe of
+ * nucleus_native_stats.h (core-runtime); commands returning false count as
+ * errors.
+ *
+ * Linked libraries: -lX11 -lXext -lpthread
  */
 
 #include <jni.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include <X11/Xlib.h>
 #include <X11/Xatom.h>
+#include <X11/Xutil.h>
+#include <X11/Xproto.h>
+#include <X11/extensions/sync.h>
+
+#ifdef NUCLEUS_LINUX_COMBINED
+/* Built into libnucleus_linux, which runs this when JniLinuxWindowBridge loads */
+#include "nucleus_linux_combined.h"
+#define JNI_OnLoad nucleus_window_OnLoad
+#endif
+
+/* Call statistics probes (must match STATS_PROBES in JniLinuxWindowBridge.kt) */
+enum {
+    PROBE_ON_LOAD,
+    PROBE_START_WINDOW_MOVE,
+    PROBE_START_WINDOW_RESIZE,
+    PROBE_MOVE_WINDOW,
+    PROBE_IS_WM_MOVE_RESIZE_SUPPORTED,
+    PROBE_GET_WM_CAPABILITIES,
+    PROBE_OBSERVE_WINDOW_STATE,
+    PROBE_STOP_OBSERVING_WINDOW_STATE,
+    PROBE_SET_WINDOW_STATE,
+    PROBE_MINIMIZE_WINDOW,
+    PROBE_ENABLE_FRAME_SYNC,
+    PROBE_FRAME_SYNC_PRESENTED,
+    PROBE_DISABLE_FRAME_SYNC,
+    PROBE_SET_OPAQUE_REGION,
+    PROBE_SET_BYPASS_COMPOSITOR,
+    PROBE_WATCHER_WAKEUP,
+    PROBE_PUBLISH_WINDOW_STATES,
+    PROBE_COUNT
+};
+#define NUCLEUS_STATS_PROBES PROBE_COUNT
+#include "nucleus_native_stats.h"
+
+/* From Xlibint.h (not included: it drags in Xlib's private macros) */
+extern Bool (*XESetWireToEvent(Display *, int,
+                               Bool (*)(Display *, XEvent *, xEvent *)))
+                              (Display *, XEvent *, xEvent *);
+
+#define _NET_WM_MOVERESIZE_SIZE_TOPLEFT      0
+#define _NET_WM_MOVERESIZE_SIZE_LEFT         7
+#define _NET_WM_MOVERESIZE_MOVE              8
+#define _NET_WM_MOVERESIZE_CANCEL           11
+
+#define _NET_WM_STATE_REMOVE 0
+#define _NET_WM_STATE_ADD    1
+#define _NET_WM_STATE_TOGGLE 2
+
+/* ------------------------------------------------------------------ */
+/*  JNI cache — global class refs and method IDs (set in JNI_OnLoad)   */
+/* ------------------------------------------------------------------ */
+static jclass    g_xToolkitClass    = NULL;   /* sun.awt.X11.XToolkit   */
+static jclass    g_sunToolkitClass  = NULL;   /* sun.awt.SunToolkit     */
+static jobject   g_compAccessor     = NULL;   /* ComponentAccessor instance */
+
+static jmethodID g_getDisplay = NULL;         /* XToolkit.getDisplay()  */
+static jmethodID g_getPeer    = NULL;         /* ComponentAccessor.getPeer(Component) */
+static jmethodID g_getWindow  = NULL;         /* XBaseWindow.getWindow() */
+static jmethodID g_awtLock    = NULL;         /* SunToolkit.awtLock()   */
+static jmethodID g_awtUnlock  = NULL;         /* SunToolkit.awtUnlock() */
+
+/* ------------------------------------------------------------------ */
+/*  Atom cache — interned once per process on the AWT Display          */
+/* ------------------------------------------------------------------ */
+enum {
+    ATOM_NET_WM_MOVERESIZE,
+    ATOM_NET_SUPPORTED,
+    ATOM_NET_SUPPORTING_WM_CHECK,
+    ATOM_NET_WM_STATE,
+    ATOM_NET_WM_STATE_MAXIMIZED_VERT,
+    ATOM_NET_WM_STATE_MAXIMIZED_HORZ,
+    ATOM_NET_WM_STATE_FULLSCREEN,
+    ATOM_NET_WM_STATE_HIDDEN,
+    ATOM_NET_WM_STATE_ABOVE,
+    ATOM_NET_FRAME_EXTENTS,
+    ATOM_NET_WM_SYNC_REQUEST,
+    ATOM_NET_WM_OPAQUE_REGION,
+    ATOM_NET_WM_BYPASS_COMPOSITOR,
+    ATOM_GTK_FRAME_EXTENTS,
+    ATOM_WM_CHANGE_STATE,
+    ATOM_WM_PROTOCOLS,
+    ATOM_NET_WM_SYNC_REQUEST_COUNTER,
+    ATOM_GTK_EDGE_CONSTRAINTS,
+    ATOM_COUNT
+};
+
+static const char *ATOM_NAMES[ATOM_COUNT] = {
+    "_NET_WM_MOVERESIZE",
+    "_NET_SUPPORTED",
+    "_NET_SUPPORTING_WM_CHECK",
+    "_NET_WM_STATE",
+    "_NET_WM_STATE_MAXIMIZED_VERT",
+    "_NET_WM_STATE_MAXIMIZED_HORZ",
+    "_NET_WM_STATE_FULLSCREEN",
+    "_NET_WM_STATE_HIDDEN",
+    "_NET_WM_STATE_ABOVE",
+    "_NET_FRAME_EXTENTS",
+    "_NET_WM_SYNC_REQUEST",
+    "_NET_WM_OPAQUE_REGION",
+    "_NET_WM_BYPASS_COMPOSITOR",
+    "_GTK_FRAME_EXTENTS",
+    "WM_CHANGE_STATE",
+    "WM_PROTOCOLS",
+    "_NET_WM_SYNC_REQUEST_COUNTER",
+    "_GTK_EDGE_CONSTRAINTS",
+};
+
+/* State codes accepted by nativeSetWindowState (JniLinuxWindowBridge.STATE_*) */
+static const int STATE_ATOMS[] = {
+    -1,                                 /* 0 = none */
+    ATOM_NET_WM_STATE_MAXIMIZED_VERT,   /* 1 */
+    ATOM_NET_WM_STATE_MAXIMIZED_HORZ,   /* 2 */
+    ATOM_NET_WM_STATE_FULLSCREEN,       /* 3 */
+    ATOM_NET_WM_STATE_HIDDEN,           /* 4 */
+    ATOM_NET_WM_STATE_ABOVE,            /* 5 */
+};
+#define STATE_COUNT (int)(sizeof(STATE_ATOMS) / sizeof(STATE_ATOMS[0]))
+
+static Display        *g_display = NULL;
+static Atom            g_atoms[ATOM_COUNT];
+static atomic_int      g_atomsReady = 0;
+static pthread_mutex_t g_atomLock   = PTHREAD_MUTEX_INITIALIZER;
+
+/* ------------------------------------------------------------------ */
+/*  Command connection                                                 */
+/* ------------------------------------------------------------------ */
+static Display        *g_cmdDisplay = NULL;
+static int             g_cmdState   = 0;   /* 0 = not tried, 1 = open, -1 = unavailable */
+#ifdef NUCLEUS_LINUX_COMBINED
+/* The combined library's shared connection and lock, when they reach AWT's server */
+#define g_cmdLock nucleus_display_lock
+#else
+static pthread_mutex_t g_cmdLock    = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* A held connection: either the private one (g_cmdLock) or AWT's (AWT lock) */
+typedef struct {
+    Display *display;
+    int      usesAwtLock;
+} XCommand;
+
+/* ------------------------------------------------------------------ */
+/*  WM capability snapshot                                             */
+/*  Bit values must match JniLinuxWindowBridge.WM_CAP_*.               */
+/* ------------------------------------------------------------------ */
+#define WM_CAP_PRESENT    (1LL << 0)   /* a WM answers _NET_SUPPORTING_WM_CHECK */
+#define WM_CAP_MOVERESIZE (1LL << 1)   /* first entry of CAPABILITY_ATOMS */
 
-#define _NET_WM_MOVERESIZE_MOVE     8
-#define _NET_WM_MOVERESIZE_CANCEL  11
+static const int CAPABILITY_ATOMS[] = {
+    ATOM_NET_WM_MOVERESIZE,             /* bit 1  */
+    ATOM_NET_WM_STATE,                  /* bit 2  */
+    ATOM_NET_WM_STATE_MAXIMIZED_VERT,   /* bit 3  */
+    ATOM_NET_WM_STATE_MAXIMIZED_HORZ,   /* bit 4  */
+    ATOM_NET_WM_STATE_FULLSCREEN,       /* bit 5  */
+    ATOM_NET_WM_STATE_HIDDEN,           /* bit 6  */
+    ATOM_NET_WM_STATE_ABOVE,            /* bit 7  */
+    ATOM_NET_FRAME_EXTENTS,             /* bit 8  */
+    ATOM_NET_WM_SYNC_REQUEST,           /* bit 9  */
+    ATOM_NET_WM_OPAQUE_REGION,          /* bit 10 */
+    ATOM_NET_WM_BYPASS_COMPOSITOR,      /* bit 11 */
+    ATOM_GTK_FRAME_EXTENTS,             /* bit 12 */
+};
+#define CAPABILITY_COUNT (int)(sizeof(CAPABILITY_ATOMS) / sizeof(CAPABILITY_ATOMS[0]))
+
+static atomic_llong g_capabilities  = 0;
+static atomic_int   g_capsDirty     = 1;   /* snapshot must be (re)filled */
+static atomic_int   g_watcherActive = 0;   /* root PropertyNotify is being watched */
+
+/* ------------------------------------------------------------------ */
+/*  Per-window XID cache                                               */
+/*  Each entry holds weak refs to the java.awt.Window and to the peer  */
+/*  the XID was read from. A different (or null) peer means the old    */
+/*  one was disposed, so the entry is refreshed.                       */
+/* ------------------------------------------------------------------ */
+#define XID_CACHE_SIZE 16
+
+typedef struct {
+    jweak    window;
+    jweak    peer;
+    Window   xid;
+    unsigned stamp;
+} XidCacheEntry;
+
+static XidCacheEntry   g_xidCache[XID_CACHE_SIZE];
+static unsigned        g_xidStamp = 0;
+static pthread_mutex_t g_xidLock  = PTHREAD_MUTEX_INITIALIZER;
+
+/* Clears a pending exception; returns 1 if there was one. */
+static int clearException(JNIEnv *env) {
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionClear(env);
+        return 1;
+    }
+    return 0;
+}
+
+static jclass findGlobalClass(JNIEnv *env, const char *name) {
+    jclass local = (*env)->FindClass(env, name);
+    if (!local || clearException(env)) return NULL;
+    jclass global = (jclass)(*env)->NewGlobalRef(env, local);
+    (*env)->DeleteLocalRef(env, local);
+    return global;
+}
+
+static jmethodID findMethod(JNIEnv *env, jclass cls, const char *name,
+                            const char *sig, int isStatic) {
+    if (!cls) return NULL;
+    jmethodID mid = isStatic
+        ? (*env)->GetStaticMethodID(env, cls, name, sig)
+        : (*env)->GetMethodID(env, cls, name, sig);
+    if (clearException(env)) return NULL;
+    return mid;
+}
+
+/* Resolves the AWT classes and method IDs. Safe to call more than once. */
+static void initJniCache(JNIEnv *env) {
+    if (!g_xToolkitClass) {
+        g_xToolkitClass = findGlobalClass(env, "sun/awt/X11/XToolkit");
+        g_getDisplay = findMethod(env, g_xToolkitClass, "getDisplay", "()J", 1);
+    }
+
+    if (!g_sunToolkitClass) {
+        g_sunToolkitClass = findGlobalClass(env, "sun/awt/SunToolkit");
+        g_awtLock   = findMethod(env, g_sunToolkitClass, "awtLock", "()V", 1);
+        g_awtUnlock = findMethod(env, g_sunToolkitClass, "awtUnlock", "()V", 1);
+    }
+
+    if (!g_compAccessor) {
+        jclass accessorClass = (*env)->FindClass(env, "sun/awt/AWTAccessor");
+        if (accessorClass && !clearException(env)) {
+            jmethodID getCompAccessor = findMethod(env, accessorClass,
+                "getComponentAccessor", "()Lsun/awt/AWTAccessor$ComponentAccessor;", 1);
+            if (getCompAccessor) {
+                jobject accessor = (*env)->CallStaticObjectMethod(env, accessorClass, getCompAccessor);
+                if (accessor && !clearException(env)) {
+                    g_compAccessor = (*env)->NewGlobalRef(env, accessor);
+                    (*env)->DeleteLocalRef(env, accessor);
+                }
+            }
+            (*env)->DeleteLocalRef(env, accessorClass);
+        }
+
+        jclass compAccessorClass = (*env)->FindClass(env, "sun/awt/AWTAccessor$ComponentAccessor");
+        if (compAccessorClass && !clearException(env)) {
+            g_getPeer = findMethod(env, compAccessorClass,
+                "getPeer", "(Ljava/awt/Component;)Ljava/awt/peer/ComponentPeer;", 0);
+            (*env)->DeleteLocalRef(env, compAccessorClass);
+        }
+    }
+
+    if (!g_getWindow) {
+        jclass xBaseWindowClass = (*env)->FindClass(env, "sun/awt/X11/XBaseWindow");
+        if (xBaseWindowClass && !clearException(env)) {
+            g_getWindow = findMethod(env, xBaseWindowClass, "getWindow", "()J", 0);
+            (*env)->DeleteLocalRef(env, xBaseWindowClass);
+        }
+    }
+}
 
 /* ------------------------------------------------------------------ */
 /*  Helper: get X11 Display* from AWT (XToolkit.getDisplay())          */
+/*  The Display never changes once XToolkit is up, so it is cached.    */
 /* ------------------------------------------------------------------ */
 static Display *getAwtDisplay(JNIEnv *env) {
-    jclass xToolkitClass = (*env)->FindClass(env, "sun/awt/X11/XToolkit");
-    if (!xToolkitClass || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        return NULL;
+    if (g_display) return g_display;
+    if (!g_xToolkitClass || !g_getDisplay) initJniCache(env);
+    if (!g_xToolkitClass || !g_getDisplay) return NULL;
+
+    jlong displayPtr = (*env)->CallStaticLongMethod(env, g_xToolkitClass, g_getDisplay);
+    if (clearException(env)) return NULL;
+
+    g_display = (Display *)(uintptr_t)displayPtr;
+    return g_display;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Helper: intern every atom in a single round trip.                  */
+/*  Atoms are server-wide, so any connection will do; the caller must  */
+/*  hold whichever lock guards `display`.                              */
+/* ------------------------------------------------------------------ */
+static int ensureAtoms(Display *display) {
+    if (atomic_load(&g_atomsReady)) return 1;
+    pthread_mutex_lock(&g_atomLock);
+    if (!atomic_load(&g_atomsReady)
+        && XInternAtoms(display, (char **)ATOM_NAMES, ATOM_COUNT, False, g_atoms)) {
+        atomic_store(&g_atomsReady, 1);
     }
+    pthread_mutex_unlock(&g_atomLock);
+    return atomic_load(&g_atomsReady);
+}
 
-    jmethodID getDisplay = (*env)->GetStaticMethodID(env, xToolkitClass, "getDisplay", "()J");
-    if (!getDisplay || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, xToolkitClass);
-        return NULL;
+/* ------------------------------------------------------------------ */
+/*  Helper: acquire/release AWT lock via SunToolkit                    */
+/*  Hold times are accumulated for nativeGetAwtLockStats (the bridge   */
+/*  never nests the AWT lock, so one start time per thread suffices).  */
+/* ------------------------------------------------------------------ */
+static atomic_llong g_awtLockHolds     = 0;
+static atomic_llong g_awtLockHoldNanos = 0;
+static atomic_llong g_awtLockMaxNanos  = 0;
+static _Thread_local long long t_awtLockSince = 0;
+
+static long long monotonicNanos(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static jboolean awtLock(JNIEnv *env) {
+    if (!g_awtLock || !g_awtUnlock) initJniCache(env);
+    if (!g_awtLock || !g_awtUnlock) return JNI_FALSE;
+    (*env)->CallStaticVoidMethod(env, g_sunToolkitClass, g_awtLock);
+    if (clearException(env)) return JNI_FALSE;
+    t_awtLockSince = monotonicNanos();
+    return JNI_TRUE;
+}
+
+static void awtUnlock(JNIEnv *env) {
+    if (!g_awtUnlock) return;
+    long long held = monotonicNanos() - t_awtLockSince;
+    (*env)->CallStaticVoidMethod(env, g_sunToolkitClass, g_awtUnlock);
+    clearException(env);
+
+    atomic_fetch_add(&g_awtLockHolds, 1);
+    atomic_fetch_add(&g_awtLockHoldNanos, held);
+    long long max = atomic_load(&g_awtLockMaxNanos);
+    while (held > max && !atomic_compare_exchange_weak(&g_awtLockMaxNanos, &max, held)) {
     }
+}
 
-    jlong displayPtr = (*env)->CallStaticLongMethod(env, xToolkitClass, getDisplay);
-    (*env)->DeleteLocalRef(env, xToolkitClass);
-    if ((*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        return NULL;
+/* ------------------------------------------------------------------ */
+/*  Helper: open the private command connection to AWT's X server.     */
+/*  Must be called with g_cmdLock held.                                */
+/* ------------------------------------------------------------------ */
+static void openCommandDisplay(JNIEnv *env) {
+    if (g_cmdState != 0) return;
+    Display *awtDisplay = getAwtDisplay(env);
+    /* XToolkit not up yet (e.g. loaded before AWT): retry on the next command */
+    if (!awtDisplay) return;
+#ifdef NUCLEUS_LINUX_COMBINED
+    /* The shared connection follows $DISPLAY, which may name another server
+       than AWT's: adopt it only when both display names match */
+    Display *shared = (Display *)nucleus_shared_display();
+    if (shared && strcmp(XDisplayString(shared), XDisplayString(awtDisplay)) == 0) {
+        g_cmdDisplay = shared;
+        g_cmdState = 1;
+        return;
+    }
+#endif
+    /* XDisplayString only reads the struct: no AWT lock needed */
+    g_cmdDisplay = XOpenDisplay(XDisplayString(awtDisplay));
+    g_cmdState = g_cmdDisplay ? 1 : -1;
+}
+
+/* ------------------------------------------------------------------ */
+/*  beginX / endX                                                      */
+/*  Acquire a connection for window commands: the private one under    */
+/*  g_cmdLock, or AWT's under the AWT lock when the private connection */
+/*  is unavailable. Also makes sure atoms are interned, and starts the */
+/*  watcher (which relies on them) the first time that succeeds.       */
+/* ------------------------------------------------------------------ */
+static void startWatcher(JNIEnv *env);
+static atomic_int g_watcherTried;
+
+static void endX(JNIEnv *env, XCommand *cmd) {
+    if (cmd->usesAwtLock) {
+        awtUnlock(env);
+    } else {
+        pthread_mutex_unlock(&g_cmdLock);
+    }
+}
+
+static int beginX(JNIEnv *env, XCommand *cmd) {
+    pthread_mutex_lock(&g_cmdLock);
+    if (g_cmdState == 0) openCommandDisplay(env);
+
+    if (g_cmdDisplay) {
+        cmd->display = g_cmdDisplay;
+        cmd->usesAwtLock = 0;
+    } else {
+        pthread_mutex_unlock(&g_cmdLock);
+        Display *display = getAwtDisplay(env);
+        if (!display || !awtLock(env)) return 0;
+        cmd->display = display;
+        cmd->usesAwtLock = 1;
     }
 
-    return (Display *)(uintptr_t)displayPtr;
+    if (!ensureAtoms(cmd->display)) {
+        endX(env, cmd);
+        return 0;
+    }
+    /* AWT's display is known by now; the watcher opens its own connection */
+    int untried = 0;
+    if (atomic_compare_exchange_strong(&g_watcherTried, &untried, 1)) startWatcher(env);
+    return 1;
 }
 
 /* ------------------------------------------------------------------ */
 /*  Helper: get X11 Window from AWT peer                               */
 /*  AWTAccessor → getComponentAccessor() → getPeer(window) →           */
 /*  XBaseWindow.getWindow() (returns the shell window ID)              */
+/*  getWindow() is only called when the window or its peer is new.     */
 /* ------------------------------------------------------------------ */
 static Window getAwtX11Window(JNIEnv *env, jobject awtWindow) {
     if (!awtWindow) return 0;
+    if (!g_compAccessor || !g_getPeer || !g_getWindow) initJniCache(env);
+    if (!g_compAccessor || !g_getPeer || !g_getWindow) return 0;
 
-    /* AWTAccessor.getComponentAccessor() */
-    jclass awtAccessorClass = (*env)->FindClass(env, "sun/awt/AWTAccessor");
-    if (!awtAccessorClass || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        return 0;
+    jobject peer = (*env)->CallObjectMethod(env, g_compAccessor, g_getPeer, awtWindow);
+    if (clearException(env) || !peer) return 0;
+
+    pthread_mutex_lock(&g_xidLock);
+
+    XidCacheEntry *hit = NULL;
+    XidCacheEntry *freeSlot = NULL;
+    XidCacheEntry *oldest = NULL;
+    for (int i = 0; i < XID_CACHE_SIZE; i++) {
+        XidCacheEntry *e = &g_xidCache[i];
+        /* A cleared weak ref means the java.awt.Window was collected */
+        int stale = !e->window || (*env)->IsSameObject(env, e->window, NULL);
+        if (stale) {
+            if (!freeSlot) freeSlot = e;
+        } else if ((*env)->IsSameObject(env, e->window, awtWindow)) {
+            hit = e;
+            break;
+        } else if (!oldest || e->stamp < oldest->stamp) {
+            oldest = e;
+        }
     }
 
-    jmethodID getCompAccessor = (*env)->GetStaticMethodID(env, awtAccessorClass,
-        "getComponentAccessor", "()Lsun/awt/AWTAccessor$ComponentAccessor;");
-    if (!getCompAccessor || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, awtAccessorClass);
-        return 0;
+    if (hit && hit->peer && (*env)->IsSameObject(env, hit->peer, peer)) {
+        Window xid = hit->xid;
+        hit->stamp = ++g_xidStamp;
+        pthread_mutex_unlock(&g_xidLock);
+        (*env)->DeleteLocalRef(env, peer);
+        return xid;
     }
 
-    jobject compAccessor = (*env)->CallStaticObjectMethod(env, awtAccessorClass, getCompAccessor);
-    (*env)->DeleteLocalRef(env, awtAccessorClass);
-    if (!compAccessor || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
+    /* Miss, or the peer was disposed and re-created: ask the new peer */
+    jlong windowId = (*env)->CallLongMethod(env, peer, g_getWindow);
+    if (clearException(env) || windowId == 0) {
+        pthread_mutex_unlock(&g_xidLock);
+        (*env)->DeleteLocalRef(env, peer);
         return 0;
     }
 
-    /* componentAccessor.getPeer(window) */
-    jclass compAccessorClass = (*env)->FindClass(env, "sun/awt/AWTAccessor$ComponentAccessor");
-    if (!compAccessorClass || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, compAccessor);
+    XidCacheEntry *slot = hit ? hit : (freeSlot ? freeSlot : oldest);
+    if (slot->window) (*env)->DeleteWeakGlobalRef(env, slot->window);
+    if (slot->peer) (*env)->DeleteWeakGlobalRef(env, slot->peer);
+    slot->window = (*env)->NewWeakGlobalRef(env, awtWindow);
+    slot->peer   = (*env)->NewWeakGlobalRef(env, peer);
+    slot->xid    = (Window)windowId;
+    slot->stamp  = ++g_xidStamp;
+
+    pthread_mutex_unlock(&g_xidLock);
+    (*env)->DeleteLocalRef(env, peer);
+    return (Window)windowId;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Helper: read a 32-bit property in full (no fixed item cap).        */
+/*  Returns the item count; *out must be XFree'd when non-NULL.        */
+/* ------------------------------------------------------------------ */
+static unsigned long readCardinalProperty(Display *display, Window window,
+                                          Atom property, Atom type,
+                                          unsigned char **out) {
+    Atom actualType;
+    int actualFormat;
+    unsigned long nItems = 0, bytesAfter = 0;
+    *out = NULL;
+
+    /* First probe for the size, then fetch everything in one go */
+    if (XGetWindowProperty(display, window, property, 0, 0, False, type,
+                           &actualType, &actualFormat, &nItems, &bytesAfter,
+                           out) != Success) {
         return 0;
     }
+    if (*out) { XFree(*out); *out = NULL; }
+    if (actualType != type || actualFormat != 32 || bytesAfter == 0) return 0;
 
-    jmethodID getPeer = (*env)->GetMethodID(env, compAccessorClass,
-        "getPeer", "(Ljava/awt/Component;)Ljava/awt/peer/ComponentPeer;");
-    (*env)->DeleteLocalRef(env, compAccessorClass);
-    if (!getPeer || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, compAccessor);
+    if (XGetWindowProperty(display, window, property, 0, (long)(bytesAfter / 4),
+                           False, type, &actualType, &actualFormat, &nItems,
+                           &bytesAfter, out) != Success
+        || actualType != type || actualFormat != 32) {
+        if (*out) { XFree(*out); *out = NULL; }
         return 0;
     }
+    return nItems;
+}
 
-    jobject peer = (*env)->CallObjectMethod(env, compAccessor, getPeer, awtWindow);
-    (*env)->DeleteLocalRef(env, compAccessor);
-    if (!peer || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        return 0;
+/* ------------------------------------------------------------------ */
+/*  refreshCapabilities                                                */
+/*  Rebuilds the capability bitmap from the root window.               */
+/*  Must be called inside beginX/endX.                                 */
+/* ------------------------------------------------------------------ */
+static long long refreshCapabilities(Display *display) {
+    Window rootWindow = XDefaultRootWindow(display);
+    long long caps = 0;
+    unsigned char *data = NULL;
+
+    /* Clear the dirty flag first: a change racing with this read re-dirties it */
+    atomic_store(&g_capsDirty, 0);
+
+    if (readCardinalProperty(display, rootWindow, g_atoms[ATOM_NET_SUPPORTING_WM_CHECK],
+                             XA_WINDOW, &data) > 0) {
+        caps |= WM_CAP_PRESENT;
     }
+    if (data) XFree(data);
 
-    /* peer.getWindow() — XBaseWindow.getWindow() returns the X11 window ID */
-    jclass xBaseWindowClass = (*env)->FindClass(env, "sun/awt/X11/XBaseWindow");
-    if (!xBaseWindowClass || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, peer);
-        return 0;
+    unsigned long nItems = readCardinalProperty(display, rootWindow,
+                                                g_atoms[ATOM_NET_SUPPORTED], XA_ATOM, &data);
+    if (data) {
+        /* format-32 properties are returned as an array of long */
+        Atom *supported = (Atom *)data;
+        for (unsigned long i = 0; i < nItems; i++) {
+            for (int c = 0; c < CAPABILITY_COUNT; c++) {
+                if (supported[i] == g_atoms[CAPABILITY_ATOMS[c]]) {
+                    caps |= 1LL << (c + 1);
+                    break;
+                }
+            }
+        }
+        XFree(data);
     }
 
-    jmethodID getWindow = (*env)->GetMethodID(env, xBaseWindowClass, "getWindow", "()J");
-    (*env)->DeleteLocalRef(env, xBaseWindowClass);
-    if (!getWindow || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, peer);
-        return 0;
+    atomic_store(&g_capabilities, caps);
+    return caps;
+}
+
+/* ------------------------------------------------------------------ */
+/*  getCapabilities                                                    */
+/*  O(1) when the snapshot is clean; otherwise refreshes it over the   */
+/*  command connection. Without a watcher every call refreshes.        */
+/* ------------------------------------------------------------------ */
+static long long getCapabilities(JNIEnv *env) {
+    if (!atomic_load(&g_capsDirty) && atomic_load(&g_watcherActive)) {
+        return atomic_load(&g_capabilities);
     }
 
-    jlong windowId = (*env)->CallLongMethod(env, peer, getWindow);
-    (*env)->DeleteLocalRef(env, peer);
-    if ((*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        return 0;
+    XCommand cmd;
+    if (!beginX(env, &cmd)) return atomic_load(&g_capabilities);
+    long long caps = refreshCapabilities(cmd.display);
+    endX(env, &cmd);
+    return caps;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Frame sync table (_NET_WM_SYNC_REQUEST)                            */
+/*  Guarded by g_syncLock, which is always taken last (after g_cmdLock */
+/*  or the AWT lock) and never held while acquiring either.            */
+/*  Requests are normally acknowledged after the frame that follows    */
+/*  AWT's resize event. One that brings no size change has no such     */
+/*  event: the watcher hands requests still pending after              */
+/*  SYNC_GRACE_MS to onNativeSyncRequests, which acks them on the next */
+/*  presented frame instead.                                           */
+/* ------------------------------------------------------------------ */
+#define SYNC_TABLE_SIZE 16
+#define SYNC_GRACE_MS   20    /* over a 60 Hz frame: resizes are acked by then */
+
+typedef struct {
+    Window       xid;
+    XSyncCounter counter;
+    XSyncValue   requested;   /* serial from the last _NET_WM_SYNC_REQUEST */
+    int          pending;     /* a request is waiting for a presented frame */
+    int          handedOver;  /* the pending request was pushed to Kotlin */
+    long long    requestedAt; /* monotonic nanos of the pending request */
+} SyncEntry;
+
+static SyncEntry       g_syncTable[SYNC_TABLE_SIZE];
+static pthread_mutex_t g_syncLock = PTHREAD_MUTEX_INITIALIZER;
+static int             g_syncAvailable = -1;   /* -1 = not probed yet; guarded by g_cmdLock */
+static Bool          (*g_prevClientMessageProc)(Display *, XEvent *, xEvent *) = NULL;
+static int             g_syncHookInstalled = 0; /* guarded by the AWT lock */
+
+static SyncEntry *findSyncEntry(Window xid) {
+    for (int i = 0; i < SYNC_TABLE_SIZE; i++) {
+        if (g_syncTable[i].xid == xid) return &g_syncTable[i];
     }
+    return NULL;
+}
 
-    return (Window)windowId;
+/* Collects the windows whose sync request outlived SYNC_GRACE_MS, marking
+   them handed over. Returns their count; *waitMs is the time until the
+   next one expires, or -1 when none is pending. */
+static int takeStaleSyncRequests(jlong xids[SYNC_TABLE_SIZE], int *waitMs) {
+    long long now = monotonicNanos();
+    long long grace = SYNC_GRACE_MS * 1000000LL;
+    int count = 0;
+    *waitMs = -1;
+
+    pthread_mutex_lock(&g_syncLock);
+    for (int i = 0; i < SYNC_TABLE_SIZE; i++) {
+        SyncEntry *entry = &g_syncTable[i];
+        if (!entry->counter || !entry->pending || entry->handedOver) continue;
+        long long age = now - entry->requestedAt;
+        if (age >= grace) {
+            entry->handedOver = 1;
+            xids[count++] = (jlong)entry->xid;
+        } else {
+            int remaining = (int)((grace - age + 999999) / 1000000);
+            if (*waitMs < 0 || remaining < *waitMs) *waitMs = remaining;
+        }
+    }
+    pthread_mutex_unlock(&g_syncLock);
+    return count;
 }
 
 /* ------------------------------------------------------------------ */
-/*  Helper: acquire/release AWT lock via SunToolkit                    */
+/*  Watcher thread                                                     */
+/*  Owns a private X connection (never touches the AWT Display) and    */
+/*  polls it together with a wake-up pipe:                             */
+/*   - root PropertyNotify marks the capability snapshot dirty when    */
+/*     the WM changes what it advertises (or is replaced);             */
+/*   - observed shell windows get PropertyNotify/ConfigureNotify;      */
+/*     their state is re-read once the burst has settled and only      */
+/*     real changes are pushed to Kotlin, in one batched call.         */
+/*  Only this thread uses g_watchDisplay; other threads queue          */
+/*  observe/unobserve requests and write to the pipe.                  */
 /* ------------------------------------------------------------------ */
-static jboolean awtLock(JNIEnv *env) {
-    jclass sunToolkitClass = (*env)->FindClass(env, "sun/awt/SunToolkit");
-    if (!sunToolkitClass || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        return JNI_FALSE;
+#define OBSERVED_MAX        16
+#define STATE_SETTLE_MS     8     /* quiet time that ends a burst */
+#define STATE_MAX_DELAY_MS  50    /* publish anyway during long bursts */
+
+/* Window state bits (must match JniLinuxWindowBridge.WINDOW_STATE_*) */
+#define WINDOW_STATE_MAXIMIZED_VERT  (1 << 0)
+#define WINDOW_STATE_MAXIMIZED_HORZ  (1 << 1)
+#define WINDOW_STATE_FULLSCREEN      (1 << 2)
+#define WINDOW_STATE_HIDDEN          (1 << 3)
+#define WINDOW_STATE_TILED_TOP       (1 << 4)
+#define WINDOW_STATE_TILED_RIGHT     (1 << 5)
+#define WINDOW_STATE_TILED_BOTTOM    (1 << 6)
+#define WINDOW_STATE_TILED_LEFT      (1 << 7)
+
+/* Fields per window in the batch passed to onNativeWindowStates */
+#define STATE_RECORD_SIZE 6   /* xid, state bits, extents left/right/top/bottom */
+
+typedef struct {
+    Window xid;
+    int    dirty;
+    int    published;           /* state below has been pushed at least once */
+    long   state;
+    long   extents[4];
+} ObservedWindow;
+
+typedef struct {
+    Window xid;
+    int    observe;              /* 1 = start, 0 = stop */
+} ObserveRequest;
+
+static Display        *g_watchDisplay = NULL;
+static int             g_wakePipe[2] = { -1, -1 };
+static pthread_mutex_t g_observeLock = PTHREAD_MUTEX_INITIALIZER;
+static ObserveRequest  g_observeQueue[OBSERVED_MAX * 2];
+static int             g_observeQueued = 0;
+
+static ObservedWindow  g_observed[OBSERVED_MAX];   /* watcher thread only */
+
+static JavaVM   *g_jvm = NULL;
+static jclass    g_bridgeClass = NULL;             /* JniLinuxWindowBridge */
+static jmethodID g_onWindowStates = NULL;          /* onNativeWindowStates(long[]) */
+static jmethodID g_onSyncRequests = NULL;          /* onNativeSyncRequests(long[]) */
+
+static void wakeWatcher(void) {
+    char byte = 1;
+    if (g_wakePipe[1] >= 0) {
+        ssize_t ignored = write(g_wakePipe[1], &byte, 1);
+        (void)ignored;
     }
-    jmethodID lockMethod = (*env)->GetStaticMethodID(env, sunToolkitClass, "awtLock", "()V");
-    if (!lockMethod || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, sunToolkitClass);
-        return JNI_FALSE;
+}
+
+static ObservedWindow *findObserved(Window xid) {
+    for (int i = 0; i < OBSERVED_MAX; i++) {
+        if (g_observed[i].xid == xid) return &g_observed[i];
     }
-    (*env)->CallStaticVoidMethod(env, sunToolkitClass, lockMethod);
-    (*env)->DeleteLocalRef(env, sunToolkitClass);
-    if ((*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        return JNI_FALSE;
+    return NULL;
+}
+
+/* Returns 1 if a newly observed window awaits its initial publish. */
+static int applyObserveRequests(void) {
+    ObserveRequest requests[OBSERVED_MAX * 2];
+    pthread_mutex_lock(&g_observeLock);
+    int count = g_observeQueued;
+    memcpy(requests, g_observeQueue, (size_t)count * sizeof(ObserveRequest));
+    g_observeQueued = 0;
+    pthread_mutex_unlock(&g_observeLock);
+
+    int added = 0;
+    for (int i = 0; i < count; i++) {
+        ObservedWindow *entry = findObserved(requests[i].xid);
+        if (requests[i].observe) {
+            if (!entry) entry = findObserved(0);
+            if (!entry) continue;
+            memset(entry, 0, sizeof(*entry));
+            entry->xid = requests[i].xid;
+            entry->dirty = 1;   /* publish the initial state */
+            added = 1;
+            XSelectInput(g_watchDisplay, entry->xid, PropertyChangeMask | StructureNotifyMask);
+        } else if (entry) {
+            XSelectInput(g_watchDisplay, entry->xid, NoEventMask);
+            memset(entry, 0, sizeof(*entry));
+        }
     }
-    return JNI_TRUE;
+    if (count > 0) XFlush(g_watchDisplay);
+    return added;
 }
 
-static void awtUnlock(JNIEnv *env) {
-    jclass sunToolkitClass = (*env)->FindClass(env, "sun/awt/SunToolkit");
-    if (!sunToolkitClass || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
+/* Reads the WM-owned state of one window from the watcher connection. */
+static void readWindowState(Window xid, long *state, long extents[4]) {
+    unsigned char *data = NULL;
+    *state = 0;
+    memset(extents, 0, 4 * sizeof(long));
+
+    unsigned long n = readCardinalProperty(g_watchDisplay, xid, g_atoms[ATOM_NET_WM_STATE],
+                                           XA_ATOM, &data);
+    if (data) {
+        Atom *atoms = (Atom *)data;
+        for (unsigned long i = 0; i < n; i++) {
+            if (atoms[i] == g_atoms[ATOM_NET_WM_STATE_MAXIMIZED_VERT]) *state |= WINDOW_STATE_MAXIMIZED_VERT;
+            else if (atoms[i] == g_atoms[ATOM_NET_WM_STATE_MAXIMIZED_HORZ]) *state |= WINDOW_STATE_MAXIMIZED_HORZ;
+            else if (atoms[i] == g_atoms[ATOM_NET_WM_STATE_FULLSCREEN]) *state |= WINDOW_STATE_FULLSCREEN;
+            else if (atoms[i] == g_atoms[ATOM_NET_WM_STATE_HIDDEN]) *state |= WINDOW_STATE_HIDDEN;
+        }
+        XFree(data);
+    }
+
+    /* Mutter publishes tiling as GTK edge constraints: bit 2k = edge k tiled,
+       edges in top, right, bottom, left order */
+    n = readCardinalProperty(g_watchDisplay, xid, g_atoms[ATOM_GTK_EDGE_CONSTRAINTS],
+                             XA_CARDINAL, &data);
+    if (data) {
+        long constraints = n > 0 ? ((long *)data)[0] : 0;
+        if (constraints & (1 << 0)) *state |= WINDOW_STATE_TILED_TOP;
+        if (constraints & (1 << 2)) *state |= WINDOW_STATE_TILED_RIGHT;
+        if (constraints & (1 << 4)) *state |= WINDOW_STATE_TILED_BOTTOM;
+        if (constraints & (1 << 6)) *state |= WINDOW_STATE_TILED_LEFT;
+        XFree(data);
+    } else {
+        /* Elsewhere a half-maximized window is tiled along that axis */
+        long maximized = *state & (WINDOW_STATE_MAXIMIZED_VERT | WINDOW_STATE_MAXIMIZED_HORZ);
+        if (maximized == WINDOW_STATE_MAXIMIZED_VERT) {
+            *state |= WINDOW_STATE_TILED_TOP | WINDOW_STATE_TILED_BOTTOM;
+        } else if (maximized == WINDOW_STATE_MAXIMIZED_HORZ) {
+            *state |= WINDOW_STATE_TILED_LEFT | WINDOW_STATE_TILED_RIGHT;
+        }
+    }
+
+    n = readCardinalProperty(g_watchDisplay, xid, g_atoms[ATOM_NET_FRAME_EXTENTS],
+                             XA_CARDINAL, &data);
+    if (data) {
+        for (unsigned long i = 0; i < n && i < 4; i++) extents[i] = ((long *)data)[i];
+        XFree(data);
+    }
+}
+
+static JNIEnv *watcherEnv(void) {
+    static JNIEnv *env = NULL;
+    if (!env && g_jvm) {
+        /* Attached once, as a daemon, for the life of the thread */
+        if ((*g_jvm)->AttachCurrentThreadAsDaemon(g_jvm, (void **)&env, NULL) != JNI_OK) {
+            env = NULL;
+        }
+    }
+    return env;
+}
+
+/* Re-reads every dirty window and pushes the ones that really changed. */
+static void publishWindowStates(void) {
+    NUCLEUS_STATS_SCOPE(PROBE_PUBLISH_WINDOW_STATES);
+    jlong batch[OBSERVED_MAX * STATE_RECORD_SIZE];
+    int records = 0;
+
+    for (int i = 0; i < OBSERVED_MAX; i++) {
+        ObservedWindow *entry = &g_observed[i];
+        if (!entry->xid || !entry->dirty) continue;
+        entry->dirty = 0;
+
+        long state, extents[4];
+        readWindowState(entry->xid, &state, extents);
+        if (entry->published && state == entry->state
+            && memcmp(extents, entry->extents, sizeof(extents)) == 0) {
+            continue;
+        }
+        entry->published = 1;
+        entry->state = state;
+        memcpy(entry->extents, extents, sizeof(extents));
+
+        jlong *record = &batch[records++ * STATE_RECORD_SIZE];
+        record[0] = (jlong)entry->xid;
+        record[1] = state;
+        for (int e = 0; e < 4; e++) record[2 + e] = extents[e];
+    }
+    if (records == 0 || !g_onWindowStates) return;
+
+    JNIEnv *env = watcherEnv();
+    if (!env) {
+        NUCLEUS_STATS_FAIL();
         return;
     }
-    jmethodID unlockMethod = (*env)->GetStaticMethodID(env, sunToolkitClass, "awtUnlock", "()V");
-    if (!unlockMethod || (*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
-        (*env)->DeleteLocalRef(env, sunToolkitClass);
+    jlongArray array = (*env)->NewLongArray(env, records * STATE_RECORD_SIZE);
+    if (!array) {
+        NUCLEUS_STATS_FAIL();
+        clearException(env);
         return;
     }
-    (*env)->CallStaticVoidMethod(env, sunToolkitClass, unlockMethod);
-    (*env)->DeleteLocalRef(env, sunToolkitClass);
-    if ((*env)->ExceptionCheck(env)) {
-        (*env)->ExceptionClear(env);
+    (*env)->SetLongArrayRegion(env, array, 0, records * STATE_RECORD_SIZE, batch);
+    (*env)->CallStaticVoidMethod(env, g_bridgeClass, g_onWindowStates, array);
+    if (clearException(env)) NUCLEUS_STATS_FAIL();
+    (*env)->DeleteLocalRef(env, array);
+}
+
+/* Pushes the windows whose sync request needs a presented frame. */
+static void publishSyncRequests(const jlong *xids, int count) {
+    if (count == 0 || !g_onSyncRequests) return;
+    JNIEnv *env = watcherEnv();
+    if (!env) return;
+    jlongArray array = (*env)->NewLongArray(env, count);
+    if (!array) {
+        clearException(env);
+        return;
     }
+    (*env)->SetLongArrayRegion(env, array, 0, count, xids);
+    (*env)->CallStaticVoidMethod(env, g_bridgeClass, g_onSyncRequests, array);
+    clearException(env);
+    (*env)->DeleteLocalRef(env, array);
+}
+
+static void handleWatchEvent(XEvent *event, Window rootWindow, int *anyDirty) {
+    if (event->type == PropertyNotify) {
+        Atom atom = event->xproperty.atom;
+        if (event->xproperty.window == rootWindow) {
+            if (atom == g_atoms[ATOM_NET_SUPPORTED] || atom == g_atoms[ATOM_NET_SUPPORTING_WM_CHECK]) {
+                atomic_store(&g_capsDirty, 1);
+            }
+            return;
+        }
+        if (atom != g_atoms[ATOM_NET_WM_STATE] && atom != g_atoms[ATOM_NET_FRAME_EXTENTS]
+            && atom != g_atoms[ATOM_GTK_EDGE_CONSTRAINTS]) {
+            return;
+        }
+    } else if (event->type == DestroyNotify) {
+        ObservedWindow *entry = findObserved(event->xdestroywindow.window);
+        if (entry) memset(entry, 0, sizeof(*entry));
+        return;
+    } else if (event->type != ConfigureNotify) {
+        return;
+    }
+
+    /* PropertyNotify for a state atom, or ConfigureNotify (geometry settles
+       the same burst: publishing waits for it instead of laying out twice) */
+    ObservedWindow *entry = findObserved(event->xany.window);
+    if (entry) {
+        entry->dirty = 1;
+        *anyDirty = 1;
+    }
+}
+
+static void *watcherThread(void *arg) {
+    Window rootWindow = XDefaultRootWindow(g_watchDisplay);
+    XSelectInput(g_watchDisplay, rootWindow, PropertyChangeMask);
+    XSync(g_watchDisplay, False);
+
+    /* Anything that changed before the selection took effect is covered */
+    atomic_store(&g_capsDirty, 1);
+    atomic_store(&g_watcherActive, 1);
+
+    int anyDirty = 0;
+    long long dirtySince = 0;
+    jlong staleSync[SYNC_TABLE_SIZE];
+    /* Work done for one wakeup: from poll() returning to the next poll() */
+    NucleusStatsScope wakeup = { PROBE_WATCHER_WAKEUP, 0, 0 };
+    struct pollfd fds[2] = {
+        { .fd = ConnectionNumber(g_watchDisplay), .events = POLLIN },
+        { .fd = g_wakePipe[0], .events = POLLIN },
+    };
+
+    for (;;) {
+        int wasDirty = anyDirty;
+        if (applyObserveRequests()) anyDirty = 1;
+        while (XPending(g_watchDisplay)) {
+            XEvent event;
+            XNextEvent(g_watchDisplay, &event);
+            handleWatchEvent(&event, rootWindow, &anyDirty);
+        }
+        if (anyDirty && !wasDirty) dirtySince = monotonicNanos();
+
+        int syncWait;
+        publishSyncRequests(staleSync, takeStaleSyncRequests(staleSync, &syncWait));
+        int settleWait = anyDirty ? STATE_SETTLE_MS : -1;
+        int wait = syncWait >= 0 && (settleWait < 0 || syncWait < settleWait) ? syncWait : settleWait;
+
+        nucleus_stats_end(&wakeup);
+        int ready = poll(fds, 2, wait);
+        wakeup = nucleus_stats_begin(PROBE_WATCHER_WAKEUP);
+        if (anyDirty
+            && ((ready == 0 && wait == settleWait)
+                || monotonicNanos() - dirtySince >= STATE_MAX_DELAY_MS * 1000000LL)) {
+            /* The burst has settled (or ran too long): one batched update */
+            publishWindowStates();
+            anyDirty = 0;
+        }
+        if (ready > 0 && (fds[1].revents & POLLIN)) {
+            char drain[64];
+            ssize_t ignored = read(g_wakePipe[0], drain, sizeof(drain));
+            (void)ignored;
+        }
+    }
+    return NULL;
+}
+
+static void startWatcher(JNIEnv *env) {
+    /* The server AWT's windows live on, as for the command connection:
+       $DISPLAY may have changed since AWT connected */
+    Display *awtDisplay = getAwtDisplay(env);
+    g_watchDisplay = awtDisplay ? XOpenDisplay(XDisplayString(awtDisplay)) : NULL;
+    if (!g_watchDisplay) return; /* no watcher: getCapabilities() refreshes every call */
+
+    if (pipe(g_wakePipe) != 0) {
+        XCloseDisplay(g_watchDisplay);
+        g_watchDisplay = NULL;
+        return;
+    }
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, watcherThread, NULL) != 0) {
+        close(g_wakePipe[0]);
+        close(g_wakePipe[1]);
+        g_wakePipe[0] = g_wakePipe[1] = -1;
+        XCloseDisplay(g_watchDisplay);
+        g_watchDisplay = NULL;
+        return;
+    }
+    pthread_detach(thread);
+}
+
+static int queueObserveRequest(Window xid, int observe) {
+    if (!g_watchDisplay) return 0;
+    pthread_mutex_lock(&g_observeLock);
+    int queued = g_observeQueued < OBSERVED_MAX * 2;
+    if (queued) {
+        g_observeQueue[g_observeQueued].xid = xid;
+        g_observeQueue[g_observeQueued].observe = observe;
+        g_observeQueued++;
+    }
+    pthread_mutex_unlock(&g_observeLock);
+    if (queued) wakeWatcher();
+    return queued;
 }
 
 /* ------------------------------------------------------------------ */
-/*  nativeStartWindowMove                                              */
-/*  Sends _NET_WM_MOVERESIZE ClientMessage to initiate a native WM    */
-/*  move. This gives us snap/tile support and native drag feel.        */
+/*  JNI_OnLoad — resolve the JNI cache and intern atoms up front       */
 /* ------------------------------------------------------------------ */
-JNIEXPORT jboolean JNICALL
-Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeStartWindowMove(
-    JNIEnv *env, jclass clazz, jobject awtWindow, jint rootX, jint rootY, jint button)
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
+    (void)reserved;
+    NUCLEUS_STATS_STARTUP_SCOPE(PROBE_ON_LOAD);
+
+    JNIEnv *env = NULL;
+    if ((*vm)->GetEnv(vm, (void **)&env, JNI_VERSION_1_8) != JNI_OK) {
+        NUCLEUS_STATS_FAIL();
+        return JNI_VERSION_1_8;
+    }
+
+    /* Missing classes (headless, non-X11 toolkit) leave entries NULL;
+       every entry point then reports failure instead of crashing. */
+    initJniCache(env);
+
+    /* Resolved here, with the loader of the class that loaded us: the
+       watcher thread's FindClass would only see the system loader. */
+    g_jvm = vm;
+    g_bridgeClass = findGlobalClass(env,
+        "io/github/kdroidfilter/nucleus/window/utils/linux/JniLinuxWindowBridge");
+    if (g_bridgeClass) {
+        g_onWindowStates = findMethod(env, g_bridgeClass, "onNativeWindowStates", "([J)V", 1);
+        g_onSyncRequests = findMethod(env, g_bridgeClass, "onNativeSyncRequests", "([J)V", 1);
+    }
+
+    /* Open the command connection, intern atoms and start the watcher up
+       front; before AWT is up, the first command that finds it does */
+    XCommand cmd;
+    if (beginX(env, &cmd)) {
+        endX(env, &cmd);
+    } else {
+        NUCLEUS_STATS_FAIL();
+    }
+
+    return JNI_VERSION_1_8;
+}
+
+/* ------------------------------------------------------------------ */
+/*  sendRootClientMessage                                              */
+/*  Sends a format-32 ClientMessage about xWindow to the root window,  */
+/*  the way EWMH/ICCCM expect client requests to reach the WM.         */
+/*  Must be called inside beginX/endX.                                 */
+/* ------------------------------------------------------------------ */
+static void sendRootClientMessage(Display *display, Window xWindow, Atom type,
+                                  long l0, long l1, long l2, long l3, long l4)
 {
-    Display *display = getAwtDisplay(env);
-    if (!display) return JNI_FALSE;
+    XEvent event;
+    memset(&event, 0, sizeof(event));
+    event.xclient.type = ClientMessage;
+    event.xclient.window = xWindow;
+    event.xclient.message_type = type;
+    event.xclient.format = 32;
+    event.xclient.data.l[0] = l0;
+    event.xclient.data.l[1] = l1;
+    event.xclient.data.l[2] = l2;
+    event.xclient.data.l[3] = l3;
+    event.xclient.data.l[4] = l4;
 
+    XSendEvent(display, XDefaultRootWindow(display), False,
+               SubstructureRedirectMask | SubstructureNotifyMask,
+               &event);
+    XFlush(display);
+}
+
+/* ------------------------------------------------------------------ */
+/*  beginWindowCommand                                                 */
+/*  Shared prologue for window commands: resolves the shell XID and    */
+/*  acquires a connection (see beginX). Returns 0 (nothing held) on    */
+/*  failure; otherwise the caller must endX().                         */
+/* ------------------------------------------------------------------ */
+static Window beginWindowCommand(JNIEnv *env, jobject awtWindow, XCommand *cmd) {
     Window xWindow = getAwtX11Window(env, awtWindow);
-    if (!xWindow) return JNI_FALSE;
+    if (!xWindow) return 0;
+    if (!beginX(env, cmd)) return 0;
+    return xWindow;
+}
 
-    /* Acquire AWT lock — required before any direct Xlib call on AWT's Display */
-    if (!awtLock(env)) return JNI_FALSE;
+/* ------------------------------------------------------------------ */
+/*  releaseAwtGrabs                                                    */
+/*  AWT owns the implicit pointer grab of the press, so it has to be   */
+/*  released on AWT's connection before the WM can take over. The      */
+/*  ClientMessage usually goes out on the command connection, and the  */
+/*  server does not order requests across clients: XSync waits until   */
+/*  the ungrab has been processed, so the WM's own grab cannot fail.   */
+/* ------------------------------------------------------------------ */
+static void releaseAwtGrabs(JNIEnv *env) {
+    Display *display = getAwtDisplay(env);
+    if (!display || !awtLock(env)) return;
+    XUngrabPointer(display, CurrentTime);
+    XUngrabKeyboard(display, CurrentTime);
+    XSync(display, False);
+    awtUnlock(env);
+}
+
+/* ------------------------------------------------------------------ */
+/*  sendMoveResize                                                     */
+/*  Sends a _NET_WM_MOVERESIZE ClientMessage for the given direction.  */
+/*  The WM then drives the move/resize itself, which gives us snap/    */
+/*  tile support and compositor-paced feedback.                        */
+/* ------------------------------------------------------------------ */
+static jboolean sendMoveResize(JNIEnv *env, jobject awtWindow,
+                               jint rootX, jint rootY, jint button, long direction)
+{
+    /* Release AWT's pointer and keyboard grabs so the WM can take over */
+    releaseAwtGrabs(env);
+
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) return JNI_FALSE;
+    Display *display = cmd.display;
 
     /* Determine the root window */
     Window rootWindow = XDefaultRootWindow(display);
@@ -214,34 +1146,71 @@ Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nati
         physRootY = rootY;
     }
 
-    /* Release AWT's pointer and keyboard grabs so the WM can take over */
-    XUngrabPointer(display, CurrentTime);
-    XUngrabKeyboard(display, CurrentTime);
+    sendRootClientMessage(display, xWindow, g_atoms[ATOM_NET_WM_MOVERESIZE],
+                          physRootX,   /* x_root (physical) */
+                          physRootY,   /* y_root (physical) */
+                          direction,   /* direction */
+                          button,      /* X11 button (1=left) */
+                          1);          /* source indication: application */
 
-    /* Intern the atom */
-    Atom wmMoveResize = XInternAtom(display, "_NET_WM_MOVERESIZE", False);
+    endX(env, &cmd);
 
-    /* Build and send the ClientMessage */
-    XEvent event;
-    memset(&event, 0, sizeof(event));
-    event.xclient.type = ClientMessage;
-    event.xclient.window = xWindow;
-    event.xclient.message_type = wmMoveResize;
-    event.xclient.format = 32;
-    event.xclient.data.l[0] = physRootX;                    /* x_root (physical) */
-    event.xclient.data.l[1] = physRootY;                    /* y_root (physical) */
-    event.xclient.data.l[2] = _NET_WM_MOVERESIZE_MOVE;     /* direction */
-    event.xclient.data.l[3] = button;                       /* X11 button (1=left) */
-    event.xclient.data.l[4] = 1;                            /* source indication: application */
+    return JNI_TRUE;
+}
 
-    XSendEvent(display, rootWindow, False,
-               SubstructureRedirectMask | SubstructureNotifyMask,
-               &event);
+/* ------------------------------------------------------------------ */
+/*  nativeStartWindowMove                                              */
+/*  Initiates a native WM move (_NET_WM_MOVERESIZE_MOVE).              */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeStartWindowMove(
+    JNIEnv *env, jclass clazz, jobject awtWindow, jint rootX, jint rootY, jint button)
+{
+    NUCLEUS_STATS_SCOPE(PROBE_START_WINDOW_MOVE);
+    return NUCLEUS_STATS_RESULT(
+        sendMoveResize(env, awtWindow, rootX, rootY, button, _NET_WM_MOVERESIZE_MOVE));
+}
 
-    XFlush(display);
+/* ------------------------------------------------------------------ */
+/*  nativeStartWindowResize                                            */
+/*  Initiates a native WM resize from one of the eight window edges.   */
+/*  edge is a _NET_WM_MOVERESIZE_SIZE_* direction (0 = top-left,       */
+/*  clockwise to 7 = left). Returns false, leaving AWT's grabs alone,  */
+/*  when the WM does not advertise _NET_WM_MOVERESIZE.                 */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeStartWindowResize(
+    JNIEnv *env, jclass clazz, jobject awtWindow, jint rootX, jint rootY, jint button, jint edge)
+{
+    NUCLEUS_STATS_CHECKED_SCOPE(PROBE_START_WINDOW_RESIZE);
+    if (edge < _NET_WM_MOVERESIZE_SIZE_TOPLEFT || edge > _NET_WM_MOVERESIZE_SIZE_LEFT) {
+        return JNI_FALSE;
+    }
+    if (!(getCapabilities(env) & WM_CAP_MOVERESIZE)) return JNI_FALSE;
+    return NUCLEUS_STATS_RESULT(sendMoveResize(env, awtWindow, rootX, rootY, button, edge));
+}
 
-    awtUnlock(env);
+/* ------------------------------------------------------------------ */
+/*  nativeMoveWindow                                                   */
+/*  Moves the shell window to (x, y) in physical root coordinates.     */
+/*  Used by the Compose drag: one asynchronous ConfigureWindow request */
+/*  on the command connection, no AWT lock and no round trip.          */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeMoveWindow(
+    JNIEnv *env, jclass clazz, jobject awtWindow, jint x, jint y)
+{
+    NUCLEUS_STATS_CHECKED_SCOPE(PROBE_MOVE_WINDOW);
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) return JNI_FALSE;
+    Display *display = cmd.display;
 
+    XMoveWindow(display, xWindow, x, y);
+    XFlush(display);
+
+    endX(env, &cmd);
+    NUCLEUS_STATS_OK();
     return JNI_TRUE;
 }
 
@@ -253,41 +1222,414 @@ JNIEXPORT jboolean JNICALL
 Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeIsWmMoveResizeSupported(
     JNIEnv *env, jclass clazz, jobject awtWindow)
 {
+    NUCLEUS_STATS_SCOPE(PROBE_IS_WM_MOVE_RESIZE_SUPPORTED);
+    return (getCapabilities(env) & WM_CAP_MOVERESIZE) ? JNI_TRUE : JNI_FALSE;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeGetWmCapabilities                                            */
+/*  Returns the WM capability bitmap (JniLinuxWindowBridge.WM_CAP_*).  */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jlong JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeGetWmCapabilities(
+    JNIEnv *env, jclass clazz)
+{
+    NUCLEUS_STATS_SCOPE(PROBE_GET_WM_CAPABILITIES);
+    return (jlong)getCapabilities(env);
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeObserveWindowState                                           */
+/*  Starts pushing the window's WM state (WINDOW_STATE_* bits and      */
+/*  _NET_FRAME_EXTENTS) to JniLinuxWindowBridge.onNativeWindowStates,  */
+/*  once now and then once per settled change.                         */
+/*  Returns the shell XID to pass to nativeStopObservingWindowState,   */
+/*  or 0 when no watcher is running.                                   */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jlong JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeObserveWindowState(
+    JNIEnv *env, jclass clazz, jobject awtWindow)
+{
+    NUCLEUS_STATS_SCOPE(PROBE_OBSERVE_WINDOW_STATE);
+    Window xWindow = g_onWindowStates ? getAwtX11Window(env, awtWindow) : 0;
+    if (!xWindow || !queueObserveRequest(xWindow, 1)) {
+        NUCLEUS_STATS_FAIL();
+        return 0;
+    }
+    return (jlong)xWindow;
+}
+
+JNIEXPORT void JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeStopObservingWindowState(
+    JNIEnv *env, jclass clazz, jlong xid)
+{
+    NUCLEUS_STATS_SCOPE(PROBE_STOP_OBSERVING_WINDOW_STATE);
+    if (xid) queueObserveRequest((Window)xid, 0);
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeSetWindowState                                               */
+/*  Sends one _NET_WM_STATE request changing up to two properties at   */
+/*  once (e.g. MAXIMIZED_VERT + MAXIMIZED_HORZ), so the WM applies     */
+/*  them in a single transaction.                                      */
+/*  action: 0 = remove, 1 = add, 2 = toggle                            */
+/*  first/second: STATE_* codes (second may be 0 = none)               */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeSetWindowState(
+    JNIEnv *env, jclass clazz, jobject awtWindow, jint action, jint first, jint second)
+{
+    NUCLEUS_STATS_CHECKED_SCOPE(PROBE_SET_WINDOW_STATE);
+    if (action < _NET_WM_STATE_REMOVE || action > _NET_WM_STATE_TOGGLE) return JNI_FALSE;
+    if (first <= 0 || first >= STATE_COUNT) return JNI_FALSE;
+    if (second < 0 || second >= STATE_COUNT) return JNI_FALSE;
+
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) return JNI_FALSE;
+    Display *display = cmd.display;
+
+    sendRootClientMessage(display, xWindow, g_atoms[ATOM_NET_WM_STATE],
+                          action,
+                          (long)g_atoms[STATE_ATOMS[first]],
+                          second > 0 ? (long)g_atoms[STATE_ATOMS[second]] : 0L,
+                          1,   /* source indication: application */
+                          0);
+
+    endX(env, &cmd);
+    NUCLEUS_STATS_OK();
+    return JNI_TRUE;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeMinimizeWindow                                               */
+/*  Iconifies the window with an ICCCM WM_CHANGE_STATE request         */
+/*  (_NET_WM_STATE_HIDDEN is WM-owned and cannot be set by clients).   */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeMinimizeWindow(
+    JNIEnv *env, jclass clazz, jobject awtWindow)
+{
+    NUCLEUS_STATS_CHECKED_SCOPE(PROBE_MINIMIZE_WINDOW);
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) return JNI_FALSE;
+    Display *display = cmd.display;
+
+    sendRootClientMessage(display, xWindow, g_atoms[ATOM_WM_CHANGE_STATE],
+                          IconicState, 0, 0, 0, 0);
+
+    endX(env, &cmd);
+    NUCLEUS_STATS_OK();
+    return JNI_TRUE;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Frame sync (_NET_WM_SYNC_REQUEST)                                  */
+/*  Sync requests arrive on AWT's connection, so the hook lives there; */
+/*  counters are created and updated over the command connection.      */
+/* ------------------------------------------------------------------ */
+/* Wire-to-event hook for ClientMessage: lets AWT see the event unchanged,
+   and records the serial of any _NET_WM_SYNC_REQUEST for our windows. */
+static Bool syncClientMessageHook(Display *display, XEvent *re, xEvent *event) {
+    Bool result = g_prevClientMessageProc
+        ? g_prevClientMessageProc(display, re, event)
+        : False;
+
+    if (result && re->type == ClientMessage
+        && re->xclient.message_type == g_atoms[ATOM_WM_PROTOCOLS]
+        && (Atom)re->xclient.data.l[0] == g_atoms[ATOM_NET_WM_SYNC_REQUEST]) {
+        pthread_mutex_lock(&g_syncLock);
+        SyncEntry *entry = findSyncEntry(re->xclient.window);
+        if (entry) {
+            XSyncIntsToValue(&entry->requested,
+                             (unsigned int)re->xclient.data.l[2],
+                             (int)re->xclient.data.l[3]);
+            entry->pending = 1;
+            entry->handedOver = 0;
+            entry->requestedAt = monotonicNanos();
+        }
+        pthread_mutex_unlock(&g_syncLock);
+        /* Let the watcher time the request out if no resize acks it */
+        if (entry) wakeWatcher();
+    }
+    return result;
+}
+
+/* Installs the ClientMessage hook on AWT's connection (once). */
+static void installSyncHook(JNIEnv *env) {
     Display *display = getAwtDisplay(env);
-    if (!display) return JNI_FALSE;
+    if (!display || !awtLock(env)) return;
+    if (!g_syncHookInstalled) {
+        g_prevClientMessageProc = XESetWireToEvent(display, ClientMessage,
+                                                   syncClientMessageHook);
+        g_syncHookInstalled = 1;
+    }
+    awtUnlock(env);
+}
 
-    if (!awtLock(env)) return JNI_FALSE;
+/* Adds or removes _NET_WM_SYNC_REQUEST in WM_PROTOCOLS, keeping AWT's entries. */
+static void updateSyncProtocol(Display *display, Window xWindow, int enable) {
+    Atom *protocols = NULL;
+    int count = 0;
+    Atom syncRequest = g_atoms[ATOM_NET_WM_SYNC_REQUEST];
 
-    Window rootWindow = XDefaultRootWindow(display);
+    if (!XGetWMProtocols(display, xWindow, &protocols, &count)) {
+        protocols = NULL;
+        count = 0;
+    }
 
-    Atom netSupported = XInternAtom(display, "_NET_SUPPORTED", False);
-    Atom wmMoveResize = XInternAtom(display, "_NET_WM_MOVERESIZE", False);
+    Atom updated[32];
+    int n = 0;
+    int present = 0;
+    for (int i = 0; i < count && n < 31; i++) {
+        if (protocols[i] == syncRequest) {
+            present = 1;
+            if (!enable) continue;
+        }
+        updated[n++] = protocols[i];
+    }
+    if (enable && !present) updated[n++] = syncRequest;
+    if (protocols) XFree(protocols);
 
-    Atom actualType;
-    int actualFormat;
-    unsigned long nItems, bytesAfter;
-    unsigned char *data = NULL;
+    if (enable != present) XSetWMProtocols(display, xWindow, updated, n);
+}
 
-    jboolean supported = JNI_FALSE;
+/* ------------------------------------------------------------------ */
+/*  nativeEnableFrameSync                                              */
+/*  Creates the XSync counter, advertises _NET_WM_SYNC_REQUEST and     */
+/*  publishes _NET_WM_SYNC_REQUEST_COUNTER on the shell window.        */
+/*  Returns the XID that onNativeSyncRequests reports, 0 on failure.   */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jlong JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeEnableFrameSync(
+    JNIEnv *env, jclass clazz, jobject awtWindow)
+{
+    NUCLEUS_STATS_CHECKED_SCOPE(PROBE_ENABLE_FRAME_SYNC);
+    /* Before taking any other lock: the hook needs the AWT lock */
+    installSyncHook(env);
 
-    int result = XGetWindowProperty(display, rootWindow, netSupported,
-                                    0, 1024, False, XA_ATOM,
-                                    &actualType, &actualFormat,
-                                    &nItems, &bytesAfter, &data);
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) return 0;
+    Display *display = cmd.display;
 
-    if (result == Success && data && actualType == XA_ATOM && actualFormat == 32) {
-        Atom *atoms = (Atom *)data;
-        for (unsigned long i = 0; i < nItems; i++) {
-            if (atoms[i] == wmMoveResize) {
-                supported = JNI_TRUE;
-                break;
-            }
+    if (g_syncAvailable < 0) {
+        int eventBase, errorBase, major, minor;
+        g_syncAvailable = XSyncQueryExtension(display, &eventBase, &errorBase)
+                          && XSyncInitialize(display, &major, &minor);
+    }
+
+    jlong handle = 0;
+    if (g_syncAvailable && g_syncHookInstalled) {
+        pthread_mutex_lock(&g_syncLock);
+        SyncEntry *entry = findSyncEntry(xWindow);
+        if (!entry) entry = findSyncEntry(0);
+        if (entry && !entry->counter) {
+            XSyncValue zero;
+            XSyncIntToValue(&zero, 0);
+            entry->counter = XSyncCreateCounter(display, zero);
+            entry->requested = zero;
+            entry->pending = 0;
+            entry->handedOver = 0;
+            entry->xid = xWindow;
+
+            long counterId = (long)entry->counter;
+            XChangeProperty(display, xWindow, g_atoms[ATOM_NET_WM_SYNC_REQUEST_COUNTER],
+                            XA_CARDINAL, 32, PropModeReplace,
+                            (unsigned char *)&counterId, 1);
+            updateSyncProtocol(display, xWindow, 1);
+            XFlush(display);
         }
+        if (entry && entry->counter) handle = (jlong)xWindow;
+        pthread_mutex_unlock(&g_syncLock);
     }
 
-    if (data) XFree(data);
+    endX(env, &cmd);
+    return NUCLEUS_STATS_RESULT(handle);
+}
 
-    awtUnlock(env);
+/* ------------------------------------------------------------------ */
+/*  nativeFrameSyncPresented                                           */
+/*  Called after Compose presented a frame: publishes the requested    */
+/*  serial so the WM may send the next configure.                      */
+/*  Returns true if a pending request was acknowledged.                */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeFrameSyncPresented(
+    JNIEnv *env, jclass clazz, jobject awtWindow)
+{
+    NUCLEUS_STATS_SCOPE(PROBE_FRAME_SYNC_PRESENTED);
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) {
+        NUCLEUS_STATS_FAIL();
+        return JNI_FALSE;
+    }
+    Display *display = cmd.display;
+
+    jboolean acked = JNI_FALSE;
+    pthread_mutex_lock(&g_syncLock);
+    SyncEntry *entry = findSyncEntry(xWindow);
+    if (entry && entry->counter && entry->pending) {
+        XSyncSetCounter(display, entry->counter, entry->requested);
+        XFlush(display);
+        entry->pending = 0;
+        entry->handedOver = 0;
+        acked = JNI_TRUE;
+    }
+    pthread_mutex_unlock(&g_syncLock);
+
+    endX(env, &cmd);
+    return acked;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeDisableFrameSync                                             */
+/*  Withdraws _NET_WM_SYNC_REQUEST and destroys the counter.           */
+/* ------------------------------------------------------------------ */
+JNIEXPORT void JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeDisableFrameSync(
+    JNIEnv *env, jclass clazz, jobject awtWindow)
+{
+    NUCLEUS_STATS_SCOPE(PROBE_DISABLE_FRAME_SYNC);
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) {
+        NUCLEUS_STATS_FAIL();
+        return;
+    }
+    Display *display = cmd.display;
+
+    pthread_mutex_lock(&g_syncLock);
+    SyncEntry *entry = findSyncEntry(xWindow);
+    if (entry && entry->counter) {
+        updateSyncProtocol(display, xWindow, 0);
+        XDeleteProperty(display, xWindow, g_atoms[ATOM_NET_WM_SYNC_REQUEST_COUNTER]);
+        XSyncDestroyCounter(display, entry->counter);
+        XFlush(display);
+        memset(entry, 0, sizeof(*entry));
+    }
+    pthread_mutex_unlock(&g_syncLock);
+
+    endX(env, &cmd);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Compositor hints                                                   */
+/* ------------------------------------------------------------------ */
+
+/* Replaces (or deletes when count == 0) a CARDINAL[] property.
+   Must be called inside beginX/endX. */
+static void setCardinalProperty(Display *display, Window xWindow, Atom property,
+                                const long *values, int count)
+{
+    if (count > 0) {
+        XChangeProperty(display, xWindow, property, XA_CARDINAL, 32,
+                        PropModeReplace, (const unsigned char *)values, count);
+    } else {
+        XDeleteProperty(display, xWindow, property);
+    }
+    XFlush(display);
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeSetOpaqueRegion                                              */
+/*  rects: packed x, y, width, height quadruples in physical pixels,   */
+/*  relative to the window. An empty array removes the hint.           */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeSetOpaqueRegion(
+    JNIEnv *env, jclass clazz, jobject awtWindow, jintArray rects)
+{
+    NUCLEUS_STATS_CHECKED_SCOPE(PROBE_SET_OPAQUE_REGION);
+    jsize length = rects ? (*env)->GetArrayLength(env, rects) : 0;
+    if (length % 4 != 0 || length > 64) return JNI_FALSE;
+
+    jint packed[64];
+    long values[64];
+    if (length > 0) (*env)->GetIntArrayRegion(env, rects, 0, length, packed);
+    for (jsize i = 0; i < length; i++) values[i] = packed[i];
+
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) return JNI_FALSE;
+    Display *display = cmd.display;
+
+    setCardinalProperty(display, xWindow, g_atoms[ATOM_NET_WM_OPAQUE_REGION], values, (int)length);
 
-    return supported;
+    endX(env, &cmd);
+    NUCLEUS_STATS_OK();
+    return JNI_TRUE;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeSetBypassCompositor                                          */
+/*  mode: 0 = no preference (removes the hint), 1 = bypass (unredirect */
+/*  e.g. when fullscreen), 2 = never bypass.                           */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeSetBypassCompositor(
+    JNIEnv *env, jclass clazz, jobject awtWindow, jint mode)
+{
+    NUCLEUS_STATS_CHECKED_SCOPE(PROBE_SET_BYPASS_COMPOSITOR);
+    if (mode < 0 || mode > 2) return JNI_FALSE;
+
+    XCommand cmd;
+    Window xWindow = beginWindowCommand(env, awtWindow, &cmd);
+    if (!xWindow) return JNI_FALSE;
+    Display *display = cmd.display;
+
+    long value = mode;
+    setCardinalProperty(display, xWindow, g_atoms[ATOM_NET_WM_BYPASS_COMPOSITOR], &value, mode ? 1 : 0);
+
+    endX(env, &cmd);
+    NUCLEUS_STATS_OK();
+    return JNI_TRUE;
+}
+
+/* ------------------------------------------------------------------ */
+/*  AWT lock statistics                                                */
+/* ------------------------------------------------------------------ */
+
+/* Returns { holds, total hold nanos, max hold nanos } since the last reset. */
+JNIEXPORT jlongArray JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeGetAwtLockStats(
+    JNIEnv *env, jclass clazz)
+{
+    jlong stats[3] = {
+        atomic_load(&g_awtLockHolds),
+        atomic_load(&g_awtLockHoldNanos),
+        atomic_load(&g_awtLockMaxNanos),
+    };
+    jlongArray result = (*env)->NewLongArray(env, 3);
+    if (result) (*env)->SetLongArrayRegion(env, result, 0, 3, stats);
+    return result;
+}
+
+JNIEXPORT void JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeResetAwtLockStats(
+    JNIEnv *env, jclass clazz)
+{
+    atomic_store(&g_awtLockHolds, 0);
+    atomic_store(&g_awtLockHoldNanos, 0);
+    atomic_store(&g_awtLockMaxNanos, 0);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Call statistics                                                    */
+/*  NUCLEUS_STATS_FIELDS longs per PROBE_*, see nucleus_native_stats.h */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jlongArray JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeGetStats(
+    JNIEnv *env, jclass clazz)
+{
+    return nucleus_stats_to_java(env);
+}
+
+JNIEXPORT void JNICALL
+Java_io_github_kdroidfilter_nucleus_window_utils_linux_JniLinuxWindowBridge_nativeSetStatsEnabled(
+    JNIEnv *env, jclass clazz, jboolean enabled)
+{
+    nucleus_stats_set_enabled(enabled);
 }
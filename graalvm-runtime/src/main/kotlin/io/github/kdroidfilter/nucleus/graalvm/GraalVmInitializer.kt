@@ -1,6 +1,7 @@
 package io.github.kdroidfilter.nucleus.graalvm
 
 import io.github.kdroidfilter.nucleus.hidpi.applyLinuxHiDpiScale
+import io.github.kdroidfilter.nucleus.hidpi.startLinuxScaleDetection
 import java.io.File
 import java.nio.charset.Charset
 
@@ -24,15 +25,23 @@ object GraalVmInitializer {
             val sep = File.pathSeparator
             System.setProperty("java.library.path", "$execDir$sep$execDir${File.separator}bin")
             resetLibraryPathCache()
+        }
 
+        // Linux HiDPI — detection (GSettings, X connection) starts on a native
+        // thread as soon as java.library.path allows, and is joined with a
+        // deadline right after: only the charset init runs in between, so
+        // this saves little. Apps that want the probes to overlap their own
+        // startup work call startLinuxScaleDetection() before initialize()
+        // on the JVM; a native image needs the library path set above first.
+        startLinuxScaleDetection()
+        if (isNativeImage) {
             // Early charset init
             Charset.defaultCharset()
         }
-
-        // Linux HiDPI — must come AFTER java.library.path is configured above,
-        // because applyLinuxHiDpiScale() triggers HiDpiLinuxBridge JNI loading.
         // Sets GDK_SCALE via setenv (triggers JDK's native scaling for both
         // rendering AND mouse events) + sun.java2d.uiScale as fallback.
+        // Before fontmanager: loading it brings up libawt, which rules out
+        // the X probe.
         applyLinuxHiDpiScale()
 
         if (isNativeImage) {
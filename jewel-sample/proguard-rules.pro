@@ -256,6 +256,14 @@
 -keep class io.github.kdroidfilter.nucleus.darkmodedetector.linux.NativeLinuxBridge {
     native <methods>;
     static void onThemeChanged(boolean);
+    static void onSettingsChanged(double[]);
+}
+
+# Nucleus linux-hidpi JNI
+# HiDpiLinuxBridge.onScaleChanged is looked up by name from native code (GetStaticMethodID)
+-keep class io.github.kdroidfilter.nucleus.hidpi.HiDpiLinuxBridge {
+    native <methods>;
+    static void onScaleChanged(double,double);
 }
 
 # Nucleus darkmode-detector JNI (Windows)
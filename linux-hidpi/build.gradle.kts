@@ -15,6 +15,7 @@ val publishVersion =
 
 dependencies {
     implementation(kotlin("stdlib"))
+    implementation(project(":core-runtime"))
 }
 
 java {
@@ -42,6 +43,7 @@ val buildNativeLinux by tasks.registering(Exec::class) {
             !checkArm.exists()
     }
     inputs.dir(nativeDir)
+    inputs.dir(rootProject.file("core-runtime/src/main/native/include"))
     outputs.dir(outputDir)
     workingDir(nativeDir)
     commandLine("bash", "build.sh")
@@ -1,11 +1,30 @@
 package io.github.kdroidfilter.nucleus.hidpi
 
-import java.nio.file.Files
+import io.github.kdroidfilter.nucleus.core.runtime.NativeLibraryLoader
+import io.github.kdroidfilter.nucleus.core.runtime.NucleusNativeStats
+import java.util.concurrent.ConcurrentHashMap
 import java.util.logging.Level
 import java.util.logging.Logger
 
 internal object HiDpiLinuxBridge {
     private val logger = Logger.getLogger(HiDpiLinuxBridge::class.java.simpleName)
+    private val scaleListeners: MutableSet<LinuxScaleChangeListener> = ConcurrentHashMap.newKeySet()
+
+    // Native call statistics probes, in nativeGetStats order (PROBE_* in nucleus_hidpi_linux.c)
+    private val STATS_PROBES =
+        listOf(
+            "JNI_OnLoad",
+            "nativeGetScaleFactor",
+            "nativeAwaitScaleFactor",
+            "nativeStartDetection",
+            "nativeApplyScaleToEnv",
+            "nativeGetMonitorScales",
+            "nativeStartObserving",
+            "nativeStopObserving",
+            "desktop scale probe",
+            "X scale probe",
+            "monitor wakeup",
+        )
 
     @Volatile
     private var loaded = false
@@ -17,34 +36,18 @@ internal object HiDpiLinuxBridge {
     private fun loadNativeLibrary() {
         if (loaded) return
 
-        // Try system library path first (packaged app)
-        try {
-            System.loadLibrary("nucleus_linux_hidpi_jni")
-            loaded = true
-            return
-        } catch (_: UnsatisfiedLinkError) {
-            // Fall through to JAR extraction
-        }
-
-        // Fallback: extract from JAR resources
-        @Suppress("TooGenericExceptionCaught")
+        // Library path first (packaged app), else the copy bundled in the JAR,
+        // extracted once into the per-user native library cache
         try {
-            val arch =
-                System.getProperty("os.arch").let {
-                    if (it == "aarch64" || it == "arm64") "aarch64" else "x64"
-                }
-            val resourcePath = "/nucleus/native/linux-$arch/libnucleus_linux_hidpi_jni.so"
-            val stream =
-                HiDpiLinuxBridge::class.java.getResourceAsStream(resourcePath)
-                    ?: throw UnsatisfiedLinkError("Native library not found in JAR at $resourcePath")
-            val tempDir = Files.createTempDirectory("nucleus-hidpi-native")
-            val tempLib = tempDir.resolve("libnucleus_linux_hidpi_jni.so")
-            stream.use { Files.copy(it, tempLib) }
-            tempLib.toFile().deleteOnExit()
-            tempDir.toFile().deleteOnExit()
-            System.load(tempLib.toAbsolutePath().toString())
+            NativeLibraryLoader.load(HiDpiLinuxBridge::class.java, "nucleus_linux_hidpi_jni") { System.load(it) }
             loaded = true
-        } catch (e: Exception) {
+            NucleusNativeStats.register(
+                "nucleus_linux_hidpi_jni",
+                STATS_PROBES,
+                ::nativeGetStats,
+                ::nativeSetStatsEnabled,
+            )
+        } catch (e: UnsatisfiedLinkError) {
             logger.log(Level.WARNING, "Failed to load nucleus_linux_hidpi_jni native library", e)
         }
     }
@@ -52,16 +55,104 @@ internal object HiDpiLinuxBridge {
     val isLoaded: Boolean get() = loaded
 
     // Returns the native HiDPI scale factor detected from the Linux desktop
-    // environment (GSettings, GDK_SCALE, Xft.dpi, …).
-    // Returns 0.0 if the scale cannot be determined.
+    // environment (GSettings, GDK_SCALE, Xft.dpi, …), blocking until the
+    // background probes complete.
+    // Returns 0.0 if the scale cannot be determined, SCALE_SKIPPED if only the
+    // X probe could have answered and it was skipped (see nativeStartDetection).
     @JvmStatic
     external fun nativeGetScaleFactor(): Double
 
-    // Sets GDK_SCALE in the process environment so the JDK's native
-    // X11GraphicsDevice.getNativeScaleFactor() picks up the scale through
-    // the standard detection path. This ensures both rendering AND mouse
-    // event coordinates are properly scaled (XWindow.scaleDown).
-    // Does not overwrite GDK_SCALE if it is already set by the desktop session.
+    // Same as nativeGetScaleFactor, but waits at most timeoutMillis for the
+    // background probes started by nativeStartDetection. Returns SCALE_TIMEOUT on
+    // timeout; a probe in progress keeps running and a later call can still
+    // succeed, but the X probe no longer starts (AWT may be using Xlib).
+    @JvmStatic
+    external fun nativeAwaitScaleFactor(timeoutMillis: Long): Double
+
+    const val SCALE_TIMEOUT = -1.0
+    const val SCALE_SKIPPED = -2.0
+
+    // Starts the background probes and returns at once. Call it on the startup
+    // path, before AWT: the X probe only runs while AWT's X toolkit is not
+    // loaded and no other entry point has been used.
+    @JvmStatic
+    external fun nativeStartDetection()
+
+    // Exports the scale through the environment variable the running JDK's
+    // native X11GraphicsDevice.getNativeScaleFactor() reads, so both rendering
+    // AND mouse event coordinates are scaled (XWindow.scaleDown). Integral
+    // scales go to GDK_SCALE; fractional ones to J2D_UISCALE on runtimes that
+    // read it as a double (JBR), otherwise they are rounded to the nearest
+    // integer for GDK_SCALE. Never overwrites a variable set by the session.
+    // Returns the APPLY_* path taken.
+    @JvmStatic
+    external fun nativeApplyScaleToEnv(scale: Double): Int
+
+    const val APPLY_NONE = 0
+    const val APPLY_GDK_SCALE = 1
+    const val APPLY_J2D_UISCALE = 2
+    const val APPLY_GDK_SCALE_ROUNDED = 3
+
+    // Returns MONITOR_RECORD_SIZE doubles per connected output, read through
+    // XRandR: { x, y, width, height, mmWidth, mmHeight, scale, primary }.
+    // Geometry is in X screen pixels; scale is 0.0 when the physical size is
+    // unknown. Returns null if libXrandr or the X display is unavailable.
+    @JvmStatic
+    external fun nativeGetMonitorScales(): DoubleArray?
+
+    const val MONITOR_RECORD_SIZE = 8
+
+    // Starts the native settings monitor: a thread on its own X connection that
+    // watches the XSETTINGS owner (_XSETTINGS_S<screen>) and RESOURCE_MANAGER
+    // through PropertyNotify and calls onScaleChanged when the scale or DPI
+    // changes. Returns false if it could not be started (no X display, or the
+    // thread could not attach). Idempotent; replaces a monitor whose X server
+    // went away.
+    @JvmStatic
+    external fun nativeStartObserving(): Boolean
+
+    // Stops the settings monitor. Safe to call from a listener callback.
+    @JvmStatic
+    external fun nativeStopObserving()
+
+    // Call statistics, read through NucleusNativeStats: { calls, errors, total nanos,
+    // max nanos } per STATS_PROBES entry.
+    @JvmStatic
+    private external fun nativeGetStats(): LongArray
+
     @JvmStatic
-    external fun nativeApplyScaleToEnv(scale: Int)
+    private external fun nativeSetStatsEnabled(enabled: Boolean)
+
+    // Called from the settings monitor thread.
+    @JvmStatic
+    fun onScaleChanged(
+        scale: Double,
+        dpi: Double,
+    ) {
+        // Not every settings daemon writes a file the cache key watches
+        LinuxScaleCache.invalidate()
+        scaleListeners.forEach { it.onScaleChanged(scale, dpi) }
+    }
+
+    // The monitor runs only while at least one listener is registered.
+    @Synchronized
+    fun addScaleChangeListener(listener: LinuxScaleChangeListener): Boolean {
+        if (!loaded) return false
+        // Cheap when the monitor runs; restarts it if its connection was lost
+        if (!nativeStartObserving()) return false
+        scaleListeners.add(listener)
+        return true
+    }
+
+    fun removeScaleChangeListener(listener: LinuxScaleChangeListener) {
+        val stop = synchronized(this) { scaleListeners.remove(listener) && scaleListeners.isEmpty() }
+        if (!stop) return
+        // Outside the lock: stopping joins the monitor thread, whose listeners
+        // may be blocked on add/remove
+        nativeStopObserving()
+        // A listener added while the monitor was stopping needs it back
+        synchronized(this) {
+            if (scaleListeners.isNotEmpty()) nativeStartObserving()
+        }
+    }
 }
@@ -9,7 +9,16 @@ package io.github.kdroidfilter.nucleus.hidpi
  *   2. GSettings       — GNOME `org.gnome.desktop.interface` → `scaling-factor`
  *   3. `GDK_SCALE`     — GTK / GNOME session variable
  *   4. `GDK_DPI_SCALE` — GTK fractional DPI multiplier
- *   5. `Xft.dpi`       — X Resource Manager (KDE, legacy GNOME, …)
+ *   5. XSETTINGS       — `Gdk/WindowScalingFactor` / `Xft/DPI`, then the
+ *                        `Xft.dpi` X resource (KDE, legacy GNOME, …), refined
+ *                        by the compositor's fractional scale (Mutter's
+ *                        `monitors.xml` for the connected outputs, KDE's
+ *                        `kdeglobals` / `kwinrc`) when it lies in the same
+ *                        integer step, e.g. 1.5 where XSETTINGS reports 2
+ *
+ * The result is cached on disk (see [LinuxScaleCache]) and reused while the
+ * session environment and the desktop settings files are unchanged, so a
+ * regular launch skips loading libgio / libX11 and the X connection.
  *
  * @return A positive scale factor (e.g. `2.0` for a 200 % HiDPI display),
  *         or `0.0` when the scale cannot be determined (let the JVM decide).
@@ -22,10 +31,56 @@ package io.github.kdroidfilter.nucleus.hidpi
  * ```
  * This function is a no-op on non-Linux platforms and returns `0.0`.
  */
-fun getLinuxNativeScaleFactor(): Double {
-    if (!System.getProperty("os.name").contains("Linux", ignoreCase = true)) return 0.0
+fun getLinuxNativeScaleFactor(): Double = detectScaleFactor(timeoutMillis = null) ?: 0.0
+
+/**
+ * Starts scale detection in the background without waiting for it.
+ *
+ * Starts the slow probes (GSettings through libgio, XSETTINGS through an X
+ * connection) on a native thread. Call this as early as possible in
+ * `main()`, before AWT initialises, do other startup work, then call
+ * [awaitLinuxNativeScaleFactor] or [applyLinuxHiDpiScale] to collect the
+ * result. Does nothing on a startup cache hit or on non-Linux platforms.
+ */
+fun startLinuxScaleDetection() {
+    if (!isLinux()) return
+    if (LinuxScaleCache.read() != null) return
+    // A load failure is logged by the bridge; detection then falls back to environment variables
+    if (HiDpiLinuxBridge.isLoaded) HiDpiLinuxBridge.nativeStartDetection()
+}
+
+/**
+ * Like [getLinuxNativeScaleFactor], but waits at most [timeoutMillis] for
+ * the background probes. `J2D_UISCALE` and cached results return at once;
+ * `GDK_SCALE` / `GDK_DPI_SCALE` only wait for the GSettings probe.
+ *
+ * @return The scale factor (`0.0` when not detected), or `null` if the
+ *         deadline passed first (e.g. an unresponsive X server).
+ */
+fun awaitLinuxNativeScaleFactor(timeoutMillis: Long): Double? = detectScaleFactor(timeoutMillis)
+
+/** Default deadline of [applyLinuxHiDpiScale] for the background probes. */
+const val DEFAULT_SCALE_DETECTION_TIMEOUT_MILLIS = 2000L
+
+private fun isLinux(): Boolean = System.getProperty("os.name").contains("Linux", ignoreCase = true)
+
+// null timeout = wait for detection to complete
+private fun detectScaleFactor(timeoutMillis: Long?): Double? {
+    if (!isLinux()) return 0.0
+    LinuxScaleCache.read()?.let { return it }
     return try {
-        HiDpiLinuxBridge.nativeGetScaleFactor()
+        val scale =
+            if (timeoutMillis == null) {
+                HiDpiLinuxBridge.nativeGetScaleFactor()
+            } else {
+                HiDpiLinuxBridge.nativeAwaitScaleFactor(timeoutMillis)
+            }
+        when (scale) {
+            HiDpiLinuxBridge.SCALE_TIMEOUT -> null
+            // Not a property of the session: a startup-path launch can still detect it
+            HiDpiLinuxBridge.SCALE_SKIPPED -> 0.0
+            else -> scale.also { LinuxScaleCache.write(it) }
+        }
     } catch (_: Throwable) {
         // JNI unavailable — fall back to environment variables only
         System.getenv("J2D_UISCALE")?.toDoubleOrNull()?.takeIf { it > 0 }
@@ -36,41 +91,51 @@ fun getLinuxNativeScaleFactor(): Double {
 }
 
 /**
- * Applies the detected HiDPI scale factor for Linux.
+ * Applies the detected HiDPI scale factor for Linux, fractional factors
+ * included (e.g. 1.25 or 1.5 from GNOME / KDE display settings).
  *
  * This function sets up HiDPI scaling in a way that is compatible with
  * both JetBrains Runtime and standard OpenJDK / GraalVM native image:
  *
- * 1. **`GDK_SCALE` environment variable** (via native `setenv`):
+ * 1. **Environment variable** (via native `setenv`):
  *    Triggers the JDK's native `X11GraphicsDevice.getNativeScaleFactor()`
  *    detection path, which properly configures **both** rendering AND
- *    mouse event coordinate scaling (`XWindow.scaleDown()`).
- *    This is the same path that JBR uses internally.
+ *    mouse event coordinate scaling (`XWindow.scaleDown()`). The native
+ *    side picks the variable the running JDK honours: `GDK_SCALE` for
+ *    integral scales, `J2D_UISCALE` for fractional ones on JetBrains
+ *    Runtime. OpenJDK's X11 pipeline only applies integral scales, so a
+ *    fractional factor is rounded to the nearest integer there.
+ *
+ * 2. **`sun.java2d.uiScale` system property**:
+ *    Set to the same factor the native path applied, so rendering and
+ *    input always agree, and as a fallback when JNI is unavailable.
  *
- * 2. **`sun.java2d.uiScale` system property** (fallback):
- *    For JDKs where the native detection doesn't read `GDK_SCALE`,
- *    this ensures at least the rendering is at HiDPI resolution.
- *    On some JDKs this may not scale mouse events correctly, but
- *    step 1 should handle most cases.
+ * Detection waits at most [timeoutMillis] (see [awaitLinuxNativeScaleFactor]);
+ * past the deadline the JVM's own scale detection is left in charge.
  *
  * **Call this before AWT initialises** (i.e. before `application {}`).
  */
-fun applyLinuxHiDpiScale() {
-    if (!System.getProperty("os.name").contains("Linux", ignoreCase = true)) return
+fun applyLinuxHiDpiScale(timeoutMillis: Long = DEFAULT_SCALE_DETECTION_TIMEOUT_MILLIS) {
+    if (!isLinux()) return
     if (System.getProperty("sun.java2d.uiScale") != null) return // already configured
 
-    val scale = getLinuxNativeScaleFactor()
+    val scale = awaitLinuxNativeScaleFactor(timeoutMillis) ?: return
     if (scale <= 0.0) return
 
-    // Step 1: set GDK_SCALE in the process env so the JDK's native
-    // detection path picks it up → full scaling (rendering + input)
-    try {
-        HiDpiLinuxBridge.nativeApplyScaleToEnv(scale.toInt())
-    } catch (_: Throwable) {
-        // JNI unavailable — continue with property-only approach
-    }
+    // Step 1: export the scale so the JDK's native detection path picks it
+    // up → full scaling (rendering + input)
+    val applied =
+        try {
+            when (HiDpiLinuxBridge.nativeApplyScaleToEnv(scale)) {
+                HiDpiLinuxBridge.APPLY_GDK_SCALE_ROUNDED -> Math.round(scale).toDouble()
+                else -> scale
+            }
+        } catch (_: Throwable) {
+            // JNI unavailable — continue with property-only approach
+            scale
+        }
 
-    // Step 2: set sun.java2d.uiScale as backup
+    // Step 2: sun.java2d.uiScale with the factor actually applied
     System.setProperty("sun.java2d.uiScale.enabled", "true")
-    System.setProperty("sun.java2d.uiScale", scale.toString())
+    System.setProperty("sun.java2d.uiScale", applied.toString())
 }
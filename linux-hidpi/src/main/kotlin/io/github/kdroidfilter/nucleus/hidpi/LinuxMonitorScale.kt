@@ -0,0 +1,65 @@
+package io.github.kdroidfilter.nucleus.hidpi
+
+/**
+ * One connected Linux output as reported by XRandR.
+ *
+ * @property x Left edge in X screen pixels.
+ * @property y Top edge in X screen pixels.
+ * @property width Width in X screen pixels (after rotation).
+ * @property height Height in X screen pixels (after rotation).
+ * @property widthMm Physical width from the EDID, in millimetres (0 if unknown).
+ * @property heightMm Physical height from the EDID, in millimetres (0 if unknown).
+ * @property scale Scale derived from the physical DPI (DPI / 96, in steps of
+ *           0.25), or `0.0` when the EDID size is missing or implausible.
+ * @property isPrimary Whether this is the primary output.
+ */
+data class LinuxMonitorScale(
+    val x: Int,
+    val y: Int,
+    val width: Int,
+    val height: Int,
+    val widthMm: Int,
+    val heightMm: Int,
+    val scale: Double,
+    val isPrimary: Boolean,
+) {
+    /** Whether the given point (X screen pixels) lies on this output. */
+    fun contains(
+        px: Int,
+        py: Int,
+    ): Boolean = px >= x && py >= y && px < x + width && py < y + height
+}
+
+/**
+ * Returns the connected outputs of the current X display with their
+ * physical size and derived scale, so windows can be rendered at the
+ * density of the monitor they are on rather than one global factor.
+ *
+ * Uses XRandR (loaded with `dlopen`, no hard dependency). Returns an empty
+ * list on non-Linux platforms, on Wayland sessions without XWayland, or
+ * when the native library / libXrandr is unavailable.
+ */
+fun getLinuxMonitorScales(): List<LinuxMonitorScale> {
+    if (!System.getProperty("os.name").contains("Linux", ignoreCase = true)) return emptyList()
+    val packed =
+        try {
+            HiDpiLinuxBridge.nativeGetMonitorScales()
+        } catch (_: Throwable) {
+            null
+        } ?: return emptyList()
+
+    val size = HiDpiLinuxBridge.MONITOR_RECORD_SIZE
+    return List(packed.size / size) { i ->
+        val o = i * size
+        LinuxMonitorScale(
+            x = packed[o].toInt(),
+            y = packed[o + 1].toInt(),
+            width = packed[o + 2].toInt(),
+            height = packed[o + 3].toInt(),
+            widthMm = packed[o + 4].toInt(),
+            heightMm = packed[o + 5].toInt(),
+            scale = packed[o + 6],
+            isPrimary = packed[o + 7] != 0.0,
+        )
+    }
+}
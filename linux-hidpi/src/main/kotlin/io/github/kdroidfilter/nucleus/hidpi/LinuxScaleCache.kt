@@ -0,0 +1,170 @@
+package io.github.kdroidfilter.nucleus.hidpi
+
+import java.io.IOException
+import java.nio.charset.StandardCharsets
+import java.nio.file.AtomicMoveNotSupportedException
+import java.nio.file.Files
+import java.nio.file.Path
+import java.nio.file.Paths
+import java.nio.file.StandardCopyOption
+
+/**
+ * On-disk cache of the detected scale factor, so that a regular launch reads
+ * one small file instead of loading libgio / libX11 and connecting to the
+ * X server.
+ *
+ * The entry is keyed by everything the native detection depends on: the
+ * display and session environment, the GDK / J2D variables, and the
+ * modification times of the files desktop environments write when the user
+ * changes the scale (dconf database, Mutter's monitors.xml, Xresources, KDE and Xfce
+ * settings), plus a fingerprint of the connected outputs so that plugging in
+ * or swapping a monitor is a miss too.
+ * Any difference is a miss, and the fresh result replaces the entry.
+ *
+ * Location: `$XDG_CACHE_HOME/nucleus/hidpi-scale` (default `~/.cache`).
+ * Disable with `-Dnucleus.hidpi.cache=false`.
+ */
+internal object LinuxScaleCache {
+    private const val VERSION_LINE = "nucleus-hidpi-scale 1"
+    private const val FILE_NAME = "hidpi-scale"
+    private const val DRM_DIR = "/sys/class/drm"
+
+    private val KEY_ENV =
+        listOf(
+            "DISPLAY",
+            "WAYLAND_DISPLAY",
+            "XDG_SESSION_ID",
+            "XDG_SESSION_TYPE",
+            "XDG_CURRENT_DESKTOP",
+            "GDK_SCALE",
+            "GDK_DPI_SCALE",
+            "J2D_UISCALE",
+        )
+
+    // Relative to $XDG_CONFIG_HOME
+    private val KEY_CONFIG_FILES =
+        listOf(
+            "dconf/user",
+            "monitors.xml",
+            "kdeglobals",
+            "kwinrc",
+            "xfce4/xfconf/xfce-perchannel-xml/xsettings.xml",
+        )
+
+    // Relative to $HOME
+    private val KEY_HOME_FILES = listOf(".Xresources", ".Xdefaults")
+
+    private val enabled: Boolean
+        get() = System.getProperty("nucleus.hidpi.cache") != "false"
+
+    private val home: String? get() = System.getProperty("user.home")
+
+    private val cacheFile: Path?
+        get() {
+            val base =
+                System.getenv("XDG_CACHE_HOME")?.takeIf { it.isNotEmpty() }
+                    ?: home?.let { "$it/.cache" }
+                    ?: return null
+            return Paths.get(base, "nucleus", FILE_NAME)
+        }
+
+    private fun mtime(
+        dir: String?,
+        name: String,
+    ): Long {
+        if (dir == null) return -1L
+        return try {
+            Files.getLastModifiedTime(Paths.get(dir, name)).toMillis()
+        } catch (_: IOException) {
+            -1L
+        }
+    }
+
+    // One "connector:status:edid hash" entry per DRM connector (card0-eDP-1, …),
+    // in name order. Reading sysfs costs no X connection; the EDID identifies
+    // the panel, so a monitor swapped on the same port changes the key too.
+    private fun outputFingerprint(): String {
+        val connectors =
+            try {
+                Files.newDirectoryStream(Paths.get(DRM_DIR), "card*-*").use { dir -> dir.sorted() }
+            } catch (_: IOException) {
+                return ""
+            }
+        return connectors.joinToString(",") { connector ->
+            val status =
+                try {
+                    String(Files.readAllBytes(connector.resolve("status")), StandardCharsets.US_ASCII).trim()
+                } catch (_: IOException) {
+                    "?"
+                }
+            val edid =
+                try {
+                    Files.readAllBytes(connector.resolve("edid")).contentHashCode()
+                } catch (_: IOException) {
+                    0
+                }
+            "${connector.fileName}:$status:${Integer.toHexString(edid)}"
+        }
+    }
+
+    private fun currentKey(): List<String> {
+        val configHome =
+            System.getenv("XDG_CONFIG_HOME")?.takeIf { it.isNotEmpty() }
+                ?: home?.let { "$it/.config" }
+        val key = ArrayList<String>(KEY_ENV.size + KEY_CONFIG_FILES.size + KEY_HOME_FILES.size + 1)
+        KEY_ENV.forEach { key.add("$it=${System.getenv(it) ?: ""}") }
+        KEY_CONFIG_FILES.forEach { key.add("$it@${mtime(configHome, it)}") }
+        KEY_HOME_FILES.forEach { key.add("~/$it@${mtime(home, it)}") }
+        key.add("outputs=${outputFingerprint()}")
+        return key
+    }
+
+    /** The cached scale for the current environment, or null on a miss. */
+    fun read(): Double? {
+        if (!enabled) return null
+        val file = cacheFile ?: return null
+        val lines =
+            try {
+                Files.readAllLines(file, StandardCharsets.UTF_8)
+            } catch (_: IOException) {
+                return null
+            }
+        if (lines.size < 2 || lines[0] != VERSION_LINE) return null
+        if (lines.subList(2, lines.size) != currentKey()) return null
+        return lines[1].toDoubleOrNull()
+    }
+
+    /** Stores [scale] (including `0.0`, "not detected") for the current environment. */
+    fun write(scale: Double) {
+        if (!enabled) return
+        val file = cacheFile ?: return
+        val content = (listOf(VERSION_LINE, scale.toString()) + currentKey()).joinToString("\n", postfix = "\n")
+        try {
+            Files.createDirectories(file.parent)
+            // Write then rename, so concurrent launches never read a partial entry
+            val tmp = Files.createTempFile(file.parent, FILE_NAME, ".tmp")
+            try {
+                Files.write(tmp, content.toByteArray(StandardCharsets.UTF_8))
+                try {
+                    Files.move(tmp, file, StandardCopyOption.REPLACE_EXISTING, StandardCopyOption.ATOMIC_MOVE)
+                } catch (_: AtomicMoveNotSupportedException) {
+                    Files.move(tmp, file, StandardCopyOption.REPLACE_EXISTING)
+                }
+            } finally {
+                Files.deleteIfExists(tmp)
+            }
+        } catch (_: IOException) {
+            // Read-only or full home: detection simply runs again next launch
+        }
+    }
+
+    /** Drops the entry, e.g. after a live scale change the key cannot see. */
+    fun invalidate() {
+        val file = cacheFile ?: return
+        try {
+            Files.deleteIfExists(file)
+        } catch (_: IOException) {
+            // Stale entry stays until the key changes
+        }
+    }
+}
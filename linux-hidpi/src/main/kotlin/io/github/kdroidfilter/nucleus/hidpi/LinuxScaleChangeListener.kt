@@ -0,0 +1,49 @@
+package io.github.kdroidfilter.nucleus.hidpi
+
+/**
+ * Receives Linux desktop scale changes made while the application runs
+ * (e.g. the user changing the display scale in GNOME Settings or KDE
+ * System Settings).
+ *
+ * Called on a native background thread; hop to the UI thread before
+ * touching UI state.
+ */
+fun interface LinuxScaleChangeListener {
+    /**
+     * @param scale The new scale factor (`Gdk/WindowScalingFactor`, else DPI / 96),
+     *              or `0.0` when the X server no longer advertises one.
+     * @param dpi The new `Xft/DPI` (or `Xft.dpi` resource) value, or `0.0` if absent.
+     */
+    fun onScaleChanged(
+        scale: Double,
+        dpi: Double,
+    )
+}
+
+/**
+ * Registers [listener] for scale and DPI changes published through
+ * XSETTINGS (`Gdk/WindowScalingFactor`, `Xft/DPI`) or the `Xft.dpi` X
+ * resource. Changes are pushed by the X server (PropertyNotify), there is
+ * no polling.
+ *
+ * @return `false` on non-Linux platforms or when the native monitor cannot
+ *         be started (JNI library or X display unavailable).
+ */
+fun addLinuxScaleChangeListener(listener: LinuxScaleChangeListener): Boolean {
+    if (!System.getProperty("os.name").contains("Linux", ignoreCase = true)) return false
+    return try {
+        HiDpiLinuxBridge.addScaleChangeListener(listener)
+    } catch (_: Throwable) {
+        false
+    }
+}
+
+/** Unregisters a listener added with [addLinuxScaleChangeListener]. */
+fun removeLinuxScaleChangeListener(listener: LinuxScaleChangeListener) {
+    if (!System.getProperty("os.name").contains("Linux", ignoreCase = true)) return
+    try {
+        HiDpiLinuxBridge.removeScaleChangeListener(listener)
+    } catch (_: Throwable) {
+        // JNI unavailable — nothing was registered
+    }
+}
@@ -10,6 +10,8 @@ set -euo pipefail
 SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
 SRC="$SCRIPT_DIR/nucleus_hidpi_linux.c"
 RESOURCE_DIR="$SCRIPT_DIR/../../resources/nucleus/native"
+# nucleus_native_stats.h, shared by the Linux bridges
+STATS_INCLUDE="$SCRIPT_DIR/../../../../../core-runtime/src/main/native/include"
 OUT_DIR_X64="$RESOURCE_DIR/linux-x64"
 OUT_DIR_AARCH64="$RESOURCE_DIR/linux-aarch64"
 
@@ -35,13 +37,19 @@ if [ ! -d "$JNI_INCLUDE" ]; then
     exit 1
 fi
 
+# Size and SHA-256 of a built library, read by core-runtime's NativeLibraryLoader
+# to find its extraction cache entry without hashing the library at runtime
+write_manifest() {
+    printf 'size=%s\nsha256=%s\n' "$(wc -c < "$1" | tr -d ' ')" "$(sha256sum "$1" | cut -d' ' -f1)" > "$1.manifest"
+}
+
 HOST_ARCH="$(uname -m)"
 
 COMMON_FLAGS=(
     -shared
     -fPIC
-    -I"$JNI_INCLUDE" -I"$JNI_INCLUDE_LINUX"
-    -ldl
+    -I"$JNI_INCLUDE" -I"$JNI_INCLUDE_LINUX" -I"$STATS_INCLUDE"
+    -ldl -lpthread
     -O2
     -fvisibility=hidden
     -s
@@ -53,12 +61,14 @@ if [ "$HOST_ARCH" = "x86_64" ]; then
     mkdir -p "$OUT_DIR_X64"
     gcc "${COMMON_FLAGS[@]}" \
         -o "$OUT_DIR_X64/libnucleus_linux_hidpi_jni.so" "$SRC"
+    write_manifest "$OUT_DIR_X64/libnucleus_linux_hidpi_jni.so"
     echo "Built x64:"
     ls -lh "$OUT_DIR_X64/libnucleus_linux_hidpi_jni.so"
 elif [ "$HOST_ARCH" = "aarch64" ]; then
     mkdir -p "$OUT_DIR_AARCH64"
     gcc "${COMMON_FLAGS[@]}" \
         -o "$OUT_DIR_AARCH64/libnucleus_linux_hidpi_jni.so" "$SRC"
+    write_manifest "$OUT_DIR_AARCH64/libnucleus_linux_hidpi_jni.so"
     echo "Built aarch64:"
     ls -lh "$OUT_DIR_AARCH64/libnucleus_linux_hidpi_jni.so"
 else
@@ -74,6 +84,7 @@ if [ "$HOST_ARCH" = "x86_64" ]; then
             -o "$OUT_DIR_AARCH64/libnucleus_linux_hidpi_jni.so" "$SRC" || \
             echo "WARNING: aarch64 cross-compilation failed (non-fatal)."
         if [ -f "$OUT_DIR_AARCH64/libnucleus_linux_hidpi_jni.so" ]; then
+            write_manifest "$OUT_DIR_AARCH64/libnucleus_linux_hidpi_jni.so"
             echo "Built aarch64 (cross):"
             ls -lh "$OUT_DIR_AARCH64/libnucleus_linux_hidpi_jni.so"
         fi
@@ -87,6 +98,7 @@ elif [ "$HOST_ARCH" = "aarch64" ]; then
             -o "$OUT_DIR_X64/libnucleus_linux_hidpi_jni.so" "$SRC" || \
             echo "WARNING: x64 cross-compilation failed (non-fatal)."
         if [ -f "$OUT_DIR_X64/libnucleus_linux_hidpi_jni.so" ]; then
+            write_manifest "$OUT_DIR_X64/libnucleus_linux_hidpi_jni.so"
             echo "Built x64 (cross):"
             ls -lh "$OUT_DIR_X64/libnucleus_linux_hidpi_jni.so"
         fi
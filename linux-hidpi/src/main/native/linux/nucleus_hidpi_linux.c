@@ -9,21 +9,76 @@
  * Detection order (same priority as JBR):
  *   1. J2D_UISCALE   — explicit JVM override (env var)
  *   2. GSettings     — GNOME integer scaling via libgio (dlopen, no hard dep)
- *   3. GDK_SCALE     — GTK environment variable
+ *   3. GDK_SCALE     — GTK environment variable (× GDK_DPI_SCALE if set)
  *   4. GDK_DPI_SCALE — GTK fractional DPI multiplier
- *   5. Xft.dpi       — X Resource Manager via libX11 (dlopen, no hard dep)
+ *   5. XSETTINGS     — Gdk/WindowScalingFactor or Xft/DPI from the
+ *                      _XSETTINGS_S<screen> owner, then the Xft.dpi X
+ *                      resource, via libX11 (dlopen, no hard dep); refined
+ *                      by the compositor's fractional scale (Mutter's
+ *                      monitors.xml, KWin's kwinrc / kdeglobals) when that
+ *                      lies within the same integer step
  *
- * All external libraries (libgio, libX11) are loaded at runtime via dlopen
- * so the .so itself has no hard link-time dependencies beyond libc/libdl.
- * Linked libraries: -ldl
+ * nativeGetMonitorScales additionally reports each connected output's
+ * geometry, physical size and derived scale through XRandR, so windows can
+ * be rendered at their own monitor's density on mixed-DPI setups.
+ *
+ * The slow probes (2 and 5) run on a background thread started by
+ * nativeStartDetection (or the first scale query); nativeAwaitScaleFactor
+ * joins them with a deadline, and J2D_UISCALE is answered without waiting.
+ * Once AWT may be using Xlib the X probe no longer starts (see beginXProbe).
+ *
+ * nativeStartObserving runs a thread on a private X connection that watches
+ * the XSETTINGS window and RESOURCE_MANAGER through PropertyNotify and
+ * reports scale/DPI changes to HiDpiLinuxBridge.onScaleChanged.
+ *
+ * Each JNI entry point, background probe and monitor wakeup is a probe of
+ * nucleus_native_stats.h (core-runtime), read through NucleusNativeStats.
+ * The background probes run once, at load, and are always recorded.
+ *
+ * All external libraries (libgio, libX11, libXrandr) are loaded at runtime
+ * via dlopen so the .so itself has no hard link-time dependencies beyond
+ * libc/libdl.
+ * Linked libraries: -ldl -lpthread
  */
 
 #include <jni.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
 #include <dlfcn.h>
 
+#ifdef NUCLEUS_LINUX_COMBINED
+/* Built into libnucleus_linux, which runs this when HiDpiLinuxBridge loads */
+#include "nucleus_linux_combined.h"
+#define JNI_OnLoad nucleus_hidpi_OnLoad
+#endif
+
+/* Call statistics probes (must match STATS_PROBES in HiDpiLinuxBridge.kt) */
+enum {
+    PROBE_ON_LOAD,
+    PROBE_GET_SCALE_FACTOR,
+    PROBE_AWAIT_SCALE_FACTOR,
+    PROBE_START_DETECTION,
+    PROBE_APPLY_SCALE_TO_ENV,
+    PROBE_GET_MONITOR_SCALES,
+    PROBE_START_OBSERVING,
+    PROBE_STOP_OBSERVING,
+    PROBE_DETECT_DESKTOP_SCALE,
+    PROBE_DETECT_X_SCALE,
+    PROBE_MONITOR_WAKEUP,
+    PROBE_COUNT
+};
+#define NUCLEUS_STATS_PROBES PROBE_COUNT
+#include "nucleus_native_stats.h"
+
 /* ------------------------------------------------------------------ */
 /*  Minimal type stubs (avoid hard dependency on X11/GLib headers)     */
 /* ------------------------------------------------------------------ */
@@ -34,6 +89,39 @@ typedef struct {
     void        *addr;
 } MyXrmValue;
 
+/* XRandR 1.3 structures as defined in X11/extensions/Xrandr.h, truncated
+ * after the last field we read (instances are always allocated by Xrandr) */
+typedef struct {
+    unsigned long  timestamp;
+    unsigned long  configTimestamp;
+    int            ncrtc;
+    unsigned long *crtcs;
+    int            noutput;
+    unsigned long *outputs;
+} MyXRRScreenResources;
+
+typedef struct {
+    unsigned long  timestamp;
+    unsigned long  crtc;
+    char          *name;
+    int            nameLen;
+    unsigned long  mm_width;
+    unsigned long  mm_height;
+    unsigned short connection;
+} MyXRROutputInfo;
+
+typedef struct {
+    unsigned long  timestamp;
+    int            x, y;
+    unsigned int   width, height;
+    unsigned long  mode;
+    unsigned short rotation;
+} MyXRRCrtcInfo;
+
+#define MY_RR_CONNECTED  0
+#define MY_RR_ROTATE_90  2
+#define MY_RR_ROTATE_270 8
+
 /* ------------------------------------------------------------------ */
 /*  readEnvDouble — parse a positive double from an env variable       */
 /* ------------------------------------------------------------------ */
@@ -98,115 +186,1306 @@ static double readGnomeScaleFactor(void) {
 }
 
 /* ------------------------------------------------------------------ */
-/*  readXftScale                                                       */
-/*  Reads Xft.dpi from the X11 Resource Manager via dlopen(libX11).  */
-/*  No hard link-time dependency on libX11.                            */
+/*  Fractional desktop scale                                           */
+/*  GSettings' scaling-factor is an integer (0 = automatic). The      */
+/*  fractional factor chosen in GNOME or KDE settings lives in the    */
+/*  compositor's own config files:                                     */
+/*    Mutter  ~/.config/monitors.xml  <logicalmonitor><scale>          */
+/*    KWin    ~/.config/kwinrc        [Xwayland] Scale   (Wayland)    */
+/*            ~/.config/kdeglobals    [KScreen] ScaleFactor (X11)     */
 /* ------------------------------------------------------------------ */
-static double readXftScale(void) {
-    void *libx11 = dlopen("libX11.so.6", RTLD_LAZY | RTLD_LOCAL);
-    if (!libx11) return 0.0;
-
-    typedef void* (*fn_XOpenDisplay)(const char*);
-    typedef char* (*fn_XResourceManagerString)(void*);
-    typedef int   (*fn_XCloseDisplay)(void*);
-    typedef void  (*fn_XrmInitialize)(void);
-    typedef void* (*fn_XrmGetStringDatabase)(const char*);
-    typedef int   (*fn_XrmGetResource)(void*, const char*, const char*, char**, MyXrmValue*);
-    typedef void  (*fn_XrmDestroyDatabase)(void*);
-
-    fn_XOpenDisplay         fOpen   = (fn_XOpenDisplay)dlsym(libx11, "XOpenDisplay");
-    fn_XResourceManagerString fRm   = (fn_XResourceManagerString)dlsym(libx11, "XResourceManagerString");
-    fn_XCloseDisplay        fClose  = (fn_XCloseDisplay)dlsym(libx11, "XCloseDisplay");
-    fn_XrmInitialize        fRmInit = (fn_XrmInitialize)dlsym(libx11, "XrmInitialize");
-    fn_XrmGetStringDatabase fRmDb   = (fn_XrmGetStringDatabase)dlsym(libx11, "XrmGetStringDatabase");
-    fn_XrmGetResource       fRmGet  = (fn_XrmGetResource)dlsym(libx11, "XrmGetResource");
-    fn_XrmDestroyDatabase   fRmDel  = (fn_XrmDestroyDatabase)dlsym(libx11, "XrmDestroyDatabase");
-
-    if (!fOpen || !fRm || !fClose || !fRmInit || !fRmDb || !fRmGet || !fRmDel) {
-        dlclose(libx11);
+#define CONFIG_FILE_MAX (256 * 1024)
+
+/* Reads $XDG_CONFIG_HOME/<name> (default ~/.config) into a malloc'd,
+ * NUL-terminated buffer; NULL if missing or unreasonably large. */
+static char *readConfigFile(const char *name) {
+    char path[1024];
+    const char *configHome = getenv("XDG_CONFIG_HOME");
+    const char *home = getenv("HOME");
+    if (configHome && configHome[0]) {
+        snprintf(path, sizeof(path), "%s/%s", configHome, name);
+    } else if (home && home[0]) {
+        snprintf(path, sizeof(path), "%s/.config/%s", home, name);
+    } else {
+        return NULL;
+    }
+
+    FILE *f = fopen(path, "r");
+    if (!f) return NULL;
+    char *buf = (char *)malloc(CONFIG_FILE_MAX + 1);
+    size_t len = buf ? fread(buf, 1, CONFIG_FILE_MAX, f) : 0;
+    int tooLarge = buf && len == CONFIG_FILE_MAX && fgetc(f) != EOF;
+    fclose(f);
+    if (!buf || tooLarge) {
+        free(buf);
+        return NULL;
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+/* Value of key= in [section] of an INI-style (KConfig) file, 0.0 if absent */
+static double readIniDouble(const char *name, const char *section, const char *key) {
+    char *buf = readConfigFile(name);
+    if (!buf) return 0.0;
+
+    double value = 0.0;
+    size_t keyLen = strlen(key);
+    int inSection = 0;
+    for (char *line = strtok(buf, "\n"); line; line = strtok(NULL, "\n")) {
+        if (line[0] == '[') {
+            char *close = strchr(line, ']');
+            inSection = close && (size_t)(close - line - 1) == strlen(section) &&
+                        strncmp(line + 1, section, strlen(section)) == 0;
+        } else if (inSection && strncmp(line, key, keyLen) == 0 && line[keyLen] == '=') {
+            char *end;
+            double d = strtod(line + keyLen + 1, &end);
+            if (end != line + keyLen + 1 && d > 0.0) value = d;
+        }
+    }
+    free(buf);
+    return value;
+}
+
+/* Connected outputs (XRandR names), to find the monitors.xml configuration
+ * for the monitor set that is plugged in */
+#define OUTPUT_MAX      16
+#define OUTPUT_NAME_MAX 32
+
+typedef struct {
+    int  count;
+    char names[OUTPUT_MAX][OUTPUT_NAME_MAX];
+} OutputNames;
+
+/* Whether the configuration lists exactly the connected outputs: every
+ * <connector> it names is connected, and every connected output is named */
+static int configurationMatches(const char *config, const OutputNames *outputs) {
+    if (outputs->count == 0) return 0;
+    int seen[OUTPUT_MAX] = { 0 };
+    for (const char *tag = strstr(config, "<connector>"); tag; tag = strstr(tag + 1, "<connector>")) {
+        const char *name = tag + 11;
+        const char *close = strstr(name, "</connector>");
+        if (!close) return 0;
+        size_t len = (size_t)(close - name);
+        int found = 0;
+        for (int i = 0; i < outputs->count; i++) {
+            if (strlen(outputs->names[i]) == len && strncmp(outputs->names[i], name, len) == 0) {
+                seen[i] = found = 1;
+            }
+        }
+        if (!found) return 0;
+    }
+    for (int i = 0; i < outputs->count; i++) {
+        if (!seen[i]) return 0;
+    }
+    return 1;
+}
+
+/* Scale of the primary (else first) logical monitor of one <configuration> */
+static double configurationScale(char *config) {
+    double first = 0.0;
+    for (char *lm = strstr(config, "<logicalmonitor>"); lm; lm = strstr(lm + 1, "<logicalmonitor>")) {
+        char *end = strstr(lm, "</logicalmonitor>");
+        if (!end) break;
+        *end = '\0';
+        char *tag = strstr(lm, "<scale>");
+        double d = tag ? strtod(tag + 7, NULL) : 0.0;
+        int primary = strstr(lm, "<primary>yes</primary>") != NULL;
+        *end = '<';
+        if (d <= 0.0) continue;
+        if (primary) return d;
+        if (first == 0.0) first = d;
+    }
+    return first;
+}
+
+/* Scale from Mutter's monitors.xml. The file holds one <configuration> per
+ * monitor set seen so far; only the one for the connected outputs applies. */
+static double readMutterScale(const OutputNames *outputs) {
+    char *buf = readConfigFile("monitors.xml");
+    if (!buf) return 0.0;
+
+    double scale = 0.0;
+    for (char *config = strstr(buf, "<configuration>"); config;
+         config = strstr(config + 1, "<configuration>")) {
+        char *end = strstr(config, "</configuration>");
+        if (!end) break;
+        *end = '\0';
+        if (configurationMatches(config, outputs)) scale = configurationScale(config);
+        *end = '<';
+        if (scale > 0.0) break;
+    }
+    free(buf);
+    return scale;
+}
+
+/*
+ * Under Wayland, X clients are only told a scale meant for them (KWin's
+ * Xwayland scale; Mutter publishes its own through XSETTINGS). The X11
+ * session files apply to X clients directly. outputs is only read for
+ * Mutter, and only filled (by the callback) when needed.
+ */
+static double readCompositorScale(void (*readOutputs)(void *, OutputNames *), void *ctx) {
+    const char *wayland = getenv("WAYLAND_DISPLAY");
+    if (wayland && wayland[0]) return readIniDouble("kwinrc", "Xwayland", "Scale");
+
+    double scale = readIniDouble("kdeglobals", "KScreen", "ScaleFactor");
+    if (scale > 0.0) return scale;
+
+    OutputNames outputs;
+    outputs.count = 0;
+    readOutputs(ctx, &outputs);
+    return readMutterScale(&outputs);
+}
+
+/* Integer step of a scale: 1 for 1.0, 2 for (1.0, 2.0], … */
+static int scaleStep(double scale) {
+    return (int)(scale - 0.01) + 1;
+}
+
+/*
+ * The compositor's files can be stale or describe another session, so they
+ * only refine what the X server reports: a fractional 1.5 is taken over the
+ * XSETTINGS 2 it rounds up to, never over a 1 or a 3.
+ */
+static double refineXScale(double xScale, double compositorScale) {
+    if (xScale <= 0.0 || compositorScale <= 0.0) return xScale;
+    return scaleStep(compositorScale) == scaleStep(xScale) ? compositorScale : xScale;
+}
+
+/* ------------------------------------------------------------------ */
+/*  libX11 entry points                                                */
+/*  Resolved through dlopen so there is no hard link-time dependency  */
+/*  on libX11. Shared by the one-shot probe and the settings monitor. */
+/* ------------------------------------------------------------------ */
+
+/* Minimal Xlib event layouts (X11/Xlib.h), enough for the settings monitor */
+typedef struct {
+    int           type;
+    unsigned long serial;
+    int           send_event;
+    void         *display;
+    unsigned long window;
+    unsigned long atom;
+} MyXPropertyEvent;
+
+typedef struct {
+    int           type;
+    unsigned long serial;
+    int           send_event;
+    void         *display;
+    unsigned long window;
+    unsigned long message_type;
+    int           format;
+    long          l[5];
+} MyXClientMessageEvent;
+
+typedef struct {
+    int           type;
+    unsigned long serial;
+    int           send_event;
+    void         *display;
+    unsigned long event;
+    unsigned long window;
+} MyXDestroyWindowEvent;
+
+typedef union {
+    int                   type;
+    MyXPropertyEvent      xproperty;
+    MyXClientMessageEvent xclient;
+    MyXDestroyWindowEvent xdestroywindow;
+    long                  pad[24];
+} MyXEvent;
+
+#define MY_DESTROY_NOTIFY         17
+#define MY_PROPERTY_NOTIFY        28
+#define MY_CLIENT_MESSAGE         33
+#define MY_STRUCTURE_NOTIFY_MASK  (1L << 17)
+#define MY_PROPERTY_CHANGE_MASK   (1L << 22)
+#define MY_XA_STRING              31
+#define MY_ANY_PROPERTY_TYPE      0
+
+typedef int (*XErrorHandlerFn)(void *, void *);
+
+typedef struct {
+    void *lib;
+    void*         (*OpenDisplay)(const char*);
+    int           (*CloseDisplay)(void*);
+    unsigned long (*DefaultRootWindow)(void*);
+    int           (*DefaultScreen)(void*);
+    int           (*ConnectionNumber)(void*);
+    unsigned long (*InternAtom)(void*, const char*, int);
+    unsigned long (*GetSelectionOwner)(void*, unsigned long);
+    int           (*GetWindowProperty)(void*, unsigned long, unsigned long, long, long, int,
+                                       unsigned long, unsigned long*, int*, unsigned long*,
+                                       unsigned long*, unsigned char**);
+    int           (*Free)(void*);
+    int           (*SelectInput)(void*, unsigned long, long);
+    int           (*Pending)(void*);
+    int           (*NextEvent)(void*, MyXEvent*);
+    XErrorHandlerFn (*SetErrorHandler)(XErrorHandlerFn);
+    void          (*RmInitialize)(void);
+    void*         (*RmGetStringDatabase)(const char*);
+    int           (*RmGetResource)(void*, const char*, const char*, char**, MyXrmValue*);
+    void          (*RmDestroyDatabase)(void*);
+} X11Api;
+
+#define X11_SYM(field, name) \
+    if (!(x->field = (__typeof__(x->field))dlsym(x->lib, name))) goto fail
+
+static int loadX11(X11Api *x) {
+    memset(x, 0, sizeof(*x));
+    x->lib = dlopen("libX11.so.6", RTLD_LAZY | RTLD_LOCAL);
+    if (!x->lib) return 0;
+
+    X11_SYM(OpenDisplay,         "XOpenDisplay");
+    X11_SYM(CloseDisplay,        "XCloseDisplay");
+    X11_SYM(DefaultRootWindow,   "XDefaultRootWindow");
+    X11_SYM(DefaultScreen,       "XDefaultScreen");
+    X11_SYM(ConnectionNumber,    "XConnectionNumber");
+    X11_SYM(InternAtom,          "XInternAtom");
+    X11_SYM(GetSelectionOwner,   "XGetSelectionOwner");
+    X11_SYM(GetWindowProperty,   "XGetWindowProperty");
+    X11_SYM(Free,                "XFree");
+    X11_SYM(SelectInput,         "XSelectInput");
+    X11_SYM(Pending,             "XPending");
+    X11_SYM(NextEvent,           "XNextEvent");
+    X11_SYM(SetErrorHandler,     "XSetErrorHandler");
+    X11_SYM(RmInitialize,        "XrmInitialize");
+    X11_SYM(RmGetStringDatabase, "XrmGetStringDatabase");
+    X11_SYM(RmGetResource,       "XrmGetResource");
+    X11_SYM(RmDestroyDatabase,   "XrmDestroyDatabase");
+    return 1;
+
+fail:
+    dlclose(x->lib);
+    x->lib = NULL;
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  X error handling                                                   */
+/*  The settings owner window can vanish between two requests; the    */
+/*  resulting BadWindow must not reach Xlib's default handler, which  */
+/*  exits the process. The handler is process-wide, so errors on      */
+/*  displays we don't own are forwarded to whoever was installed      */
+/*  before us (AWT forwards unhandled errors the same way).           */
+/* ------------------------------------------------------------------ */
+static pthread_mutex_t g_errorLock = PTHREAD_MUTEX_INITIALIZER;
+static XErrorHandlerFn g_prevErrorHandler;
+static int g_errorHandlerInstalled;
+static void *volatile g_probeDisplay;
+static void *volatile g_monitorDisplay;
+
+static int ownDisplayErrorHandler(void *dpy, void *event) {
+    if (dpy && (dpy == g_probeDisplay || dpy == g_monitorDisplay)) return 0;
+    return g_prevErrorHandler ? g_prevErrorHandler(dpy, event) : 0;
+}
+
+/* Once installed, the handler stays for the life of the process, and so
+ * must libX11: the caller keeps its dlopen handle instead of closing it */
+static void installErrorHandler(X11Api *x) {
+    pthread_mutex_lock(&g_errorLock);
+    if (!g_errorHandlerInstalled) {
+        g_prevErrorHandler = x->SetErrorHandler(ownDisplayErrorHandler);
+        g_errorHandlerInstalled = 1;
+    }
+    pthread_mutex_unlock(&g_errorLock);
+}
+
+/* ------------------------------------------------------------------ */
+/*  XSETTINGS                                                          */
+/*  Reads _XSETTINGS_SETTINGS from the owner of _XSETTINGS_S<screen>  */
+/*  (the settings daemon of GNOME, Xfce, MATE, KDE's kde-gtk-config…) */
+/*  and extracts Gdk/WindowScalingFactor and Xft/DPI. See the         */
+/*  freedesktop XSETTINGS specification for the wire format.          */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    int    windowScale;  /* Gdk/WindowScalingFactor, 0 if absent   */
+    double dpi;          /* Xft/DPI (already divided by 1024), 0 if absent */
+} XSettingsValues;
+
+typedef struct {
+    const unsigned char *data;
+    unsigned long        len;
+    unsigned long        pos;
+    int                  msbFirst;
+} XSettingsReader;
+
+static int xsRead(XSettingsReader *r, unsigned long n, unsigned long *out) {
+    if (r->pos + n > r->len) return 0;
+    const unsigned char *p = r->data + r->pos;
+    unsigned long v = 0;
+    for (unsigned long i = 0; i < n; i++) {
+        unsigned long b = p[r->msbFirst ? i : n - 1 - i];
+        v = (v << 8) | b;
+    }
+    r->pos += n;
+    *out = v;
+    return 1;
+}
+
+static int xsSkip(XSettingsReader *r, unsigned long n) {
+    if (r->pos + n > r->len) return 0;
+    r->pos += n;
+    return 1;
+}
+
+#define XS_PAD(n) (((n) + 3) & ~3UL)
+
+static void parseXSettings(const unsigned char *data, unsigned long len, XSettingsValues *out) {
+    XSettingsReader r = { data, len, 0, 0 };
+    unsigned long order, count, value;
+    if (!xsRead(&r, 1, &order)) return;
+    r.msbFirst = order == 1;
+    if (!xsSkip(&r, 3 + 4) || !xsRead(&r, 4, &count)) return;  /* pad, serial */
+
+    for (unsigned long i = 0; i < count; i++) {
+        unsigned long type, nameLen;
+        if (!xsRead(&r, 1, &type) || !xsSkip(&r, 1) || !xsRead(&r, 2, &nameLen)) return;
+        const char *name = (const char *)data + r.pos;
+        if (!xsSkip(&r, XS_PAD(nameLen)) || !xsSkip(&r, 4)) return;  /* last-change serial */
+
+        switch (type) {
+        case 0: /* XSettingsTypeInteger */
+            if (!xsRead(&r, 4, &value)) return;
+            if (nameLen == 23 && memcmp(name, "Gdk/WindowScalingFactor", 23) == 0) {
+                out->windowScale = (int)(int32_t)value;
+            } else if (nameLen == 7 && memcmp(name, "Xft/DPI", 7) == 0) {
+                int32_t dpi1024 = (int32_t)value;  /* -1 means "default" */
+                if (dpi1024 > 0) out->dpi = dpi1024 / 1024.0;
+            }
+            break;
+        case 1: /* XSettingsTypeString */
+            if (!xsRead(&r, 4, &value) || !xsSkip(&r, XS_PAD(value))) return;
+            break;
+        case 2: /* XSettingsTypeColor */
+            if (!xsSkip(&r, 8)) return;
+            break;
+        default:
+            return;
+        }
+    }
+}
+
+static void readXSettings(X11Api *x, void *dpy, unsigned long owner, unsigned long settingsAtom,
+                          XSettingsValues *out) {
+    out->windowScale = 0;
+    out->dpi = 0.0;
+    if (!owner) return;
+
+    unsigned long type, nitems, after;
+    int format;
+    unsigned char *data = NULL;
+    if (x->GetWindowProperty(dpy, owner, settingsAtom, 0, 0x7fffffff, 0, settingsAtom,
+                             &type, &format, &nitems, &after, &data) == 0 && data) {
+        if (type == settingsAtom && format == 8) parseXSettings(data, nitems, out);
+        x->Free(data);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  readResourceDpi                                                    */
+/*  Reads Xft.dpi from the RESOURCE_MANAGER property of the root      */
+/*  window (what xrdb writes; KDE's fallback when no XSETTINGS owner  */
+/*  exposes Xft/DPI). Read from the property rather than the copy     */
+/*  Xlib caches at XOpenDisplay, so the monitor sees xrdb reloads.    */
+/* ------------------------------------------------------------------ */
+static double readResourceDpi(X11Api *x, void *dpy, unsigned long root, unsigned long rmAtom) {
+    unsigned long type, nitems, after;
+    int format;
+    unsigned char *data = NULL;
+    double dpi = 0.0;
+
+    if (x->GetWindowProperty(dpy, root, rmAtom, 0, 0x7fffffff, 0, MY_XA_STRING,
+                             &type, &format, &nitems, &after, &data) != 0 || !data) {
         return 0.0;
     }
 
+    /* Xlib always NUL-terminates property data */
+    x->RmInitialize();
+    void *db = x->RmGetStringDatabase((const char *)data);
+    if (db) {
+        MyXrmValue value = { 0, NULL };
+        char *rtype = NULL;
+        if (x->RmGetResource(db, "Xft.dpi", "Xft.Dpi", &rtype, &value) && value.addr) {
+            char *end;
+            double d = strtod((char *)value.addr, &end);
+            if (end != (char *)value.addr && d > 0.0) dpi = d;
+        }
+        x->RmDestroyDatabase(db);
+    }
+    x->Free(data);
+    return dpi;
+}
+
+/* Atoms and the current settings owner for one display connection */
+typedef struct {
+    unsigned long root;
+    unsigned long selection;     /* _XSETTINGS_S<screen>  */
+    unsigned long settings;      /* _XSETTINGS_SETTINGS   */
+    unsigned long manager;       /* MANAGER               */
+    unsigned long resources;     /* RESOURCE_MANAGER      */
+    unsigned long owner;
+} XScaleSource;
+
+static void initScaleSource(X11Api *x, void *dpy, XScaleSource *src) {
+    char selection[32];
+    snprintf(selection, sizeof(selection), "_XSETTINGS_S%d", x->DefaultScreen(dpy));
+    src->root      = x->DefaultRootWindow(dpy);
+    src->selection = x->InternAtom(dpy, selection, 0);
+    src->settings  = x->InternAtom(dpy, "_XSETTINGS_SETTINGS", 0);
+    src->manager   = x->InternAtom(dpy, "MANAGER", 0);
+    src->resources = x->InternAtom(dpy, "RESOURCE_MANAGER", 0);
+    src->owner     = x->GetSelectionOwner(dpy, src->selection);
+}
+
+/*
+ * Scale from the X server's settings: Gdk/WindowScalingFactor when the
+ * settings daemon publishes one, otherwise DPI / 96 from Xft/DPI or, if no
+ * XSETTINGS owner provides it, the Xft.dpi resource. *dpiOut receives the
+ * DPI that was found (0 if none).
+ */
+static double readXScale(X11Api *x, void *dpy, XScaleSource *src, double *dpiOut) {
+    XSettingsValues values;
+    readXSettings(x, dpy, src->owner, src->settings, &values);
+
+    double dpi = values.dpi > 0.0 ? values.dpi : readResourceDpi(x, dpy, src->root, src->resources);
+    if (dpiOut) *dpiOut = dpi;
+
+    if (values.windowScale > 0) return (double)values.windowScale;
+    return dpi >= 96.0 ? dpi / 96.0 : 0.0;
+}
+
+/*
+ * Connection for one-shot queries: a fresh one, or in libnucleus_linux the
+ * shared request connection (locked until releaseQueryDisplay), which the
+ * window module's commands then keep using.
+ */
+static void *openQueryDisplay(void *(*openDisplay)(const char *)) {
+#ifdef NUCLEUS_LINUX_COMBINED
+    (void)openDisplay;
+    pthread_mutex_lock(&nucleus_display_lock);
+    void *dpy = nucleus_shared_display();
+    if (!dpy) pthread_mutex_unlock(&nucleus_display_lock);
+    return dpy;
+#else
+    return openDisplay(NULL);
+#endif
+}
+
+static void releaseQueryDisplay(int (*closeDisplay)(void *), void *dpy) {
+#ifdef NUCLEUS_LINUX_COMBINED
+    (void)closeDisplay; (void)dpy;
+    pthread_mutex_unlock(&nucleus_display_lock);
+#else
+    closeDisplay(dpy);
+#endif
+}
+
+/* Connected outputs through XRandR, for readCompositorScale */
+typedef struct {
+    void         *dpy;
+    unsigned long root;
+    void         *libxrandr;   /* loaded on first use, closed by the caller */
+} OutputQuery;
+
+static void readConnectedOutputs(void *ctx, OutputNames *out) {
+    OutputQuery *query = (OutputQuery *)ctx;
+    if (!query->libxrandr) query->libxrandr = dlopen("libXrandr.so.2", RTLD_LAZY | RTLD_LOCAL);
+    if (!query->libxrandr) return;
+
+    typedef void* (*fn_XRRGetScreenResourcesCurrent)(void*, unsigned long);
+    typedef void* (*fn_XRRGetOutputInfo)(void*, void*, unsigned long);
+    typedef void  (*fn_XRRFree)(void*);
+    fn_XRRGetScreenResourcesCurrent fRes =
+        (fn_XRRGetScreenResourcesCurrent)dlsym(query->libxrandr, "XRRGetScreenResourcesCurrent");
+    fn_XRRGetOutputInfo fOutput = (fn_XRRGetOutputInfo)dlsym(query->libxrandr, "XRRGetOutputInfo");
+    fn_XRRFree fFreeRes = (fn_XRRFree)dlsym(query->libxrandr, "XRRFreeScreenResources");
+    fn_XRRFree fFreeOutput = (fn_XRRFree)dlsym(query->libxrandr, "XRRFreeOutputInfo");
+    if (!fRes || !fOutput || !fFreeRes || !fFreeOutput) return;
+
+    MyXRRScreenResources *res = (MyXRRScreenResources *)fRes(query->dpy, query->root);
+    if (!res) return;
+    for (int i = 0; i < res->noutput && out->count < OUTPUT_MAX; i++) {
+        MyXRROutputInfo *output = (MyXRROutputInfo *)fOutput(query->dpy, res, res->outputs[i]);
+        if (!output) continue;
+        /* Connected but disabled outputs are listed too (<disabled>) */
+        if (output->connection == MY_RR_CONNECTED && output->name) {
+            snprintf(out->names[out->count++], OUTPUT_NAME_MAX, "%s", output->name);
+        }
+        fFreeOutput(output);
+    }
+    fFreeRes(res);
+}
+
+/* XSETTINGS scale refined by the compositor's fractional scale; what both
+ * the one-shot probe and the settings monitor report */
+static double readRefinedXScale(X11Api *x, void *dpy, XScaleSource *src,
+                                OutputQuery *query, double *dpiOut) {
+    double scale = readXScale(x, dpy, src, dpiOut);
+    if (scale > 0.0) {
+        query->root = src->root;
+        scale = refineXScale(scale, readCompositorScale(readConnectedOutputs, query));
+    }
+    return scale;
+}
+
+/* One-shot probe for nativeGetScaleFactor */
+static double probeXScale(void) {
+    X11Api x;
+    if (!loadX11(&x)) return 0.0;
+    installErrorHandler(&x);
+
     double scale = 0.0;
-    void *dpy = fOpen(NULL);
+    void *dpy = openQueryDisplay(x.OpenDisplay);
+    OutputQuery query = { dpy, 0, NULL };
     if (dpy) {
-        char *rm = fRm(dpy);
-        if (rm) {
-            fRmInit();
-            void *db = fRmDb(rm);
-            if (db) {
-                MyXrmValue value = { 0, NULL };
-                char *type = NULL;
-                if (fRmGet(db, "Xft.dpi", "Xft.Dpi", &type, &value) && value.addr) {
-                    char *end;
-                    double dpi = strtod((char *)value.addr, &end);
-                    if (end != (char *)value.addr && dpi >= 96.0) {
-                        scale = dpi / 96.0;
-                    }
-                }
-                fRmDel(db);
-            }
+        g_probeDisplay = dpy;
+        XScaleSource src;
+        initScaleSource(&x, dpy, &src);
+        scale = readRefinedXScale(&x, dpy, &src, &query, NULL);
+        g_probeDisplay = NULL;
+        releaseQueryDisplay(x.CloseDisplay, dpy);
+    }
+    /* After closing the display, which runs RandR's close hook; in
+     * libnucleus_linux the shared connection keeps it, see nativeGetMonitorScales */
+#ifndef NUCLEUS_LINUX_COMBINED
+    if (query.libxrandr) dlclose(query.libxrandr);
+#endif
+    return scale;  /* libX11 stays loaded: see installErrorHandler */
+}
+
+/* ------------------------------------------------------------------ */
+/*  Background detection                                               */
+/*  The slow probes (libgio + GSettings, libX11 + X connection) run   */
+/*  on a native thread started by nativeStartDetection, so they       */
+/*  overlap with the application's other startup work. Results are    */
+/*  published one probe at a time: a caller only waits for the probes */
+/*  whose result can still change the answer.                          */
+/* ------------------------------------------------------------------ */
+static pthread_mutex_t g_detectLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  g_detectCond;
+static int    g_detectStarted;
+static int    g_desktopDone;
+static double g_desktopScale;
+static int    g_xDone;
+static double g_xScale;
+static int    g_xAbandoned;   /* AWT may be using Xlib: no X probe, no XInitThreads */
+
+/* awaitScaleFactor results besides a scale (and 0.0, "not detected") */
+#define SCALE_TIMEOUT  (-1.0)  /* deadline passed first */
+#define SCALE_SKIPPED  (-2.0)  /* only the X probe could answer, and it was skipped */
+
+/*
+ * Env sources that outrank the X server's settings (priority 3 and 4).
+ * The usual fractional recipe is GDK_SCALE=2 GDK_DPI_SCALE=0.75: the
+ * effective scale is their product.
+ */
+static double readGdkEnvScale(void) {
+    double scale = readEnvDouble("GDK_SCALE");
+    double dpiScale = readEnvDouble("GDK_DPI_SCALE");
+    if (scale > 0.0) return dpiScale > 0.0 ? scale * dpiScale : scale;
+    return dpiScale;
+}
+
+/* Priority 2: GSettings integer scaling (0 = automatic, left to XSETTINGS) */
+static double readDesktopScale(void) {
+    return readGnomeScaleFactor();
+}
+
+static void publishProbe(int *done, double *slot, double scale) {
+    pthread_mutex_lock(&g_detectLock);
+    *slot = scale;
+    *done = 1;
+    pthread_cond_broadcast(&g_detectCond);
+    pthread_mutex_unlock(&g_detectLock);
+}
+
+/* AWT's X toolkit is up (or coming up) once it has loaded libawt_xawt */
+static int awtXToolkitLoaded(void) {
+    void *xawt = dlopen("libawt_xawt.so", RTLD_LAZY | RTLD_NOLOAD);
+    if (!xawt) return 0;
+    dlclose(xawt);
+    return 1;
+}
+
+/* Called by every entry point outside the startup path (monitor scales,
+ * settings monitor, a timed-out await): from then on AWT may be up */
+static void abandonXProbe(void) {
+    pthread_mutex_lock(&g_detectLock);
+    g_xAbandoned = 1;
+    pthread_mutex_unlock(&g_detectLock);
+}
+
+/*
+ * Xlib is only thread-safe after XInitThreads, which must precede every
+ * other Xlib call in the process. The probe therefore only starts while
+ * the application is still on its startup path: nothing but
+ * nativeStartDetection / the scale queries has run (see abandonXProbe) and
+ * AWT's X toolkit is not loaded. Checking under g_detectLock makes the
+ * check and the call atomic with respect to abandonXProbe.
+ * Returns 1 if the probe may run.
+ */
+static int beginXProbe(void) {
+    static void *libx11;   /* kept loaded, like the probe's own handle */
+    pthread_mutex_lock(&g_detectLock);
+    if (!g_xAbandoned && awtXToolkitLoaded()) g_xAbandoned = 1;
+    int go = !g_xAbandoned;
+    if (go && !libx11) {
+        libx11 = dlopen("libX11.so.6", RTLD_LAZY | RTLD_LOCAL);
+        void (*initThreads)(void) = libx11 ? (void (*)(void))dlsym(libx11, "XInitThreads") : NULL;
+        if (initThreads) initThreads();
+    }
+    pthread_mutex_unlock(&g_detectLock);
+    return go;
+}
+
+static void *detectThread(void *arg) {
+    (void)arg;
+    NucleusStatsScope probe = nucleus_stats_begin_startup(PROBE_DETECT_DESKTOP_SCALE);
+    double desktop = readDesktopScale();
+    nucleus_stats_end(&probe);
+    publishProbe(&g_desktopDone, &g_desktopScale, desktop);
+
+    /* The X server is only consulted when nothing above it answered */
+    double x = 0.0;
+    if (desktop <= 0.0 && readGdkEnvScale() <= 0.0) {
+        if (beginXProbe()) {
+            probe = nucleus_stats_begin_startup(PROBE_DETECT_X_SCALE);
+            x = probeXScale();
+            nucleus_stats_end(&probe);
+        } else {
+            x = SCALE_SKIPPED;
         }
-        fClose(dpy);
     }
+    publishProbe(&g_xDone, &g_xScale, x);
+    return NULL;
+}
 
-    dlclose(libx11);
+/* Idempotent. Falls back to probing on the caller's thread (see
+ * awaitProbe) if the thread cannot be created. */
+static void startDetection(void) {
+    pthread_mutex_lock(&g_detectLock);
+    if (!g_detectStarted) {
+        g_detectStarted = 1;
+        pthread_condattr_t attr;
+        pthread_condattr_init(&attr);
+        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+        pthread_cond_init(&g_detectCond, &attr);
+        pthread_condattr_destroy(&attr);
+
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, detectThread, NULL) == 0) {
+            pthread_detach(thread);
+        } else {
+            g_detectStarted = -1;
+        }
+    }
+    pthread_mutex_unlock(&g_detectLock);
+}
+
+/* Waits until *done or the deadline (CLOCK_MONOTONIC, NULL = forever).
+ * Returns 1 when the probe finished. Caller holds g_detectLock. */
+static int awaitProbe(const int *done, const struct timespec *deadline) {
+    while (!*done) {
+        if (!deadline) {
+            pthread_cond_wait(&g_detectCond, &g_detectLock);
+        } else if (pthread_cond_timedwait(&g_detectCond, &g_detectLock, deadline) == ETIMEDOUT) {
+            return *done;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Resolves the scale in JBR's priority order, waiting at most until the
+ * deadline for the background probes. Returns SCALE_TIMEOUT on timeout,
+ * SCALE_SKIPPED when the X probe was needed but skipped.
+ */
+static double awaitScaleFactor(const struct timespec *deadline) {
+    /* 1. Explicit JVM override — highest priority, never waits */
+    double scale = readEnvDouble("J2D_UISCALE");
+    if (scale > 0.0) return scale;
+
+    startDetection();
+    if (g_detectStarted < 0) {
+        /* No thread: probe synchronously, as before */
+        scale = readDesktopScale();
+        if (scale <= 0.0) scale = readGdkEnvScale();
+        if (scale <= 0.0) scale = probeXScale();
+        return scale;
+    }
+
+    pthread_mutex_lock(&g_detectLock);
+    scale = SCALE_TIMEOUT;
+    if (awaitProbe(&g_desktopDone, deadline)) {
+        /* 2. GSettings integer scaling */
+        if (g_desktopScale > 0.0) {
+            scale = g_desktopScale;
+        } else {
+            /* 3./4. GDK_SCALE × GDK_DPI_SCALE — no need to wait for X */
+            scale = readGdkEnvScale();
+            /* 5. XSETTINGS (Gdk/WindowScalingFactor, Xft/DPI), then Xft.dpi,
+             *    refined by Mutter/KWin's fractional scale;
+             *    0.0 = not detected, let the JVM use its own detection */
+            if (scale <= 0.0) scale = awaitProbe(&g_xDone, deadline) ? g_xScale : SCALE_TIMEOUT;
+        }
+    }
+    /* AWT may start next: an X probe that has not begun must not start */
+    if (scale == SCALE_TIMEOUT) g_xAbandoned = 1;
+    pthread_mutex_unlock(&g_detectLock);
     return scale;
 }
 
+/* System.getProperty(key) into buf ("" if unset); 0 on JNI failure */
+static int readSystemProperty(JNIEnv *env, const char *key, char *buf, size_t size) {
+    int ok = 0;
+    buf[0] = '\0';
+    jclass system = (*env)->FindClass(env, "java/lang/System");
+    if (!system) goto done;
+    jmethodID getProperty = (*env)->GetStaticMethodID(
+        env, system, "getProperty", "(Ljava/lang/String;)Ljava/lang/String;");
+    if (!getProperty) goto done;
+    jstring jkey = (*env)->NewStringUTF(env, key);
+    if (!jkey) goto done;
+    jstring value = (jstring)(*env)->CallStaticObjectMethod(env, system, getProperty, jkey);
+    if ((*env)->ExceptionCheck(env)) goto done;
+    if (value) {
+        const char *chars = (*env)->GetStringUTFChars(env, value, NULL);
+        if (!chars) goto done;
+        snprintf(buf, size, "%s", chars);
+        (*env)->ReleaseStringUTFChars(env, value, chars);
+    }
+    ok = 1;
+done:
+    if ((*env)->ExceptionCheck(env)) (*env)->ExceptionClear(env);
+    return ok;
+}
+
+/*
+ * Detection does not start here: the library may be loaded after AWT is up
+ * (monitor scales, scale listeners), when XInitThreads is no longer legal.
+ * nativeStartDetection starts it from the application's startup path.
+ */
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
+    (void)vm; (void)reserved;
+    NUCLEUS_STATS_STARTUP_SCOPE(PROBE_ON_LOAD);
+    return JNI_VERSION_1_6;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeStartDetection — JNI entry point                            */
+/*  Starts the background probes without waiting for them, unless     */
+/*  J2D_UISCALE makes them pointless. Idempotent.                      */
+/* ------------------------------------------------------------------ */
+JNIEXPORT void JNICALL
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeStartDetection(
+    JNIEnv *env, jclass clazz)
+{
+    (void)env; (void)clazz;
+    NUCLEUS_STATS_SCOPE(PROBE_START_DETECTION);
+    if (readEnvDouble("J2D_UISCALE") <= 0.0) startDetection();
+}
+
 /* ------------------------------------------------------------------ */
 /*  nativeGetScaleFactor — JNI entry point                            */
+/*  Blocks until detection completes. Returns SCALE_SKIPPED when only  */
+/*  the X probe could answer and AWT's use of Xlib ruled it out.       */
 /* ------------------------------------------------------------------ */
 JNIEXPORT jdouble JNICALL
 Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeGetScaleFactor(
     JNIEnv *env, jclass clazz)
 {
     (void)env; (void)clazz;
-    double scale;
+    NUCLEUS_STATS_SCOPE(PROBE_GET_SCALE_FACTOR);
+    return (jdouble)awaitScaleFactor(NULL);
+}
 
-    /* 1. Explicit JVM override — highest priority */
-    scale = readEnvDouble("J2D_UISCALE");
-    if (scale > 0.0) return (jdouble)scale;
+/* ------------------------------------------------------------------ */
+/*  nativeAwaitScaleFactor — JNI entry point                          */
+/*  Like nativeGetScaleFactor, but gives up after timeoutMillis and   */
+/*  returns SCALE_TIMEOUT (a probe in progress keeps running; a later */
+/*  call may succeed).                                                 */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jdouble JNICALL
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeAwaitScaleFactor(
+    JNIEnv *env, jclass clazz, jlong timeoutMillis)
+{
+    (void)env; (void)clazz;
+    NUCLEUS_STATS_SCOPE(PROBE_AWAIT_SCALE_FACTOR);
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    if (timeoutMillis < 0) timeoutMillis = 0;
+    deadline.tv_sec += (time_t)(timeoutMillis / 1000);
+    deadline.tv_nsec += (long)(timeoutMillis % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    double scale = awaitScaleFactor(&deadline);
+    if (scale == SCALE_TIMEOUT) NUCLEUS_STATS_FAIL();
+    return (jdouble)scale;
+}
 
-    /* 2. GNOME GSettings integer scaling */
-    scale = readGnomeScaleFactor();
-    if (scale > 0.0) return (jdouble)scale;
+/* ------------------------------------------------------------------ */
+/*  nativeApplyScaleToEnv                                              */
+/*  Exports the scale through the environment variable that the       */
+/*  running JDK's native X11GraphicsDevice.getNativeScaleFactor()     */
+/*  reads, so that both rendering AND mouse event coordinates are     */
+/*  scaled (XWindow.scaleDown) — the debug sun.java2d.uiScale path    */
+/*  alone does not guarantee the latter.                               */
+/*                                                                     */
+/*  OpenJDK (and GraalVM) read integer GDK_SCALE / J2D_UISCALE values */
+/*  only: a fractional scale there is rounded to the nearest integer, */
+/*  the only factor its X11 pipeline can apply to input as well.      */
+/*  JetBrains Runtime reads J2D_UISCALE as a double, so fractional     */
+/*  scales are exported unchanged.                                     */
+/*                                                                     */
+/*  Returns the APPLY_* path taken. Uses setenv(..., 0) to avoid      */
+/*  overriding a value already set by the desktop session.            */
+/* ------------------------------------------------------------------ */
+#define APPLY_NONE              0  /* scale <= 1, nothing to export        */
+#define APPLY_GDK_SCALE         1  /* integral scale via GDK_SCALE          */
+#define APPLY_J2D_UISCALE       2  /* fractional scale via J2D_UISCALE      */
+#define APPLY_GDK_SCALE_ROUNDED 3  /* fractional, rounded for an int-only JDK */
 
-    /* 3. GDK_SCALE — set by GNOME session / GTK apps */
-    scale = readEnvDouble("GDK_SCALE");
-    if (scale > 0.0) return (jdouble)scale;
+static int runtimeSupportsFractionalScale(JNIEnv *env) {
+    char vendor[128];
+    if (!readSystemProperty(env, "java.vm.vendor", vendor, sizeof(vendor))) return 0;
+    return strstr(vendor, "JetBrains") != NULL;
+}
 
-    /* 4. GDK_DPI_SCALE — fractional DPI multiplier */
-    scale = readEnvDouble("GDK_DPI_SCALE");
-    if (scale > 0.0) return (jdouble)scale;
+JNIEXPORT jint JNICALL
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeApplyScaleToEnv(
+    JNIEnv *env, jclass clazz, jdouble scale)
+{
+    (void)clazz;
+    NUCLEUS_STATS_SCOPE(PROBE_APPLY_SCALE_TO_ENV);
+    char buf[32];
+    double integral = (double)(int)(scale + 0.5);
+    int isIntegral = scale - integral < 0.01 && integral - scale < 0.01;
 
-    /* 5. Xft.dpi from X Resource Manager */
-    scale = readXftScale();
-    if (scale > 0.0) return (jdouble)scale;
+    if (!isIntegral && runtimeSupportsFractionalScale(env)) {
+        if (scale <= 1.0) return APPLY_NONE;
+        snprintf(buf, sizeof(buf), "%.4g", scale);
+        setenv("J2D_UISCALE", buf, 0);
+        return APPLY_J2D_UISCALE;
+    }
 
-    return 0.0; /* not detected; let the JVM use its own detection */
+    /* 0 = don't overwrite if already set by the desktop session */
+    if (integral > 1.0) {
+        snprintf(buf, sizeof(buf), "%d", (int)integral);
+        setenv("GDK_SCALE", buf, 0);
+    }
+    if (!isIntegral) return APPLY_GDK_SCALE_ROUNDED;
+    return integral > 1.0 ? APPLY_GDK_SCALE : APPLY_NONE;
 }
 
 /* ------------------------------------------------------------------ */
-/*  nativeApplyScaleToEnv                                              */
-/*  Sets GDK_SCALE in the process environment so that the JDK's       */
-/*  native X11GraphicsDevice.getNativeScaleFactor() detects the scale  */
-/*  through the standard path (not the debug sun.java2d.uiScale path). */
-/*  This ensures both rendering AND mouse event coordinates are        */
-/*  properly scaled by the JDK's XWindow.scaleDown() calls.            */
-/*  Uses setenv(..., 0) to avoid overriding a value already set        */
-/*  by the desktop session.                                            */
+/*  deriveMonitorScale                                                 */
+/*  Physical DPI / 96, snapped to quarter steps like the scale values */
+/*  desktop environments offer. 0.0 when the EDID size is missing or  */
+/*  implausible (projectors, VMs, aspect-ratio-only EDIDs).            */
 /* ------------------------------------------------------------------ */
+static double deriveMonitorScale(unsigned int px, unsigned long mm) {
+    if (px == 0 || mm < 100) return 0.0;
+    double dpi = (double)px * 25.4 / (double)mm;
+    if (dpi < 50.0 || dpi > 600.0) return 0.0;
+    double scale = (double)(int)(dpi / 96.0 * 4.0 + 0.5) / 4.0;
+    return scale < 1.0 ? 1.0 : scale;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeGetMonitorScales — JNI entry point                          */
+/*  Returns MONITOR_RECORD_SIZE doubles per connected, active output: */
+/*    { x, y, width, height, mmWidth, mmHeight, scale, primary }       */
+/*  Geometry is in X screen pixels; scale is 0.0 when unknown.        */
+/*  Returns null when libX11/libXrandr or the display is unavailable. */
+/* ------------------------------------------------------------------ */
+#define MONITOR_RECORD_SIZE 8
+#define MONITOR_MAX 32
+
+JNIEXPORT jdoubleArray JNICALL
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeGetMonitorScales(
+    JNIEnv *env, jclass clazz)
+{
+    (void)clazz;
+    NUCLEUS_STATS_SCOPE(PROBE_GET_MONITOR_SCALES);
+    abandonXProbe();  /* typically called with AWT up */
+    void *libx11 = dlopen("libX11.so.6", RTLD_LAZY | RTLD_LOCAL);
+    if (!libx11) {
+        NUCLEUS_STATS_FAIL();
+        return NULL;
+    }
+    void *libxrandr = dlopen("libXrandr.so.2", RTLD_LAZY | RTLD_LOCAL);
+    if (!libxrandr) {
+        dlclose(libx11);
+        NUCLEUS_STATS_FAIL();
+        return NULL;
+    }
+
+    typedef void*         (*fn_XOpenDisplay)(const char*);
+    typedef int           (*fn_XCloseDisplay)(void*);
+    typedef unsigned long (*fn_XDefaultRootWindow)(void*);
+    typedef void*         (*fn_XRRGetScreenResourcesCurrent)(void*, unsigned long);
+    typedef void*         (*fn_XRRGetOutputInfo)(void*, void*, unsigned long);
+    typedef void*         (*fn_XRRGetCrtcInfo)(void*, void*, unsigned long);
+    typedef unsigned long (*fn_XRRGetOutputPrimary)(void*, unsigned long);
+    typedef void          (*fn_XRRFree)(void*);
+
+    fn_XOpenDisplay                 fOpen   = (fn_XOpenDisplay)dlsym(libx11, "XOpenDisplay");
+    fn_XCloseDisplay                fClose  = (fn_XCloseDisplay)dlsym(libx11, "XCloseDisplay");
+    fn_XDefaultRootWindow           fRoot   = (fn_XDefaultRootWindow)dlsym(libx11, "XDefaultRootWindow");
+    fn_XRRGetScreenResourcesCurrent fRes    = (fn_XRRGetScreenResourcesCurrent)dlsym(libxrandr, "XRRGetScreenResourcesCurrent");
+    fn_XRRGetOutputInfo             fOutput = (fn_XRRGetOutputInfo)dlsym(libxrandr, "XRRGetOutputInfo");
+    fn_XRRGetCrtcInfo               fCrtc   = (fn_XRRGetCrtcInfo)dlsym(libxrandr, "XRRGetCrtcInfo");
+    fn_XRRGetOutputPrimary          fPrim   = (fn_XRRGetOutputPrimary)dlsym(libxrandr, "XRRGetOutputPrimary");
+    fn_XRRFree                      fFreeRes    = (fn_XRRFree)dlsym(libxrandr, "XRRFreeScreenResources");
+    fn_XRRFree                      fFreeOutput = (fn_XRRFree)dlsym(libxrandr, "XRRFreeOutputInfo");
+    fn_XRRFree                      fFreeCrtc   = (fn_XRRFree)dlsym(libxrandr, "XRRFreeCrtcInfo");
+
+    jdoubleArray result = NULL;
+    void *dpy = NULL;
+    if (fOpen && fClose && fRoot && fRes && fOutput && fCrtc && fPrim &&
+        fFreeRes && fFreeOutput && fFreeCrtc) {
+        dpy = openQueryDisplay(fOpen);
+    }
+
+    if (dpy) {
+        unsigned long root = fRoot(dpy);
+        MyXRRScreenResources *res = (MyXRRScreenResources *)fRes(dpy, root);
+        if (res) {
+            unsigned long primary = fPrim(dpy, root);
+            jdouble records[MONITOR_MAX * MONITOR_RECORD_SIZE];
+            int count = 0;
+
+            for (int i = 0; i < res->noutput && count < MONITOR_MAX; i++) {
+                MyXRROutputInfo *output = (MyXRROutputInfo *)fOutput(dpy, res, res->outputs[i]);
+                if (!output) continue;
+                /* Disconnected or disabled outputs have no CRTC */
+                if (output->connection == MY_RR_CONNECTED && output->crtc) {
+                    MyXRRCrtcInfo *crtc = (MyXRRCrtcInfo *)fCrtc(dpy, res, output->crtc);
+                    if (crtc && crtc->width > 0 && crtc->height > 0) {
+                        /* The EDID size is unrotated; the CRTC size is not */
+                        unsigned long mmW = output->mm_width;
+                        unsigned long mmH = output->mm_height;
+                        if (crtc->rotation & (MY_RR_ROTATE_90 | MY_RR_ROTATE_270)) {
+                            unsigned long t = mmW; mmW = mmH; mmH = t;
+                        }
+                        jdouble *r = &records[count * MONITOR_RECORD_SIZE];
+                        r[0] = crtc->x;
+                        r[1] = crtc->y;
+                        r[2] = crtc->width;
+                        r[3] = crtc->height;
+                        r[4] = (jdouble)mmW;
+                        r[5] = (jdouble)mmH;
+                        r[6] = deriveMonitorScale(crtc->width, mmW);
+                        r[7] = res->outputs[i] == primary ? 1.0 : 0.0;
+                        count++;
+                    }
+                    if (crtc) fFreeCrtc(crtc);
+                }
+                fFreeOutput(output);
+            }
+            fFreeRes(res);
+
+            jsize length = count * MONITOR_RECORD_SIZE;
+            result = (*env)->NewDoubleArray(env, length);
+            if (result && length > 0) {
+                (*env)->SetDoubleArrayRegion(env, result, 0, length, records);
+            }
+        }
+        releaseQueryDisplay(fClose, dpy);
+    }
+
+    /* In libnucleus_linux the shared connection outlives this call and keeps
+     * RandR's extension hooks, so libXrandr stays loaded there */
+#ifndef NUCLEUS_LINUX_COMBINED
+    dlclose(libxrandr);
+#endif
+    dlclose(libx11);
+    return NUCLEUS_STATS_RESULT(result);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Settings monitor                                                   */
+/*  A thread with its own X connection selects PropertyNotify on the  */
+/*  XSETTINGS owner and on the root window (RESOURCE_MANAGER), and    */
+/*  follows owner changes through the MANAGER client message and      */
+/*  DestroyNotify. Changes are reported to the static Java method     */
+/*  HiDpiLinuxBridge.onScaleChanged(double scale, double dpi).        */
+/*  The starter opens the connection and waits until the thread is    */
+/*  attached to the JVM, so a monitor that is reported started runs.  */
+/* ------------------------------------------------------------------ */
+static pthread_mutex_t g_monitorLock = PTHREAD_MUTEX_INITIALIZER;
+static struct MonitorRun *g_monitorRun;
+static JavaVM *g_jvm;
+static jclass g_bridgeClass;
+static jmethodID g_onScaleChanged;
+
+/* One monitor thread, its connection and wake-up pipe. Owned by the
+ * stopper, or by the thread itself when a listener stops observing from
+ * within its callback. */
+typedef struct MonitorRun {
+    pthread_t   thread;
+    X11Api      x;
+    void       *dpy;
+    int         wake[2];
+    sem_t       attached;      /* posted once attachOk is set */
+    int         attachOk;
+    int         selfStopped;
+    atomic_int  exited;        /* the thread is gone (server lost, or attach failed) */
+} MonitorRun;
+
+static void freeMonitorRun(MonitorRun *run) {
+    close(run->wake[0]);
+    close(run->wake[1]);
+    sem_destroy(&run->attached);
+    free(run);
+}
+
+/* Follows the current settings owner; 0 when no settings daemon runs */
+static void watchSettingsOwner(X11Api *x, void *dpy, XScaleSource *src) {
+    src->owner = x->GetSelectionOwner(dpy, src->selection);
+    if (src->owner) {
+        x->SelectInput(dpy, src->owner, MY_PROPERTY_CHANGE_MASK | MY_STRUCTURE_NOTIFY_MASK);
+    }
+}
+
+static int handleMonitorEvent(X11Api *x, void *dpy, XScaleSource *src, MyXEvent *ev) {
+    switch (ev->type) {
+    case MY_PROPERTY_NOTIFY:
+        return (ev->xproperty.window == src->owner && ev->xproperty.atom == src->settings) ||
+               (ev->xproperty.window == src->root && ev->xproperty.atom == src->resources);
+    case MY_CLIENT_MESSAGE:
+        /* A new settings daemon announces itself on the root window */
+        if (ev->xclient.message_type == src->manager &&
+            (unsigned long)ev->xclient.l[1] == src->selection) {
+            watchSettingsOwner(x, dpy, src);
+            return 1;
+        }
+        return 0;
+    case MY_DESTROY_NOTIFY:
+        if (ev->xdestroywindow.window == src->owner) {
+            watchSettingsOwner(x, dpy, src);
+            return 1;
+        }
+        return 0;
+    default:
+        return 0;
+    }
+}
+
+static void *monitorThread(void *arg) {
+    MonitorRun *run = (MonitorRun *)arg;
+    JNIEnv *env = NULL;
+    run->attachOk = (*g_jvm)->AttachCurrentThreadAsDaemon(g_jvm, (void **)&env, NULL) == JNI_OK;
+    int attachOk = run->attachOk;
+    sem_post(&run->attached);
+    if (!attachOk) {
+        /* The starter closes the connection and frees the run */
+        atomic_store(&run->exited, 1);
+        return NULL;
+    }
+
+    X11Api *x = &run->x;
+    void *dpy = run->dpy;
+    XScaleSource src;
+    initScaleSource(x, dpy, &src);
+    x->SelectInput(dpy, src.root, MY_PROPERTY_CHANGE_MASK | MY_STRUCTURE_NOTIFY_MASK);
+    watchSettingsOwner(x, dpy, &src);
+
+    /* libXrandr, if Mutter's outputs are read, stays loaded for the run */
+    OutputQuery query = { dpy, src.root, NULL };
+    double lastDpi = 0.0;
+    double lastScale = readRefinedXScale(x, dpy, &src, &query, &lastDpi);
+
+    struct pollfd fds[2];
+    fds[0].fd = x->ConnectionNumber(dpy);
+    fds[0].events = POLLIN;
+    fds[1].fd = run->wake[0];
+    fds[1].events = POLLIN;
+
+    /* Work done for one wakeup: from poll() returning to the next poll() */
+    NucleusStatsScope wakeup = { PROBE_MONITOR_WAKEUP, 0, 0 };
+    for (;;) {
+        int dirty = 0;
+        while (x->Pending(dpy) > 0) {
+            MyXEvent ev;
+            x->NextEvent(dpy, &ev);
+            dirty |= handleMonitorEvent(x, dpy, &src, &ev);
+        }
+
+        if (dirty) {
+            double dpi = 0.0;
+            double scale = readRefinedXScale(x, dpy, &src, &query, &dpi);
+            if (scale != lastScale || dpi != lastDpi) {
+                lastScale = scale;
+                lastDpi = dpi;
+                (*env)->CallStaticVoidMethod(env, g_bridgeClass, g_onScaleChanged,
+                                             (jdouble)scale, (jdouble)dpi);
+                if ((*env)->ExceptionCheck(env)) {
+                    (*env)->ExceptionClear(env);
+                    wakeup.failed = 1;
+                }
+            }
+        }
+
+        fds[0].revents = fds[1].revents = 0;
+        nucleus_stats_end(&wakeup);
+        if (poll(fds, 2, -1) < 0) continue;  /* EINTR */
+        wakeup = nucleus_stats_begin(PROBE_MONITOR_WAKEUP);
+        if (fds[1].revents) break;
+        if (fds[0].revents & (POLLERR | POLLHUP)) {
+            wakeup.failed = 1;
+            break;  /* server gone */
+        }
+    }
+    nucleus_stats_end(&wakeup);
+
+    /* A newer monitor may own the slot already */
+    __sync_bool_compare_and_swap(&g_monitorDisplay, dpy, NULL);
+    x->CloseDisplay(dpy);
+    /* After closing the display, which runs RandR's close hook */
+    if (query.libxrandr) dlclose(query.libxrandr);
+    (*g_jvm)->DetachCurrentThread(g_jvm);
+    int selfStopped = run->selfStopped;
+    atomic_store(&run->exited, 1);
+    if (selfStopped) freeMonitorRun(run);
+    return NULL;
+}
+
+/* Opens the connection and starts a monitor thread on it; NULL when the
+ * X display is unavailable or the thread could not attach. */
+static MonitorRun *startMonitor(void) {
+    MonitorRun *run = (MonitorRun *)calloc(1, sizeof(MonitorRun));
+    if (!run) return NULL;
+    if (!loadX11(&run->x)) {
+        free(run);
+        return NULL;
+    }
+    installErrorHandler(&run->x);
+    run->dpy = run->x.OpenDisplay(NULL);
+    if (!run->dpy) {
+        free(run);
+        return NULL;
+    }
+    if (pipe(run->wake) != 0) {
+        run->x.CloseDisplay(run->dpy);
+        free(run);
+        return NULL;
+    }
+    sem_init(&run->attached, 0, 0);
+    g_monitorDisplay = run->dpy;
+
+    int started = pthread_create(&run->thread, NULL, monitorThread, run) == 0;
+    if (started) {
+        while (sem_wait(&run->attached) != 0 && errno == EINTR) {
+        }
+        if (!run->attachOk) {
+            pthread_join(run->thread, NULL);
+            started = 0;
+        }
+    }
+    if (!started) {
+        __sync_bool_compare_and_swap(&g_monitorDisplay, run->dpy, NULL);
+        run->x.CloseDisplay(run->dpy);
+        freeMonitorRun(run);
+        return NULL;
+    }
+    return run;
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeStartObserving / nativeStopObserving — JNI entry points     */
+/*  Neither holds g_monitorLock while joining a thread: a listener may */
+/*  start or stop observing from within its callback.                  */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeStartObserving(
+    JNIEnv *env, jclass clazz)
+{
+    NUCLEUS_STATS_SCOPE(PROBE_START_OBSERVING);
+    abandonXProbe();  /* typically called with AWT up */
+    jboolean started = JNI_FALSE;
+    MonitorRun *dead = NULL;
+    pthread_mutex_lock(&g_monitorLock);
+    if (g_monitorRun && !atomic_load(&g_monitorRun->exited)) {
+        started = JNI_TRUE;
+        goto done;
+    }
+    /* The previous monitor lost its server: replace it */
+    dead = g_monitorRun;
+    g_monitorRun = NULL;
+
+    if (!g_bridgeClass) {
+        g_onScaleChanged = (*env)->GetStaticMethodID(env, clazz, "onScaleChanged", "(DD)V");
+        if (!g_onScaleChanged) {
+            (*env)->ExceptionClear(env);
+            goto done;
+        }
+        (*env)->GetJavaVM(env, &g_jvm);
+        g_bridgeClass = (jclass)(*env)->NewGlobalRef(env, clazz);
+    }
+
+    g_monitorRun = startMonitor();
+    started = g_monitorRun ? JNI_TRUE : JNI_FALSE;
+
+done:
+    pthread_mutex_unlock(&g_monitorLock);
+    if (dead) {
+        pthread_join(dead->thread, NULL);  /* already exited */
+        freeMonitorRun(dead);
+    }
+    return NUCLEUS_STATS_RESULT(started);
+}
+
 JNIEXPORT void JNICALL
-Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeApplyScaleToEnv(
-    JNIEnv *env, jclass clazz, jint scale)
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeStopObserving(
+    JNIEnv *env, jclass clazz)
 {
     (void)env; (void)clazz;
-    if (scale <= 1) return;
+    NUCLEUS_STATS_SCOPE(PROBE_STOP_OBSERVING);
+    pthread_mutex_lock(&g_monitorLock);
+    MonitorRun *run = g_monitorRun;
+    g_monitorRun = NULL;
+    if (run) {
+        char b = 1;
+        ssize_t n = write(run->wake[1], &b, 1);
+        (void)n;
+        if (pthread_equal(pthread_self(), run->thread)) {
+            /* Called from a listener: the thread exits after this callback */
+            run->selfStopped = 1;
+            pthread_detach(run->thread);
+            run = NULL;
+        }
+    }
+    pthread_mutex_unlock(&g_monitorLock);
 
-    char buf[16];
-    snprintf(buf, sizeof(buf), "%d", (int)scale);
+    if (run) {
+        pthread_join(run->thread, NULL);
+        freeMonitorRun(run);
+    }
+}
 
-    /* 0 = don't overwrite if already set by the desktop session */
-    setenv("GDK_SCALE", buf, 0);
+/* ------------------------------------------------------------------ */
+/*  nativeGetStats / nativeSetStatsEnabled — JNI entry points         */
+/*  Call statistics, NUCLEUS_STATS_FIELDS longs per PROBE_*, see       */
+/*  nucleus_native_stats.h.                                            */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jlongArray JNICALL
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeGetStats(
+    JNIEnv *env, jclass clazz)
+{
+    (void)clazz;
+    return nucleus_stats_to_java(env);
+}
+
+JNIEXPORT void JNICALL
+Java_io_github_kdroidfilter_nucleus_hidpi_HiDpiLinuxBridge_nativeSetStatsEnabled(
+    JNIEnv *env, jclass clazz, jboolean enabled)
+{
+    (void)env; (void)clazz;
+    nucleus_stats_set_enabled(enabled);
 }
@@ -0,0 +1,96 @@
+import org.apache.tools.ant.taskdefs.condition.Os
+import org.jetbrains.kotlin.gradle.dsl.JvmTarget
+
+plugins {
+    kotlin("jvm")
+    alias(libs.plugins.vanniktechMavenPublish)
+}
+
+val publishVersion =
+    providers
+        .environmentVariable("GITHUB_REF")
+        .orNull
+        ?.removePrefix("refs/tags/v")
+        ?: "1.0.0"
+
+java {
+    sourceCompatibility = JavaVersion.VERSION_11
+    targetCompatibility = JavaVersion.VERSION_11
+}
+
+kotlin {
+    compilerOptions {
+        jvmTarget.set(JvmTarget.JVM_11)
+    }
+}
+
+val buildNativeLinux by tasks.registering(Exec::class) {
+    description = "Links the Linux theme, window and HiDPI JNI bridges into libnucleus_linux.so (x64 + aarch64)"
+    group = "build"
+    val nativeDir = file("src/main/native/linux")
+    val outputDir = file("src/main/resources/nucleus/native")
+    val checkX64 = File(outputDir, "linux-x64/libnucleus_linux.so")
+    val checkArm = File(outputDir, "linux-aarch64/libnucleus_linux.so")
+    onlyIf {
+        Os.isFamily(Os.FAMILY_UNIX) &&
+            !Os.isFamily(Os.FAMILY_MAC) &&
+            !checkX64.exists() &&
+            !checkArm.exists()
+    }
+    inputs.dir(nativeDir)
+    inputs.file(rootProject.file("darkmode-detector/src/main/native/linux/nucleus_linux_theme.c"))
+    inputs.file(rootProject.file("decorated-window-jni/src/main/native/linux/nucleus_linux_window.c"))
+    inputs.file(rootProject.file("linux-hidpi/src/main/native/linux/nucleus_hidpi_linux.c"))
+    inputs.dir(rootProject.file("core-runtime/src/main/native/include"))
+    outputs.dir(outputDir)
+    workingDir(nativeDir)
+    commandLine("bash", "build.sh")
+}
+
+tasks.processResources {
+    dependsOn(buildNativeLinux)
+}
+
+tasks.configureEach {
+    if (name == "sourcesJar") {
+        dependsOn(buildNativeLinux)
+    }
+}
+
+mavenPublishing {
+    coordinates("io.github.kdroidfilter", "nucleus.linux-native", publishVersion)
+
+    pom {
+        name.set("Nucleus Linux Native")
+        description.set(
+            "Single combined Linux JNI library for the Nucleus theme, decorated window and HiDPI modules",
+        )
+        url.set("https://github.com/kdroidFilter/Nucleus")
+
+        licenses {
+            license {
+                name.set("MIT License")
+                url.set("https://opensource.org/licenses/MIT")
+            }
+        }
+
+        developers {
+            developer {
+                id.set("kdroidfilter")
+                name.set("kdroidFilter")
+                url.set("https://github.com/kdroidFilter")
+            }
+        }
+
+        scm {
+            url.set("https://github.com/kdroidFilter/Nucleus")
+            connection.set("scm:git:git://github.com/kdroidFilter/Nucleus.git")
+            developerConnection.set("scm:git:ssh://git@github.com/kdroidFilter/Nucleus.git")
+        }
+    }
+
+    publishToMavenCentral()
+    if (project.hasProperty("signingInMemoryKey")) {
+        signAllPublications()
+    }
+}
@@ -0,0 +1,113 @@
+#!/bin/bash
+# Compiles libnucleus_linux.so, the theme, window and HiDPI JNI bridges linked into one
+# shared library, for the host architecture (plus the other one when a cross compiler is
+# available). The bridge sources are taken from their modules and built with
+# -DNUCLEUS_LINUX_COMBINED; the outputs are placed in this module's JAR resources.
+#
+# Prerequisites: gcc, libX11-dev + libXext-dev, libdbus-1-dev, JDK with JNI headers.
+# Usage: ./build.sh
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+ROOT_DIR="$(cd "$SCRIPT_DIR/../../../../.." && pwd)"
+SRCS=(
+    "$SCRIPT_DIR/nucleus_linux.c"
+    "$ROOT_DIR/darkmode-detector/src/main/native/linux/nucleus_linux_theme.c"
+    "$ROOT_DIR/decorated-window-jni/src/main/native/linux/nucleus_linux_window.c"
+    "$ROOT_DIR/linux-hidpi/src/main/native/linux/nucleus_hidpi_linux.c"
+)
+RESOURCE_DIR="$SCRIPT_DIR/../../resources/nucleus/native"
+OUT_DIR_X64="$RESOURCE_DIR/linux-x64"
+OUT_DIR_AARCH64="$RESOURCE_DIR/linux-aarch64"
+LIB_NAME="libnucleus_linux.so"
+
+# Detect JAVA_HOME for JNI headers
+if [ -z "${JAVA_HOME:-}" ]; then
+    for jdk in /usr/lib/jvm/java-*-openjdk-* /usr/lib/jvm/default-java; do
+        if [ -d "$jdk/include" ]; then
+            JAVA_HOME="$jdk"
+            break
+        fi
+    done
+fi
+if [ -z "${JAVA_HOME:-}" ]; then
+    echo "ERROR: JAVA_HOME not set and could not auto-detect a JDK." >&2
+    exit 1
+fi
+
+JNI_INCLUDE="$JAVA_HOME/include"
+JNI_INCLUDE_LINUX="$JAVA_HOME/include/linux"
+
+if [ ! -d "$JNI_INCLUDE" ]; then
+    echo "ERROR: JNI headers not found at $JNI_INCLUDE" >&2
+    exit 1
+fi
+
+# Get dbus-1 compiler flags
+DBUS_CFLAGS=$(pkg-config --cflags dbus-1)
+DBUS_LIBS=$(pkg-config --libs dbus-1)
+
+# Size and SHA-256 of a built library, read by core-runtime's NativeLibraryLoader
+# to find its extraction cache entry without hashing the library at runtime
+write_manifest() {
+    printf 'size=%s\nsha256=%s\n' "$(wc -c < "$1" | tr -d ' ')" "$(sha256sum "$1" | cut -d' ' -f1)" > "$1.manifest"
+}
+
+HOST_ARCH="$(uname -m)"
+
+COMMON_FLAGS=(
+    -shared
+    -fPIC
+    -DNUCLEUS_LINUX_COMBINED
+    -I"$JNI_INCLUDE" -I"$JNI_INCLUDE_LINUX" -I"$SCRIPT_DIR"
+    -I"$ROOT_DIR/core-runtime/src/main/native/include"
+    $DBUS_CFLAGS
+    -O2
+    -fvisibility=hidden
+    -ffunction-sections
+    -fdata-sections
+    -Wl,--gc-sections
+    -s
+    -Wall -Wextra -Wno-unused-parameter
+)
+LIBS=(-lX11 -lXext $DBUS_LIBS -lpthread -ldl)
+
+# build <compiler> <output dir>
+build() {
+    mkdir -p "$2"
+    "$1" "${COMMON_FLAGS[@]}" -o "$2/$LIB_NAME" "${SRCS[@]}" "${LIBS[@]}"
+    write_manifest "$2/$LIB_NAME"
+    ls -lh "$2/$LIB_NAME"
+}
+
+# Build for the host architecture
+if [ "$HOST_ARCH" = "x86_64" ]; then
+    echo "Building x64:"
+    build gcc "$OUT_DIR_X64"
+elif [ "$HOST_ARCH" = "aarch64" ]; then
+    echo "Building aarch64:"
+    build gcc "$OUT_DIR_AARCH64"
+else
+    echo "WARNING: Unsupported host architecture: $HOST_ARCH" >&2
+    exit 1
+fi
+
+# Attempt cross-compilation for the other architecture (optional, non-fatal)
+if [ "$HOST_ARCH" = "x86_64" ]; then
+    if command -v aarch64-linux-gnu-gcc &>/dev/null; then
+        echo "Building aarch64 (cross):"
+        build aarch64-linux-gnu-gcc "$OUT_DIR_AARCH64" || \
+            echo "WARNING: aarch64 cross-compilation failed (non-fatal)."
+    else
+        echo "NOTE: aarch64-linux-gnu-gcc not found, skipping aarch64 cross-build."
+    fi
+elif [ "$HOST_ARCH" = "aarch64" ]; then
+    if command -v x86_64-linux-gnu-gcc &>/dev/null; then
+        echo "Building x64 (cross):"
+        build x86_64-linux-gnu-gcc "$OUT_DIR_X64" || \
+            echo "WARNING: x64 cross-compilation failed (non-fatal)."
+    else
+        echo "NOTE: x86_64-linux-gnu-gcc not found, skipping x64 cross-build."
+    fi
+fi
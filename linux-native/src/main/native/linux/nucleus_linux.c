@@ -0,0 +1,113 @@
+/**
+ * libnucleus_linux: the theme (darkmode-detector), window (decorated-window-jni)
+ * and HiDPI (linux-hidpi) bridges linked into one shared library.
+ *
+ * Each bridge source is compiled unchanged apart from -DNUCLEUS_LINUX_COMBINED,
+ * which renames its JNI_OnLoad to nucleus_<module>_OnLoad. The single
+ * JNI_OnLoad below only records the JavaVM: a module is initialised when its
+ * bridge class loads and asks core-runtime's NativeLibraryLoader for its
+ * library, through LinuxNativeBundle.nativeInitModule. Module initialisation
+ * therefore happens at the same point as with the separate libraries, which
+ * matters for the window module (it resolves AWT's XToolkit, which must not
+ * start before the HiDPI module has set GDK_SCALE).
+ *
+ * Shared connections:
+ *   - One request/reply X connection (nucleus_shared_display) serves the
+ *     HiDPI startup probe, the HiDPI monitor geometry query and the window
+ *     commands, so the connection opened by the startup probe is the one
+ *     window commands use later. Event watchers keep their own connections:
+ *     their threads block in poll on them.
+ *   - D-Bus is only used by the theme module, which already keeps a single
+ *     connection (the monitor's) while observing.
+ *
+ * Linked libraries: -lX11 -lXext -ldbus-1 -lpthread -ldl
+ */
+
+#include <jni.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <X11/Xlib.h>
+
+#include "nucleus_linux_combined.h"
+
+/* ------------------------------------------------------------------ */
+/*  Shared X connection                                                */
+/* ------------------------------------------------------------------ */
+pthread_mutex_t nucleus_display_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static Display *g_sharedDisplay = NULL;
+static int      g_sharedDisplayState = 0;   /* 0 = not tried, 1 = open, -1 = unavailable */
+
+void *nucleus_shared_display(void) {
+    if (g_sharedDisplayState == 0) {
+        g_sharedDisplay = XOpenDisplay(NULL);
+        g_sharedDisplayState = g_sharedDisplay ? 1 : -1;
+    }
+    return g_sharedDisplay;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Modules                                                            */
+/*  Keyed by the library name each bridge passes to                    */
+/*  NativeLibraryLoader.load (LinuxNativeBundle.MODULES).              */
+/* ------------------------------------------------------------------ */
+typedef struct {
+    const char *library;
+    jint      (*onLoad)(JavaVM *, void *);
+    void      (*onUnload)(JavaVM *, void *);
+    atomic_int  initialised;
+} Module;
+
+static Module MODULES[] = {
+    { "nucleus_linux_theme",     nucleus_theme_OnLoad,  nucleus_theme_OnUnload, 0 },
+    { "nucleus_linux_jni",       nucleus_window_OnLoad, NULL,                   0 },
+    { "nucleus_linux_hidpi_jni", nucleus_hidpi_OnLoad,  NULL,                   0 },
+};
+#define MODULE_COUNT (int)(sizeof(MODULES) / sizeof(MODULES[0]))
+
+static JavaVM *g_jvm = NULL;
+
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved) {
+    (void)reserved;
+    g_jvm = vm;
+    return JNI_VERSION_1_8;
+}
+
+JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved) {
+    for (int i = 0; i < MODULE_COUNT; i++) {
+        if (atomic_exchange(&MODULES[i].initialised, 0) && MODULES[i].onUnload) {
+            MODULES[i].onUnload(vm, reserved);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  nativeInitModule — JNI entry point                                 */
+/*  Runs the module's initialiser once, on the thread loading its      */
+/*  bridge class. No lock is held meanwhile: initialisers call into    */
+/*  Java (class loading, AWT), which may load another module.          */
+/*  Returns false for a library this build lacks.                      */
+/* ------------------------------------------------------------------ */
+JNIEXPORT jboolean JNICALL
+Java_io_github_kdroidfilter_nucleus_core_runtime_LinuxNativeBundle_nativeInitModule(
+    JNIEnv *env, jclass clazz, jstring library)
+{
+    (void)clazz;
+    const char *name = library ? (*env)->GetStringUTFChars(env, library, NULL) : NULL;
+    if (!name) return JNI_FALSE;
+
+    jboolean found = JNI_FALSE;
+    for (int i = 0; i < MODULE_COUNT; i++) {
+        if (strcmp(MODULES[i].library, name) != 0) continue;
+        int expected = 0;
+        if (atomic_compare_exchange_strong(&MODULES[i].initialised, &expected, 1)) {
+            MODULES[i].onLoad(g_jvm, NULL);
+        }
+        found = JNI_TRUE;
+        break;
+    }
+
+    (*env)->ReleaseStringUTFChars(env, library, name);
+    return found;
+}
@@ -0,0 +1,31 @@
+/**
+ * Shared state of libnucleus_linux, the combined build of the Linux bridges
+ * (see nucleus_linux.c). The bridge sources include this header only when
+ * compiled with -DNUCLEUS_LINUX_COMBINED.
+ */
+
+#ifndef NUCLEUS_LINUX_COMBINED_H
+#define NUCLEUS_LINUX_COMBINED_H
+
+#include <jni.h>
+#include <pthread.h>
+
+/* Guards every request on the shared display */
+extern pthread_mutex_t nucleus_display_lock;
+
+/* The request/reply connection to $DISPLAY used by all modules, opened on
+ * first use and kept for the life of the process (never XCloseDisplay it).
+ * Call with nucleus_display_lock held. NULL when no X server is reachable.
+ * $DISPLAY may differ from the server AWT connected to: the window module
+ * only adopts this connection when XDisplayString matches AWT's, and opens
+ * its own on AWT's display otherwise (openCommandDisplay). */
+void *nucleus_shared_display(void);
+
+/* The modules' JNI_OnLoad / JNI_OnUnload, renamed by their sources. Run by
+ * LinuxNativeBundle.nativeInitModule when the module's bridge class loads. */
+jint nucleus_theme_OnLoad(JavaVM *vm, void *reserved);
+void nucleus_theme_OnUnload(JavaVM *vm, void *reserved);
+jint nucleus_window_OnLoad(JavaVM *vm, void *reserved);
+jint nucleus_hidpi_OnLoad(JavaVM *vm, void *reserved);
+
+#endif
@@ -158,6 +158,14 @@
 -keep class io.github.kdroidfilter.nucleus.darkmodedetector.linux.NativeLinuxBridge {
     native <methods>;
     static void onThemeChanged(boolean);
+    static void onSettingsChanged(double[]);
+}
+
+# Nucleus linux-hidpi JNI
+# HiDpiLinuxBridge.onScaleChanged is looked up by name from native code (GetStaticMethodID)
+-keep class io.github.kdroidfilter.nucleus.hidpi.HiDpiLinuxBridge {
+    native <methods>;
+    static void onScaleChanged(double,double);
 }
 
 # Nucleus darkmode-detector JNI (Windows)
@@ -175,6 +183,14 @@
 -keep class io.github.kdroidfilter.nucleus.nativessl.windows.WindowsSslBridge {
     native <methods>;
 }
+
+# Nucleus linux-native combined library (module initialisation through core-runtime)
+-keep class io.github.kdroidfilter.nucleus.core.runtime.LinuxNativeBundle {
+    native <methods>;
+}
+
+# Nucleus native call statistics: JFR reads the event's field names and annotations
+-keep class io.github.kdroidfilter.nucleus.core.runtime.NativeCallEvent { *; }
 -dontwarn sun.misc.Unsafe
 -dontwarn sun.awt.**
 
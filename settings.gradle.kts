@@ -39,10 +39,12 @@ include(":native-http")
 include(":native-http-okhttp")
 include(":native-http-ktor")
 include(":linux-hidpi")
+include(":linux-native")
 include(":decorated-window-core")
 include(":decorated-window-jbr")
 include(":decorated-window-jni")
 include(":decorated-window-material")
 include(":graalvm-runtime")
 include(":jewel-sample")
+include(":benchmarks")
 includeBuild("plugin-build")